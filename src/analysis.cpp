@@ -0,0 +1,406 @@
+// fopen()
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include <math.h>   // exp()
+#include <stdio.h>
+#include <string.h>
+
+#include "analysis.h"
+#include "fen.h"
+#include "notation.h"
+#include "platform.h"
+
+//
+// --- Constants ---
+//
+
+// Scores past this count as won, so a mate in 3 turning into a mate in 5 or a +15 into a +12 costs nothing.
+const s32 ANALYSIS_SCORE_CAP = 1000;
+
+// Logistic slope of the expected score of a centipawn score, and the drops of it that make a bad move.
+const double EXPECTED_SCORE_SLOPE = 0.00368208;
+const double JUDGEMENT_THRESHOLDS[JUDGEMENT_COUNT] = { 0.0, 0.05, 0.10, 0.15 };
+
+const char *JUDGEMENT_NAGS[JUDGEMENT_COUNT] = { "", "$6", "$2", "$4" };
+const char *JUDGEMENT_NAMES[JUDGEMENT_COUNT] = { "", "Inaccuracy", "Mistake", "Blunder" };
+
+const int PGN_LINE_WIDTH = 79;
+
+//
+// --- Structs ---
+//
+struct Analysis_Job {
+    const Analysis_Options *options;
+    Game_Analysis *analysis;
+    const Position *positions;    // Before every move, and after the last one.
+    const u64 *keys;              // Of 'positions'.
+    Transposition_Table *tt;      // Shared by every worker.
+    std::atomic<s32> next_position;
+};
+
+struct Analysis_Worker {
+    Analysis_Job *job;
+    Searcher *searcher;
+};
+
+// Movetext written token by token, wrapped before a token that doesn't fit.
+struct Pgn_Writer {
+    FILE *file;
+    s32 column;
+};
+
+//
+// --- Helpers ---
+//
+static s32 cap_score(s32 score) {
+    if (score > ANALYSIS_SCORE_CAP)   return ANALYSIS_SCORE_CAP;
+    if (score < -ANALYSIS_SCORE_CAP)  return -ANALYSIS_SCORE_CAP;
+    return score;
+}
+
+static double expected_score(s32 score) {
+    return 1.0 / (1.0 + exp(-EXPECTED_SCORE_SLOPE * (double)cap_score(score)));
+}
+
+// Stops the search in progress as soon as the analysis is stopped, not just the ones after it.
+static void analysis_report_proc(void *data, const Search_Report *report) {
+    (void)report;
+    Analysis_Worker *worker = (Analysis_Worker *)data;
+    if (worker->job->analysis->stop.load(std::memory_order_relaxed))  stop_search(worker->searcher);
+}
+
+static bool setup_analysis_worker(void *data, s32 index, void *job_data) {
+    Analysis_Worker *worker = (Analysis_Worker *)data;
+    worker->job = (Analysis_Job *)job_data;
+    worker->searcher = create_searcher(worker->job->tt);
+    // Not 0, so no thread starts a new generation.
+    worker->searcher->thread_index = index + 1;
+    worker->searcher->report_proc = analysis_report_proc;
+    worker->searcher->report_data = worker;
+    return true;
+}
+
+static void cleanup_analysis_worker(void *data) {
+    Analysis_Worker *worker = (Analysis_Worker *)data;
+    destroy_searcher(worker->searcher);
+}
+
+static void analysis_worker_proc(void *data) {
+    ZoneScoped;
+
+    Analysis_Worker *worker = (Analysis_Worker *)data;
+    Analysis_Job *job = worker->job;
+    Game_Analysis *analysis = job->analysis;
+
+    Search_Limits limits = { };
+    limits.depth = job->options->depth;
+    limits.movetime = job->options->movetime;
+
+    for (;;) {
+        if (analysis->stop.load(std::memory_order_relaxed))  break;
+        s32 index = job->next_position.fetch_sub(1);
+        if (index < 0)  break;
+
+        clear_stop_request(worker->searcher);
+        Search_Result search = search_position(worker->searcher, &job->positions[index], &limits, job->keys, index);
+
+        Position_Analysis *result = &analysis->positions[index];
+        result->score = search.score;
+        result->best_move = search.best_move;
+        result->depth = search.depth;
+        result->nodes = search.nodes;
+        analysis->finished.fetch_add(1);
+    }
+}
+
+// Fills 'losses', 'judgements' and the per-color totals from the position scores.
+static void judge_moves(Game_Analysis *analysis, const Position *positions) {
+    mem_zero(analysis->judgement_counts, sizeof(analysis->judgement_counts));
+    s64 total_loss[2] = { };
+    s32 move_counts[2] = { };
+    analysis->nodes = 0;
+    For (analysis->move_count + 1)  analysis->nodes += analysis->positions[it].nodes;
+
+    For (analysis->move_count) {
+        const Position_Analysis *before = &analysis->positions[it];
+        const Position_Analysis *after = &analysis->positions[it + 1];
+        s32 color = positions[it].side_to_move;
+
+        s32 loss = 0;
+        s32 judgement = JUDGEMENT_NONE;
+        if (analysis->moves[it] != before->best_move) {
+            // Both for the side that moved.
+            s32 best = before->score;
+            s32 played = -after->score;
+            loss = cap_score(best) - cap_score(played);
+            if (loss < 0)  loss = 0;
+
+            double drop = expected_score(best) - expected_score(played);
+            for (s32 j = JUDGEMENT_COUNT - 1; j > JUDGEMENT_NONE; j--) {
+                if (drop >= JUDGEMENT_THRESHOLDS[j]) {
+                    judgement = j;
+                    break;
+                }
+            }
+        }
+        analysis->losses[it] = loss;
+        analysis->judgements[it] = (u8)judgement;
+        analysis->judgement_counts[color][judgement]++;
+        total_loss[color] += loss;
+        move_counts[color]++;
+    }
+
+    For (2)  analysis->average_loss[it] = (move_counts[it] > 0) ? (s32)(total_loss[it] / move_counts[it]) : 0;
+}
+
+static void write_token(Pgn_Writer *writer, const char *text) {
+    s32 size = (s32)strlen(text);
+    if (writer->column > 0 && writer->column + 1 + size > PGN_LINE_WIDTH) {
+        fputc('\n', writer->file);
+        writer->column = 0;
+    }
+    if (writer->column > 0) {
+        fputc(' ', writer->file);
+        writer->column++;
+    }
+    fputs(text, writer->file);
+    writer->column += size;
+}
+
+// From White's side, "+0.31" or "#-3"; empty for a position that is already mate.
+static void format_eval(const Position *pos, const Position_Analysis *result, char *buffer, s32 buffer_size) {
+    buffer[0] = 0;
+    if (result->best_move == MOVE_NONE && result->score == -SCORE_MATE)  return;
+
+    // The mate distance comes from the side to move's score, only its sign is turned to White's side.
+    s32 sign = (pos->side_to_move == WHITE) ? 1 : -1;
+    if (is_mate_score(result->score)) snprintf(buffer, buffer_size, "#%d", sign * mate_in_moves(result->score));
+    else                              snprintf(buffer, buffer_size, "%.2f", (double)(sign * result->score) / 100.0);
+}
+
+static const char *result_text(s32 result) {
+    switch (result) {
+        case RESULT_WHITE_WIN: return "1-0";
+        case RESULT_BLACK_WIN: return "0-1";
+        case RESULT_DRAW:      return "1/2-1/2";
+    }
+    return "*";
+}
+
+static s32 final_result(const Position *pos) {
+    Move_List legal;
+    generate_legal_moves(pos, &legal);
+    if (legal.count > 0)  return RESULT_UNKNOWN;
+    if (!in_check(pos))   return RESULT_DRAW;
+    return (pos->side_to_move == WHITE) ? RESULT_BLACK_WIN : RESULT_WHITE_WIN;
+}
+
+static void print_summary(const Game_Analysis *analysis) {
+    static const char *COLOR_NAMES[2] = { "White", "Black" };
+    For (2) {
+        const s32 *counts = analysis->judgement_counts[it];
+        fprintf(stderr, "%s: %d inaccuracies, %d mistakes, %d blunders, average loss %d cp\n", COLOR_NAMES[it],
+                counts[JUDGEMENT_INACCURACY], counts[JUDGEMENT_MISTAKE], counts[JUDGEMENT_BLUNDER], analysis->average_loss[it]);
+    }
+}
+
+//
+// --- Interface ---
+//
+bool analyze_game(const Analysis_Options *options, Game_Analysis *analysis) {
+    ZoneScoped;
+
+    if (analysis->move_count < 0 || analysis->move_count > ANALYSIS_MAX_PLIES) {
+        fprintf(stderr, "ERROR: Can't analyze a game of %d plies!\n", analysis->move_count);
+        return false;
+    }
+
+    s32 position_count = analysis->move_count + 1;
+    Position *positions = ALLOC(sys_allocator, position_count, Position);
+    u64 *keys = ALLOC(sys_allocator, position_count, u64);
+    defer {
+        FREE(sys_allocator, positions);
+        FREE(sys_allocator, keys);
+    };
+    positions[0] = analysis->start;
+    For (analysis->move_count) {
+        positions[it + 1] = positions[it];
+        Undo_Info undo;
+        make_move(&positions[it + 1], analysis->moves[it], &undo);
+    }
+    For (position_count)  keys[it] = positions[it].key;
+
+    s32 thread_count = (options->threads > 0) ? options->threads : get_cpu_count();
+    if (thread_count > ANALYSIS_MAX_THREADS)  thread_count = ANALYSIS_MAX_THREADS;
+    if (thread_count > position_count)        thread_count = position_count;
+
+    Transposition_Table tt;
+    if (!tt_init(&tt, options->hash_megabytes))  return false;
+    defer { tt_free(&tt); };
+    // One search generation for the whole game, so every thread keeps what the others stored.
+    tt_new_search(&tt);
+
+    Analysis_Job job;
+    job.options = options;
+    job.analysis = analysis;
+    job.positions = positions;
+    job.keys = keys;
+    job.tt = &tt;
+    job.next_position.store(analysis->move_count);
+    mem_zero(analysis->positions, sizeof(analysis->positions));
+    analysis->finished.store(0);
+
+    Worker_Pool pool;
+    if (!create_worker_pool(&pool, thread_count, sizeof(Analysis_Worker), setup_analysis_worker, cleanup_analysis_worker, &job))  return false;
+    defer { destroy_worker_pool(&pool); };
+
+    u64 start_time = get_time_microseconds();
+    run_worker_pool(&pool, analysis_worker_proc);
+    analysis->time = get_time_microseconds() - start_time;
+
+    if (analysis->stop.load())  return false;
+    judge_moves(analysis, positions);
+    return true;
+}
+
+void write_annotated_pgn(FILE *file, const Game_Analysis *analysis, const Pgn_Tag *tags, s32 tag_count, s32 result) {
+    Position pos = analysis->start;
+    Position end = pos;
+    For (analysis->move_count) {
+        Undo_Info undo;
+        make_move(&end, analysis->moves[it], &undo);
+    }
+    if (result == RESULT_UNKNOWN)  result = final_result(&end);
+
+    char start_fen[FEN_MAX_SIZE];
+    position_to_fen(&pos, start_fen);
+    bool standard_start = strcmp(start_fen, START_FEN) == 0;
+
+    bool has_annotator = false;
+    if (tag_count > 0) {
+        For (tag_count) {
+            const Pgn_Tag *tag = &tags[it];
+            fprintf(file, "[%.*s \"%.*s\"]\n", tag->name_size, tag->name, tag->value_size, tag->value);
+            if (tag->name_size == 9 && memcmp(tag->name, "Annotator", 9) == 0)  has_annotator = true;
+        }
+    } else {
+        fprintf(file, "[Event \"?\"]\n[Site \"?\"]\n[Date \"????.??.??\"]\n[Round \"?\"]\n[White \"?\"]\n[Black \"?\"]\n");
+        fprintf(file, "[Result \"%s\"]\n", result_text(result));
+        if (!standard_start)  fprintf(file, "[SetUp \"1\"]\n[FEN \"%s\"]\n", start_fen);
+    }
+    if (!has_annotator) {
+        fprintf(file, "[Annotator \"pawn, depth %d\"]\n", analysis->positions[0].depth);
+    }
+    fprintf(file, "\n");
+
+    Pgn_Writer writer = { file, 0 };
+    char text[128];
+    For (analysis->move_count) {
+        Move move = analysis->moves[it];
+        if (pos.side_to_move == WHITE || it == 0) {
+            snprintf(text, sizeof(text), (pos.side_to_move == WHITE) ? "%d." : "%d...", pos.fullmove_number);
+            write_token(&writer, text);
+        }
+
+        char san[MOVE_TEXT_SIZE];
+        move_to_san(&pos, move, san);
+        write_token(&writer, san);
+
+        s32 judgement = analysis->judgements[it];
+        char best[MOVE_TEXT_SIZE] = { };
+        if (judgement != JUDGEMENT_NONE) {
+            write_token(&writer, JUDGEMENT_NAGS[judgement]);
+            move_to_san(&pos, analysis->positions[it].best_move, best);
+        }
+
+        Undo_Info undo;
+        make_move(&pos, move, &undo);
+
+        char eval[16];
+        format_eval(&pos, &analysis->positions[it + 1], eval, sizeof(eval));
+        if (judgement != JUDGEMENT_NONE) {
+            if (eval[0])  snprintf(text, sizeof(text), "{ [%%eval %s] %s. %s was best. }", eval, JUDGEMENT_NAMES[judgement], best);
+            else          snprintf(text, sizeof(text), "{ %s. %s was best. }", JUDGEMENT_NAMES[judgement], best);
+            write_token(&writer, text);
+        } else if (eval[0]) {
+            snprintf(text, sizeof(text), "{ [%%eval %s] }", eval);
+            write_token(&writer, text);
+        }
+    }
+    write_token(&writer, result_text(result));
+    fprintf(file, "\n\n");
+}
+
+bool save_annotated_pgn(const char *filepath, const Game_Analysis *analysis) {
+    FILE *file = fopen(filepath, "wb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Couldn't create '%s' PGN file!\n", filepath);
+        return false;
+    }
+    write_annotated_pgn(file, analysis, NULL, 0, RESULT_UNKNOWN);
+    fclose(file);
+    return true;
+}
+
+bool analyze_pgn_file(const Analysis_Options *options) {
+    ZoneScoped;
+
+    Mapped_File mapped;
+    if (!map_file(options->pgn_filepath, &mapped))  return false;
+    defer { unmap_file(&mapped); };
+
+    FILE *file = stdout;
+    if (options->output_filepath) {
+        file = fopen(options->output_filepath, "wb");
+        if (!file) {
+            fprintf(stderr, "ERROR: Couldn't create '%s' PGN file!\n", options->output_filepath);
+            return false;
+        }
+    }
+    defer { if (file != stdout)  fclose(file); };
+
+    Pgn_Game *game = ALLOC(sys_allocator, 1, Pgn_Game);
+    Game_Analysis *analysis = ALLOC(sys_allocator, 1, Game_Analysis);
+    defer {
+        FREE(sys_allocator, game);
+        FREE(sys_allocator, analysis);
+    };
+
+    const char *text = (const char *)mapped.data;
+    s64 size = (s64)mapped.size;
+    s64 offset = pgn_next_game_start(text, size, 0);
+    s32 game_index = 0;
+    bool ok = true;
+    while (offset < size) {
+        const char *next = pgn_parse_game(text + offset, text + size, game, ANALYSIS_MAX_PLIES);
+        offset = pgn_next_game_start(text, size, next - text);
+        game_index++;
+        if (game->parse_error) {
+            fprintf(stderr, "Skipped game %d, its moves couldn't be read.\n", game_index);
+            continue;
+        }
+        if (game->truncated) {
+            fprintf(stderr, "Skipped game %d, longer than %d plies.\n", game_index, ANALYSIS_MAX_PLIES);
+            continue;
+        }
+
+        mem_zero(analysis, sizeof(Game_Analysis));
+        set_start_position(&analysis->start);
+        analysis->move_count = game->move_count;
+        For (game->move_count)  analysis->moves[it] = game->moves[it];
+
+        fprintf(stderr, "Game %d, %d plies...\n", game_index, game->move_count);
+        if (!analyze_game(options, analysis)) {
+            ok = false;
+            break;
+        }
+        write_annotated_pgn(file, analysis, game->tags, game->tag_count, game->result);
+        fflush(file);
+        print_summary(analysis);
+        fprintf(stderr, "%.3f s, %llu nodes\n", (double)analysis->time / 1000000.0, (unsigned long long)analysis->nodes);
+    }
+    if (game_index == 0 && size > 0) {
+        fprintf(stderr, "WARNING: No games found in '%s', they have to start with a tag line!\n", options->pgn_filepath);
+    }
+    return ok;
+}
@@ -0,0 +1,87 @@
+#ifndef PAWN_ANALYSIS_H
+#define PAWN_ANALYSIS_H
+
+#include <stdio.h>
+
+#include <atomic>
+
+#include "pgn.h"
+#include "search.h"
+
+//
+// --- Constants ---
+//
+const int ANALYSIS_MAX_PLIES = PGN_MAX_GAME_PLIES;
+const int ANALYSIS_MAX_THREADS = 256;
+const s32 ANALYSIS_DEFAULT_DEPTH = 14;
+const s64 ANALYSIS_DEFAULT_HASH = 256;
+
+//
+// --- Enums ---
+//
+
+// By how much the move lowered its side's expected score against the best move.
+enum Move_Judgement {
+    JUDGEMENT_NONE = 0,
+    JUDGEMENT_INACCURACY = 1,     // ?!
+    JUDGEMENT_MISTAKE = 2,        // ?
+    JUDGEMENT_BLUNDER = 3,        // ??
+    JUDGEMENT_COUNT = 4
+};
+
+//
+// --- Structs ---
+//
+struct Analysis_Options {
+    const char *pgn_filepath;     // For 'analyze_pgn_file()'.
+    const char *output_filepath;  // NULL writes the annotated PGN to stdout.
+    s32 depth;                    // Fixed depth per position, or 0.
+    s64 movetime;                 // Fixed milliseconds per position, or 0.
+    s32 threads;                  // Positions searched at once, all sharing one table. 0 uses every core.
+    s64 hash_megabytes;           // Of the shared table.
+};
+
+// Search of the position before move 'i', or after the last move for 'i == move_count'.
+struct Position_Analysis {
+    s32 score;                    // For the side to move.
+    Move best_move;
+    s32 depth;
+    u64 nodes;
+};
+
+struct Game_Analysis {
+    Position start;
+    Move moves[ANALYSIS_MAX_PLIES];
+    s32 move_count;
+
+    Position_Analysis positions[ANALYSIS_MAX_PLIES + 1];
+    s32 losses[ANALYSIS_MAX_PLIES];           // Centipawns move 'i' gave away against the best move, for its side.
+    u8 judgements[ANALYSIS_MAX_PLIES];        // Move_Judgement.
+    s32 judgement_counts[2][JUDGEMENT_COUNT]; // By color.
+    s32 average_loss[2];                      // Centipawns per move, by color.
+    u64 nodes;
+    u64 time;                                 // Microseconds, wall clock.
+
+    std::atomic<s32> finished;                // Positions searched so far, for showing progress.
+    std::atomic<bool> stop;                   // Set from any thread to skip the positions not started yet.
+};
+
+//
+// --- Functions ---
+//
+
+// Searches every position of the game, from 'analysis->start' through 'analysis->moves', on
+// 'options->threads' threads sharing one table. The last positions go first, so the earlier ones find
+// the lines the game took already in the table. Then judges every move by what it lost.
+bool analyze_game(const Analysis_Options *options, Game_Analysis *analysis);
+
+// The game with a "[%eval]" comment after every move and the NAG and best move after the bad ones.
+// Writes 'tags' as they are, or a Seven Tag Roster when there are none. 'result' is a Game_Result,
+// RESULT_UNKNOWN takes it from the final position.
+void write_annotated_pgn(FILE *file, const Game_Analysis *analysis, const Pgn_Tag *tags, s32 tag_count, s32 result);
+bool save_annotated_pgn(const char *filepath, const Game_Analysis *analysis);
+
+// Analyzes the games of 'options->pgn_filepath' one after another and writes them annotated.
+bool analyze_pgn_file(const Analysis_Options *options);
+
+#endif /* PAWN_ANALYSIS_H */
@@ -0,0 +1,164 @@
+#include <stdio.h>
+
+#include "bench.h"
+#include "fen.h"
+#include "movegen.h"
+#include "platform.h"
+#include "search.h"
+
+//
+// --- Tables ---
+//
+
+// Openings, middlegames and endgames, a few mates and stalemates among them. Changing the list changes
+// the signature.
+const char *BENCH_POSITIONS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3",
+    "rnbqkb1r/pp1p1ppp/4pn2/2p5/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 0 4",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 11",
+    "4rrk1/pp1n3p/3q2pQ/2p1pb2/2PP4/2P3N1/P2B2PP/4RRK1 b - - 7 19",
+    "rq3rk1/ppp2ppp/1bnpb3/3N2B1/3NP3/7P/PPPQ1PP1/2KR3R w - - 7 14",
+    "r1bq1r1k/1pp1n1pp/1p1p4/4p2Q/4Pp2/1BNP4/PPP2PPP/3R1RK1 w - - 2 14",
+    "r3r1k1/2p2ppp/p1p1bn2/8/1q2P3/2NPQN2/PPP3PP/R4RK1 b - - 2 15",
+    "r1bbk1nr/pp3p1p/2n5/1N4p1/2Np1B2/8/PPP2PPP/2KR1B1R w kq - 0 13",
+    "r1bq1rk1/ppp1nppp/4n3/3p3Q/3P4/1BP1B3/PP1N2PP/R4RK1 w - - 1 16",
+    "4r1k1/r1q2ppp/ppp2n2/4P3/5Rb1/1N1BQ3/PPP3PP/R5K1 w - - 1 17",
+    "2rqkb1r/ppp2p2/2npb1p1/1N1Nn2p/2P1PP2/8/PP2B1PP/R1BQK2R b KQ - 0 11",
+    "r1bq1r1k/b1p1npp1/p2p3p/1p6/3PP3/1B2NN2/PP3PPP/R2Q1RK1 w - - 1 16",
+    "3r1rk1/p5pp/bpp1pp2/8/q1PP1P2/b3P3/P2NQRPP/1R2B1K1 b - - 6 22",
+    "r1q2rk1/2p1bppp/2Pp4/p6b/Q1PNp3/4B3/PP1R1PPP/2K4R w - - 2 18",
+    "4k2r/1pb2ppp/1p2p3/1R1p4/3P4/2r1PN2/P4PPP/1R4K1 b - - 3 22",
+    "3q2k1/pb3p1p/4pbp1/2r5/PpN2N2/1P2P2P/5PP1/Q2R2K1 b - - 4 26",
+    "5rk1/q6p/2p3bR/1pPp1rP1/1P1Pp3/P3B1Q1/1K3P2/R7 w - - 93 90",
+    "4rrk1/1p1nq3/p7/2p1P1pp/3P2bp/3Q1Bn1/PPPB4/1K2R1NR w - - 40 21",
+    "r3k2r/3nnpbp/q2pp1p1/p7/Pp1PPPP1/4BNN1/1P5P/R2Q1RK1 w kq - 0 16",
+    "3Qb1k1/1r2ppb1/pN1n2q1/Pp1Pp1Pr/4P2p/4BP2/4B1R1/1R5K b - - 11 40",
+    "4k3/3q1r2/1N2r1b1/3ppN2/2nPP3/1B1R2n1/2R1Q3/3K4 w - - 5 1",
+    "1r3k2/4q3/2Pp3b/3Bp3/2Q2p2/1p1P2P1/1P2KP2/3N4 w - - 0 1",
+    "6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
+    "6k1/6p1/P6p/r1N5/5p2/7P/1b3PP1/4R1K1 w - - 0 1",
+    "6k1/6p1/6Pp/ppp5/3pn2P/1P3K2/1PP2P2/3N4 b - - 0 1",
+    "3b4/5kp1/1p1p1p1p/pP1PpP1P/P1P1P3/3KN3/8/8 w - - 0 1",
+    "2K5/p7/7P/5pR1/8/5k2/r7/8 w - - 0 1",
+    "8/6pk/1p6/8/PP3p1p/5P2/4KP1q/3Q4 w - - 0 1",
+    "7k/3p2pp/4q3/8/4Q3/5Kp1/P6b/8 w - - 0 1",
+    "8/2p5/8/2kPKp1p/2p4P/2P5/3P4/8 w - - 0 1",
+    "8/1p3pp1/7p/5P1P/2k3P1/8/2K2P2/8 w - - 0 1",
+    "8/pp2r1k1/2p1p3/3pP2p/1P1P1P1P/P5KR/8/8 w - - 0 1",
+    "8/3p4/p1bk3p/Pp6/1Kp1PpPp/2P2P1P/2P5/5B2 b - - 0 1",
+    "5k2/7R/4P2p/5K2/p1r2P1p/8/8/8 b - - 0 1",
+    "8/3p3B/5p2/5P2/p7/PP5b/k7/6K1 w - - 0 1",
+    "8/8/8/8/5kp1/P7/8/1K1N4 w - - 0 1",
+    "8/8/8/5N2/8/p7/8/2NK3k w - - 0 1",
+    "8/3k4/8/8/8/4B3/4KB2/2B5 w - - 0 1",
+    "8/8/1P6/5pr1/8/4R3/7k/2K5 w - - 0 1",
+    "8/2p4P/8/kr6/6R1/8/8/1K6 w - - 0 1",
+    "8/8/3P3k/8/1p6/8/1P6/1K3n2 b - - 0 1",
+    "8/R7/2q5/8/6k1/8/1P5p/K6R w - - 0 124",
+    "6k1/3b3r/1p1p4/p1n2p2/1PPNpP1q/P3Q1p1/1R1RB1P1/5K2 b - - 0 1",
+    "r2r1n2/pp2bk2/2p1p2p/3q4/3PN1QP/2P3R1/P4PP1/5RK1 w - - 0 1",
+    "8/8/8/8/8/6k1/6p1/6K1 w - - 0 1",
+    "7k/7P/6K1/8/3B4/8/8/8 b - - 0 1",
+};
+const s32 BENCH_POSITION_COUNT = (s32)(sizeof(BENCH_POSITIONS) / sizeof(BENCH_POSITIONS[0]));
+
+// Positions with their known perft counts for depths 1 to 5.
+struct Perft_Case {
+    const char *fen;
+    u64 nodes[5];
+};
+
+static const Perft_Case PERFT_CASES[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",             { 20, 400, 8902, 197281, 4865609 } },
+    { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", { 48, 2039, 97862, 4085603, 193690690 } },
+    { "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",                            { 14, 191, 2812, 43238, 674624 } },
+    { "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",     { 6, 264, 9467, 422333, 15833292 } },
+    { "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",            { 44, 1486, 62379, 2103487, 89941194 } },
+    { "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", { 46, 2079, 89890, 3894594, 164075551 } },
+};
+
+//
+// --- Interface ---
+//
+bool run_bench(s32 depth, s64 hash_megabytes, Bench_Result *out_result) {
+    ZoneScoped;
+
+    Transposition_Table tt;
+    if (!tt_init(&tt, hash_megabytes))  return false;
+    Searcher *searcher = create_searcher(&tt);
+    defer {
+        destroy_searcher(searcher);
+        tt_free(&tt);
+    };
+
+    Search_Limits limits = { };
+    limits.depth = depth;
+
+    Bench_Result result = { };
+    s32 count = BENCH_POSITION_COUNT;
+    For (count) {
+        Position pos;
+        if (!parse_fen(&pos, BENCH_POSITIONS[it])) {
+            fprintf(stderr, "ERROR: Invalid bench position '%s'!\n", BENCH_POSITIONS[it]);
+            return false;
+        }
+
+        tt_clear(&tt);
+        clear_searcher(searcher);
+        Search_Result search = search_position(searcher, &pos, &limits);
+        result.positions++;
+        result.nodes += search.nodes;
+        result.time += search.time;
+        fprintf(stderr, "Position %2d/%d: %10llu nodes  %s\n", it + 1, count, (unsigned long long)search.nodes, BENCH_POSITIONS[it]);
+    }
+
+    u64 nps = (result.time > 0) ? result.nodes * 1000000 / result.time : 0;
+    fprintf(stderr, "Depth %d, %.3f s\n", depth, (double)result.time / 1000000.0);
+    printf("%llu nodes %llu nps\n", (unsigned long long)result.nodes, (unsigned long long)nps);
+    fflush(stdout);
+
+    if (out_result)  *out_result = result;
+    return true;
+}
+
+bool run_perft(const char *fen, s32 depth) {
+    ZoneScoped;
+
+    if (fen) {
+        Position pos;
+        if (!parse_fen(&pos, fen)) {
+            fprintf(stderr, "ERROR: Invalid FEN '%s'!\n", fen);
+            return false;
+        }
+        u64 start_time = get_time_microseconds();
+        u64 nodes = perft(&pos, depth);
+        u64 time = get_time_microseconds() - start_time;
+        fprintf(stderr, "Depth %d, %.3f s\n", depth, (double)time / 1000000.0);
+        printf("%llu nodes\n", (unsigned long long)nodes);
+        return true;
+    }
+
+    s32 max_depth = (depth < 5) ? depth : 5;
+    s32 count = (s32)(sizeof(PERFT_CASES) / sizeof(PERFT_CASES[0]));
+    s32 failed = 0;
+    For (count) {
+        const Perft_Case *test = &PERFT_CASES[it];
+        Position pos;
+        if (!parse_fen(&pos, test->fen)) {
+            fprintf(stderr, "ERROR: Invalid perft position '%s'!\n", test->fen);
+            return false;
+        }
+        for (s32 d = 1; d <= max_depth; d++) {
+            u64 nodes = perft(&pos, d);
+            bool ok = nodes == test->nodes[d - 1];
+            if (!ok)  failed++;
+            printf("%-4s depth %d %12llu nodes  %s\n", ok ? "ok" : "FAIL", d, (unsigned long long)nodes, test->fen);
+        }
+    }
+    printf("%d mismatches\n", failed);
+    return failed == 0;
+}
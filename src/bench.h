@@ -0,0 +1,41 @@
+#ifndef PAWN_BENCH_H
+#define PAWN_BENCH_H
+
+#include "common.h"
+
+//
+// --- Constants ---
+//
+const s32 BENCH_DEFAULT_DEPTH = 10;
+const s64 BENCH_DEFAULT_HASH = 16;
+
+//
+// --- Structs ---
+//
+struct Bench_Result {
+    s32 positions;
+    u64 nodes;
+    u64 time;             // Microseconds, searching only.
+};
+
+//
+// --- Globals ---
+//
+extern const char *BENCH_POSITIONS[];
+extern const s32 BENCH_POSITION_COUNT;
+
+//
+// --- Functions ---
+//
+
+// Searches the built-in positions one after another to 'depth' on a single thread, each from a cleared
+// table and history, so the node count is a signature that changes only when the search does. Prints a
+// line per position to stderr and "<nodes> nodes <nps> nps" to stdout.
+bool run_bench(s32 depth, s64 hash_megabytes, Bench_Result *out_result = NULL);
+
+// Counts the leaves of the move tree of 'fen' to 'depth' and prints them. Without a FEN, checks the
+// move generator against the published counts of a few positions with castling, en passant and
+// promotion traps, up to 'depth' plies; false on any difference.
+bool run_perft(const char *fen, s32 depth);
+
+#endif /* PAWN_BENCH_H */
@@ -0,0 +1,164 @@
+#include <stdio.h>
+
+#include "bitboard.h"
+
+Bitboard knight_attacks_table[SQUARE_COUNT];
+Bitboard king_attacks_table[SQUARE_COUNT];
+Bitboard pawn_attacks_table[2][SQUARE_COUNT];
+Bitboard between_table[SQUARE_COUNT][SQUARE_COUNT];
+Bitboard line_table[SQUARE_COUNT][SQUARE_COUNT];
+
+Magic bishop_magics[SQUARE_COUNT];
+Magic rook_magics[SQUARE_COUNT];
+
+// Sizes are the sums of 2^(mask bits) over all squares.
+static Bitboard bishop_attacks_storage[0x1480];
+static Bitboard rook_attacks_storage[0x19000];
+
+static const s32 ROOK_DIRECTIONS[4][2]   = { { 1, 0 }, { -1, 0 }, { 0, 1 }, { 0, -1 } };
+static const s32 BISHOP_DIRECTIONS[4][2] = { { 1, 1 }, { 1, -1 }, { -1, 1 }, { -1, -1 } };
+
+static bool on_board(s32 file, s32 rank) {
+    return file >= 0 && file < 8 && rank >= 0 && rank < 8;
+}
+
+// Slow ray walk, used only while building tables.
+static Bitboard sliding_attacks(s32 square, Bitboard occupied, const s32 directions[4][2]) {
+    Bitboard attacks = 0;
+    For (4 /*directions*/) {
+        s32 file = square_file(square) + directions[it][0];
+        s32 rank = square_rank(square) + directions[it][1];
+        while (on_board(file, rank)) {
+            Bitboard b = square_bb(make_square(file, rank));
+            attacks |= b;
+            if (occupied & b)  break;
+            file += directions[it][0];
+            rank += directions[it][1];
+        }
+    }
+    return attacks;
+}
+
+static Bitboard step_attacks(s32 square, const s32 (*steps)[2], s32 steps_count) {
+    Bitboard attacks = 0;
+    For (steps_count) {
+        s32 file = square_file(square) + steps[it][0];
+        s32 rank = square_rank(square) + steps[it][1];
+        if (on_board(file, rank))  attacks |= square_bb(make_square(file, rank));
+    }
+    return attacks;
+}
+
+// xorshift64* with a fixed seed so the found magics (and table layout) are reproducible.
+static u64 magic_random_state = 0x3C6EF372FE94F82AULL;
+
+static u64 magic_random() {
+    magic_random_state ^= magic_random_state >> 12;
+    magic_random_state ^= magic_random_state << 25;
+    magic_random_state ^= magic_random_state >> 27;
+    return magic_random_state * 0x2545F4914F6CDD1DULL;
+}
+
+static u64 sparse_random() {
+    return magic_random() & magic_random() & magic_random();
+}
+
+static void init_magics(Magic *magics, Bitboard *storage, const s32 directions[4][2]) {
+    Bitboard occupancies[4096];
+    Bitboard references[4096];
+    s32 epochs[4096] = { };
+    s32 epoch = 0;
+
+    Bitboard *attacks = storage;
+    For (SQUARE_COUNT) {
+        s32 square = it;
+        Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~(RANK_1_BB << (8 * square_rank(square))))
+                       | ((FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << square_file(square)));
+
+        Magic *m = &magics[square];
+        m->mask = sliding_attacks(square, 0, directions) & ~edges;
+        m->shift = 64 - popcount(m->mask);
+        m->attacks = attacks;
+
+        // Enumerate all subsets of the mask (Carry-Rippler trick).
+        s32 size = 0;
+        Bitboard subset = 0;
+        do {
+            occupancies[size] = subset;
+            references[size] = sliding_attacks(square, subset, directions);
+            size++;
+            subset = (subset - m->mask) & m->mask;
+        } while (subset);
+
+        for (;;) {
+            do {
+                m->magic = sparse_random();
+            } while (popcount((m->mask * m->magic) >> 56) < 6);
+
+            epoch++;
+            bool failed = false;
+            for (s32 i = 0; i < size; i++) {
+                u64 index = (occupancies[i] * m->magic) >> m->shift;
+                if (epochs[index] < epoch) {
+                    epochs[index] = epoch;
+                    attacks[index] = references[i];
+                } else if (attacks[index] != references[i]) {
+                    failed = true;
+                    break;
+                }
+            }
+            if (!failed)  break;
+        }
+
+        attacks += size;
+    }
+}
+
+void init_bitboards() {
+    ZoneScoped;
+
+    static bool initialized = false;
+    if (initialized)  return;
+    initialized = true;
+
+    const s32 knight_steps[8][2] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+    const s32 king_steps[8][2]   = { { 1, 0 }, { 1, 1 }, { 0, 1 }, { -1, 1 }, { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 } };
+    const s32 white_pawn_steps[2][2] = { { -1, 1 }, { 1, 1 } };
+    const s32 black_pawn_steps[2][2] = { { -1, -1 }, { 1, -1 } };
+
+    For (SQUARE_COUNT) {
+        knight_attacks_table[it] = step_attacks(it, knight_steps, 8);
+        king_attacks_table[it] = step_attacks(it, king_steps, 8);
+        pawn_attacks_table[WHITE][it] = step_attacks(it, white_pawn_steps, 2);
+        pawn_attacks_table[BLACK][it] = step_attacks(it, black_pawn_steps, 2);
+    }
+
+    init_magics(bishop_magics, bishop_attacks_storage, BISHOP_DIRECTIONS);
+    init_magics(rook_magics, rook_attacks_storage, ROOK_DIRECTIONS);
+
+    for (s32 from = 0; from < SQUARE_COUNT; from++) {
+        for (s32 to = 0; to < SQUARE_COUNT; to++) {
+            between_table[from][to] = 0;
+            line_table[from][to] = 0;
+            if (from == to)  continue;
+
+            if (bishop_attacks(from, 0) & square_bb(to)) {
+                between_table[from][to] = bishop_attacks(from, square_bb(to)) & bishop_attacks(to, square_bb(from));
+                line_table[from][to] = (bishop_attacks(from, 0) & bishop_attacks(to, 0)) | square_bb(from) | square_bb(to);
+            } else if (rook_attacks(from, 0) & square_bb(to)) {
+                between_table[from][to] = rook_attacks(from, square_bb(to)) & rook_attacks(to, square_bb(from));
+                line_table[from][to] = (rook_attacks(from, 0) & rook_attacks(to, 0)) | square_bb(from) | square_bb(to);
+            }
+        }
+    }
+}
+
+void print_bitboard(Bitboard b) {
+    for (s32 rank = 7; rank >= 0; rank--) {
+        for (s32 file = 0; file < 8; file++) {
+            printf("%c ", (b & square_bb(make_square(file, rank))) ? 'X' : '.');
+        }
+        printf("\n");
+    }
+    printf("\n");
+}
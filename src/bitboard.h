@@ -0,0 +1,137 @@
+#ifndef PAWN_BITBOARD_H
+#define PAWN_BITBOARD_H
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "common.h"
+
+//
+// --- Types ---
+//
+typedef u64 Bitboard;
+
+//
+// --- Enums ---
+//
+enum Color {
+    WHITE = 0,
+    BLACK = 1
+};
+
+// Little-endian rank-file mapping: A1 = 0, B1 = 1, ..., H8 = 63.
+enum Square {
+    A1, B1, C1, D1, E1, F1, G1, H1,
+    A2, B2, C2, D2, E2, F2, G2, H2,
+    A3, B3, C3, D3, E3, F3, G3, H3,
+    A4, B4, C4, D4, E4, F4, G4, H4,
+    A5, B5, C5, D5, E5, F5, G5, H5,
+    A6, B6, C6, D6, E6, F6, G6, H6,
+    A7, B7, C7, D7, E7, F7, G7, H7,
+    A8, B8, C8, D8, E8, F8, G8, H8,
+    NO_SQUARE = 64
+};
+
+//
+// --- Constants ---
+//
+const int SQUARE_COUNT = 64;
+
+const Bitboard FILE_A_BB = 0x0101010101010101ULL;
+const Bitboard FILE_H_BB = FILE_A_BB << 7;
+const Bitboard RANK_1_BB = 0xFFULL;
+const Bitboard RANK_2_BB = RANK_1_BB << (8 * 1);
+const Bitboard RANK_4_BB = RANK_1_BB << (8 * 3);
+const Bitboard RANK_5_BB = RANK_1_BB << (8 * 4);
+const Bitboard RANK_7_BB = RANK_1_BB << (8 * 6);
+const Bitboard RANK_8_BB = RANK_1_BB << (8 * 7);
+
+//
+// --- Globals ---
+//
+extern Bitboard knight_attacks_table[SQUARE_COUNT];
+extern Bitboard king_attacks_table[SQUARE_COUNT];
+extern Bitboard pawn_attacks_table[2][SQUARE_COUNT];
+extern Bitboard between_table[SQUARE_COUNT][SQUARE_COUNT]; // Squares strictly between two aligned squares.
+extern Bitboard line_table[SQUARE_COUNT][SQUARE_COUNT];    // Full line through two aligned squares, edge to edge.
+
+struct Magic {
+    Bitboard mask;
+    Bitboard magic;
+    Bitboard *attacks;
+    u32 shift;
+};
+
+extern Magic bishop_magics[SQUARE_COUNT];
+extern Magic rook_magics[SQUARE_COUNT];
+
+//
+// --- Functions ---
+//
+void init_bitboards();
+
+inline Bitboard square_bb(s32 square)       { return 1ULL << square; }
+inline s32 make_square(s32 file, s32 rank)  { return rank * 8 + file; }
+inline s32 square_file(s32 square)          { return square & 7; }
+inline s32 square_rank(s32 square)          { return square >> 3; }
+inline s32 relative_rank(s32 color, s32 square) { return (color == WHITE) ? square_rank(square) : 7 - square_rank(square); }
+inline bool more_than_one(Bitboard b)       { return (b & (b - 1)) != 0; }
+
+#if defined(_MSC_VER) && defined(_M_X64)
+inline s32 popcount(Bitboard b) { return (s32)__popcnt64(b); }
+inline s32 lsb(Bitboard b) { unsigned long index; _BitScanForward64(&index, b); return (s32)index; }
+inline s32 msb(Bitboard b) { unsigned long index; _BitScanReverse64(&index, b); return (s32)index; }
+#elif defined(_MSC_VER)
+inline s32 popcount(Bitboard b) { return (s32)(__popcnt((u32)b) + __popcnt((u32)(b >> 32))); }
+inline s32 lsb(Bitboard b) {
+    unsigned long index;
+    if (_BitScanForward(&index, (u32)b))  return (s32)index;
+    _BitScanForward(&index, (u32)(b >> 32));
+    return (s32)index + 32;
+}
+inline s32 msb(Bitboard b) {
+    unsigned long index;
+    if (_BitScanReverse(&index, (u32)(b >> 32)))  return (s32)index + 32;
+    _BitScanReverse(&index, (u32)b);
+    return (s32)index;
+}
+#else
+inline s32 popcount(Bitboard b) { return __builtin_popcountll(b); }
+inline s32 lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline s32 msb(Bitboard b) { return 63 - __builtin_clzll(b); }
+#endif
+
+// Returns the least significant square and clears it from the bitboard.
+inline s32 pop_lsb(Bitboard *b) {
+    s32 square = lsb(*b);
+    *b &= *b - 1;
+    return square;
+}
+
+inline Bitboard knight_attacks(s32 square) { return knight_attacks_table[square]; }
+inline Bitboard king_attacks(s32 square)   { return king_attacks_table[square]; }
+inline Bitboard pawn_attacks(s32 color, s32 square) { return pawn_attacks_table[color][square]; }
+
+inline Bitboard bishop_attacks(s32 square, Bitboard occupied) {
+    const Magic *m = &bishop_magics[square];
+    return m->attacks[((occupied & m->mask) * m->magic) >> m->shift];
+}
+
+inline Bitboard rook_attacks(s32 square, Bitboard occupied) {
+    const Magic *m = &rook_magics[square];
+    return m->attacks[((occupied & m->mask) * m->magic) >> m->shift];
+}
+
+inline Bitboard queen_attacks(s32 square, Bitboard occupied) {
+    return bishop_attacks(square, occupied) | rook_attacks(square, occupied);
+}
+
+// Shifts all pawns of 'color' one rank forward.
+inline Bitboard pawn_push(s32 color, Bitboard b) {
+    return (color == WHITE) ? (b << 8) : (b >> 8);
+}
+
+void print_bitboard(Bitboard b);
+
+#endif /* PAWN_BITBOARD_H */
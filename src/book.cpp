@@ -0,0 +1,584 @@
+// fopen()
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm> // std::sort
+
+#include "book.h"
+#include "movegen.h"
+#include "pgn.h"
+
+//
+// --- Internal structs ---
+//
+
+// Aggregated statistics for a (position, move) pair, from the point of view of the side making the move.
+// A record with 'move' == 0 is an empty table slot (Polyglot never encodes a1a1).
+struct Book_Record {
+    u64 key;
+    u16 move;
+    u16 padding;
+    u32 wins;
+    u32 draws;
+    u32 losses;
+};
+
+struct Book_Table {
+    Book_Record *records;
+    s64 capacity;        // Power of two.
+    s64 count;
+};
+
+struct Book_Worker {
+    const Book_Options *options;
+    s32 index;
+
+    Book_Table table;
+    s64 max_capacity;    // Largest table allowed by this worker's share of the memory limit.
+    s32 run_count;       // Sorted run files spilled so far.
+
+    u64 games_read;
+    u64 games_used;
+    u64 positions_counted;
+    bool failed;
+};
+
+// Stream over one sorted source during the final merge: either an in-memory table or a run file.
+struct Book_Source {
+    Book_Record *records;
+    s64 count;
+    s64 cursor;
+    FILE *file;          // NULL for in-memory sources.
+};
+
+const s64 BOOK_TABLE_MIN_CAPACITY = 1 << 16;
+const s64 BOOK_SOURCE_BUFFER_RECORDS = 1 << 14;
+const int BOOK_MAX_MOVES_PER_KEY = 512;
+const s64 BOOK_ENTRY_SIZE = 16;
+
+//
+// --- Helpers ---
+//
+u16 move_to_polyglot(Move move) {
+    s32 from = move_from(move);
+    s32 to = move_to(move);
+
+    // Polyglot stores castling as the king capturing its own rook.
+    if (move_flags(move) == MOVE_KING_CASTLE)   to = from + 3;
+    if (move_flags(move) == MOVE_QUEEN_CASTLE)  to = from - 4;
+
+    u16 promotion = 0;
+    if (is_promotion(move)) {
+        switch (promotion_kind(move)) {
+            case KNIGHT: promotion = 1; break;
+            case BISHOP: promotion = 2; break;
+            case ROOK:   promotion = 3; break;
+            default:     promotion = 4; break;
+        }
+    }
+    return (u16)(to | (from << 6) | (promotion << 12));
+}
+
+static bool record_less(const Book_Record &a, const Book_Record &b) {
+    if (a.key != b.key)  return a.key < b.key;
+    return a.move < b.move;
+}
+
+static void make_run_filepath(char *buffer, s64 buffer_size, const char *output, s32 worker, s32 run) {
+    snprintf(buffer, (size_t)buffer_size, "%s.%d.%d.tmp", output, worker, run);
+}
+
+static void write_u16_be(u8 *out, u16 value) {
+    out[0] = (u8)(value >> 8);
+    out[1] = (u8)value;
+}
+
+static void write_u32_be(u8 *out, u32 value) {
+    For (4) {
+        out[it] = (u8)(value >> (24 - 8 * it));
+    }
+}
+
+static u16 read_u16_be(const u8 *in) {
+    return (u16)((in[0] << 8) | in[1]);
+}
+
+static u64 read_u64_be(const u8 *in) {
+    u64 value = 0;
+    For (8)  value = (value << 8) | in[it];
+    return value;
+}
+
+static void write_u64_be(u8 *out, u64 value) {
+    For (8) {
+        out[it] = (u8)(value >> (56 - 8 * it));
+    }
+}
+
+//
+// --- Per-thread table ---
+//
+static void init_table(Book_Table *table, s64 capacity) {
+    table->records = ALLOC(sys_allocator, capacity, Book_Record);
+    mem_zero(table->records, capacity * sizeof(Book_Record));
+    table->capacity = capacity;
+    table->count = 0;
+}
+
+static inline u64 record_hash(u64 key, u16 move) {
+    return (key ^ ((u64)move * 0x9E3779B97F4A7C15ULL)) * 0xFF51AFD7ED558CCDULL;
+}
+
+static Book_Record *table_find_slot(Book_Table *table, u64 key, u16 move) {
+    u64 mask = (u64)table->capacity - 1;
+    u64 index = (record_hash(key, move) >> 16) & mask;
+    for (;;) {
+        Book_Record *record = &table->records[index];
+        if (record->move == 0 || (record->key == key && record->move == move))  return record;
+        index = (index + 1) & mask;
+    }
+}
+
+static void grow_table(Book_Table *table) {
+    Book_Table grown;
+    init_table(&grown, table->capacity * 2);
+    for (s64 i = 0; i < table->capacity; i++) {
+        Book_Record *record = &table->records[i];
+        if (record->move == 0)  continue;
+        *table_find_slot(&grown, record->key, record->move) = *record;
+        grown.count++;
+    }
+    FREE(sys_allocator, table->records);
+    *table = grown;
+}
+
+// Moves all used slots to the front and sorts them; the table is unusable for lookups afterwards.
+static s64 compact_and_sort_table(Book_Table *table) {
+    s64 count = 0;
+    for (s64 i = 0; i < table->capacity; i++) {
+        if (table->records[i].move != 0)  table->records[count++] = table->records[i];
+    }
+    std::sort(table->records, table->records + count, record_less);
+    return count;
+}
+
+static bool spill_table(Book_Worker *worker) {
+    ZoneScoped;
+
+    Book_Table *table = &worker->table;
+    s64 count = compact_and_sort_table(table);
+
+    char filepath[1024];
+    make_run_filepath(filepath, sizeof(filepath), worker->options->output_filepath, worker->index, worker->run_count);
+    FILE *file = fopen(filepath, "wb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Couldn't create '%s' run file!\n", filepath);
+        return false;
+    }
+    bool written = fwrite(table->records, sizeof(Book_Record), (size_t)count, file) == (size_t)count;
+    fclose(file);
+    if (!written) {
+        fprintf(stderr, "ERROR: Couldn't write '%s' run file!\n", filepath);
+        return false;
+    }
+
+    worker->run_count++;
+    mem_zero(table->records, table->capacity * sizeof(Book_Record));
+    table->count = 0;
+    return true;
+}
+
+static void add_record(Book_Worker *worker, u64 key, u16 move, s32 outcome) {
+    Book_Table *table = &worker->table;
+    if ((table->count + 1) * 10 > table->capacity * 7) {
+        if (table->capacity * 2 <= worker->max_capacity) {
+            grow_table(table);
+        } else if (!spill_table(worker)) {
+            worker->failed = true;
+            return;
+        }
+    }
+
+    Book_Record *record = table_find_slot(table, key, move);
+    if (record->move == 0) {
+        record->key = key;
+        record->move = move;
+        table->count++;
+    }
+    if (outcome > 0)       record->wins++;
+    else if (outcome < 0)  record->losses++;
+    else                   record->draws++;
+}
+
+static void add_game(Book_Worker *worker, const Pgn_Game *game) {
+    Position pos;
+    set_start_position(&pos);
+
+    s32 plies = game->move_count;
+    if (plies > worker->options->max_ply)  plies = worker->options->max_ply;
+
+    For (plies) {
+        Move move = game->moves[it];
+        s32 outcome = 0;
+        if (game->result == RESULT_WHITE_WIN)  outcome = (pos.side_to_move == WHITE) ? 1 : -1;
+        if (game->result == RESULT_BLACK_WIN)  outcome = (pos.side_to_move == BLACK) ? 1 : -1;
+
+        add_record(worker, pos.key, move_to_polyglot(move), outcome);
+        worker->positions_counted++;
+
+        Undo_Info undo;
+        make_move(&pos, move, &undo);
+    }
+}
+
+// Runs on the PGN parser's worker threads, each one owning the table of the same index.
+static void book_game_proc(void *data, s32 worker_index, const Pgn_Game *game) {
+    Book_Worker *worker = &((Book_Worker *)data)[worker_index];
+    const Book_Options *options = worker->options;
+    if (worker->failed)  return;
+
+    worker->games_read++;
+    bool rated = options->min_elo <= 0 || (game->white_elo >= options->min_elo && game->black_elo >= options->min_elo);
+    if (game->result != RESULT_UNKNOWN && rated && (!game->parse_error || game->move_count > 0)) {
+        add_game(worker, game);
+        worker->games_used++;
+    }
+}
+
+//
+// --- Merge ---
+//
+static bool source_peek(Book_Source *source, Book_Record **out) {
+    if (source->cursor >= source->count) {
+        if (!source->file)  return false;
+        source->count = (s64)fread(source->records, sizeof(Book_Record), (size_t)BOOK_SOURCE_BUFFER_RECORDS, source->file);
+        source->cursor = 0;
+        if (source->count == 0)  return false;
+    }
+    *out = &source->records[source->cursor];
+    return true;
+}
+
+struct Book_Writer {
+    FILE *file;
+    const Book_Options *options;
+    Book_Record group[BOOK_MAX_MOVES_PER_KEY];
+    s32 group_count;
+    u64 entries_written;
+    u64 keys_written;
+    bool failed;
+};
+
+static void flush_group(Book_Writer *writer) {
+    if (writer->group_count == 0)  return;
+
+    Book_Entry entries[BOOK_MAX_MOVES_PER_KEY];
+    u64 scores[BOOK_MAX_MOVES_PER_KEY];
+    s32 count = 0;
+    u64 max_score = 0;
+    For (writer->group_count) {
+        Book_Record *record = &writer->group[it];
+        u64 games = (u64)record->wins + record->draws + record->losses;
+        u64 score = 2 * (u64)record->wins + record->draws;
+        if (games < (u64)writer->options->min_games || score == 0)  continue;
+        if (score > max_score)  max_score = score;
+
+        entries[count].key = record->key;
+        entries[count].move = record->move;
+        entries[count].learn = 0;
+        scores[count] = score;
+        count++;
+    }
+    writer->group_count = 0;
+    if (count == 0)  return;
+
+    // Weight is 2 * wins + draws, scaled down per position when it doesn't fit 16 bits.
+    For (count) {
+        u64 score = scores[it];
+        if (max_score > 0xFFFF)  score = score * 0xFFFF / max_score;
+        entries[it].weight = (u16)((score > 0) ? score : 1);
+    }
+    std::sort(entries, entries + count, [](const Book_Entry &a, const Book_Entry &b) { return a.weight > b.weight; });
+
+    u8 bytes[BOOK_MAX_MOVES_PER_KEY * BOOK_ENTRY_SIZE];
+    For (count) {
+        u8 *out = bytes + it * BOOK_ENTRY_SIZE;
+        write_u64_be(out, entries[it].key);
+        write_u16_be(out + 8, entries[it].move);
+        write_u16_be(out + 10, entries[it].weight);
+        write_u32_be(out + 12, entries[it].learn);
+    }
+    if (fwrite(bytes, BOOK_ENTRY_SIZE, (size_t)count, writer->file) != (size_t)count)  writer->failed = true;
+    writer->entries_written += count;
+    writer->keys_written++;
+}
+
+static void write_record(Book_Writer *writer, const Book_Record *record) {
+    if (writer->group_count > 0) {
+        Book_Record *last = &writer->group[writer->group_count - 1];
+        if (last->key != record->key) {
+            flush_group(writer);
+        } else if (last->move == record->move) {
+            last->wins += record->wins;
+            last->draws += record->draws;
+            last->losses += record->losses;
+            return;
+        }
+    }
+    if (writer->group_count < BOOK_MAX_MOVES_PER_KEY) {
+        writer->group[writer->group_count++] = *record;
+    }
+}
+
+static bool merge_and_write(Book_Worker *workers, s32 worker_count, const Book_Options *options, u64 *out_entries, u64 *out_keys) {
+    ZoneScoped;
+
+    s32 source_count = worker_count;
+    For (worker_count) {
+        source_count += workers[it].run_count;
+    }
+
+    Book_Source *sources = ALLOC(sys_allocator, source_count, Book_Source);
+    s32 *heap = ALLOC(sys_allocator, source_count, s32);
+    defer { FREE(sys_allocator, sources); FREE(sys_allocator, heap); };
+
+    bool ok = true;
+    s32 count = 0;
+    For (worker_count) {
+        Book_Worker *worker = &workers[it];
+        Book_Source *source = &sources[count++];
+        source->records = worker->table.records;
+        source->count = compact_and_sort_table(&worker->table);
+        source->cursor = 0;
+        source->file = NULL;
+
+        for (s32 run = 0; run < worker->run_count; run++) {
+            char filepath[1024];
+            make_run_filepath(filepath, sizeof(filepath), options->output_filepath, worker->index, run);
+            source = &sources[count++];
+            source->records = ALLOC(sys_allocator, BOOK_SOURCE_BUFFER_RECORDS, Book_Record);
+            source->count = 0;
+            source->cursor = 0;
+            source->file = fopen(filepath, "rb");
+            if (!source->file) {
+                fprintf(stderr, "ERROR: Couldn't open '%s' run file!\n", filepath);
+                ok = false;
+            }
+        }
+    }
+
+    Book_Writer *writer = ALLOC(sys_allocator, 1, Book_Writer);
+    writer->options = options;
+    writer->group_count = 0;
+    writer->entries_written = 0;
+    writer->keys_written = 0;
+    writer->failed = false;
+    writer->file = ok ? fopen(options->output_filepath, "wb") : NULL;
+    if (ok && !writer->file) {
+        fprintf(stderr, "ERROR: Couldn't create '%s' book file!\n", options->output_filepath);
+        ok = false;
+    }
+
+    if (ok) {
+        // K-way merge with a binary min-heap of source indices.
+        auto less = [&](s32 a, s32 b) -> bool {
+            return record_less(sources[a].records[sources[a].cursor], sources[b].records[sources[b].cursor]);
+        };
+        auto sift_down = [&](s32 index, s32 size) {
+            for (;;) {
+                s32 smallest = index;
+                s32 left = 2 * index + 1;
+                s32 right = left + 1;
+                if (left < size && less(heap[left], heap[smallest]))    smallest = left;
+                if (right < size && less(heap[right], heap[smallest]))  smallest = right;
+                if (smallest == index)  return;
+                s32 swap = heap[index];
+                heap[index] = heap[smallest];
+                heap[smallest] = swap;
+                index = smallest;
+            }
+        };
+
+        s32 heap_size = 0;
+        For (source_count) {
+            Book_Record *record;
+            if (source_peek(&sources[it], &record))  heap[heap_size++] = it;
+        }
+        for (s32 i = heap_size / 2 - 1; i >= 0; i--)  sift_down(i, heap_size);
+
+        while (heap_size > 0) {
+            Book_Source *source = &sources[heap[0]];
+            write_record(writer, &source->records[source->cursor]);
+            source->cursor++;
+
+            Book_Record *record;
+            if (!source_peek(source, &record))  heap[0] = heap[--heap_size];
+            sift_down(0, heap_size);
+        }
+        flush_group(writer);
+
+        if (writer->failed) {
+            fprintf(stderr, "ERROR: Couldn't write '%s' book file!\n", options->output_filepath);
+            ok = false;
+        }
+    }
+
+    if (writer->file)  fclose(writer->file);
+    *out_entries = writer->entries_written;
+    *out_keys = writer->keys_written;
+    FREE(sys_allocator, writer);
+
+    count = 0;
+    For (worker_count) {
+        Book_Worker *worker = &workers[it];
+        count++;
+        for (s32 run = 0; run < worker->run_count; run++) {
+            Book_Source *source = &sources[count++];
+            if (source->file)  fclose(source->file);
+            FREE(sys_allocator, source->records);
+
+            char filepath[1024];
+            make_run_filepath(filepath, sizeof(filepath), options->output_filepath, worker->index, run);
+            delete_file(filepath);
+        }
+    }
+
+    return ok;
+}
+
+bool build_book(const Book_Options *options) {
+    ZoneScoped;
+
+    init_chess();
+
+    s32 worker_count = (options->threads > 0) ? options->threads : get_cpu_count();
+    s64 memory_per_worker = options->memory_limit / worker_count;
+
+    Book_Worker *workers = ALLOC(sys_allocator, worker_count, Book_Worker);
+    defer {
+        For (worker_count) {
+            FREE(sys_allocator, workers[it].table.records);
+        }
+        FREE(sys_allocator, workers);
+    };
+
+    For (worker_count) {
+        Book_Worker *worker = &workers[it];
+        mem_zero(worker, sizeof(Book_Worker));
+        worker->options = options;
+        worker->index = it;
+
+        worker->max_capacity = BOOK_TABLE_MIN_CAPACITY;
+        while (worker->max_capacity * 2 * (s64)sizeof(Book_Record) <= memory_per_worker)  worker->max_capacity *= 2;
+        init_table(&worker->table, BOOK_TABLE_MIN_CAPACITY);
+    }
+
+    Pgn_Parse_Options parse_options;
+    parse_options.threads = worker_count;
+    parse_options.max_plies = options->max_ply;
+    parse_options.proc = book_game_proc;
+    parse_options.data = workers;
+
+    u64 start_time = get_time_microseconds();
+    bool ok = true;
+
+    For (options->input_count) {
+        const char *filepath = options->input_filepaths[it];
+        Pgn_Parse_Stats stats;
+        if (!parse_pgn_file(filepath, &parse_options, &stats)) {
+            ok = false;
+            break;
+        }
+
+        for (s32 w = 0; w < worker_count; w++) {
+            if (workers[w].failed)  ok = false;
+        }
+        printf("%s: %llu games (%.1f MB).\n", filepath, (unsigned long long)stats.games, (double)stats.bytes / (1024.0 * 1024.0));
+        if (!ok)  break;
+    }
+
+    u64 games_read = 0;
+    u64 games_used = 0;
+    u64 positions = 0;
+    s32 runs = 0;
+    For (worker_count) {
+        games_read += workers[it].games_read;
+        games_used += workers[it].games_used;
+        positions += workers[it].positions_counted;
+        runs += workers[it].run_count;
+    }
+
+    u64 entries = 0;
+    u64 keys = 0;
+    if (ok)  ok = merge_and_write(workers, worker_count, options, &entries, &keys);
+
+    double seconds = (double)(get_time_microseconds() - start_time) / 1000000.0;
+    printf("Games read: %llu, used: %llu, positions: %llu, spilled runs: %d.\n",
+           (unsigned long long)games_read, (unsigned long long)games_used, (unsigned long long)positions, runs);
+    printf("Book '%s': %llu positions, %llu entries (%.2f s, %.0f games/s).\n",
+           options->output_filepath, (unsigned long long)keys, (unsigned long long)entries,
+           seconds, (seconds > 0.0) ? (double)games_read / seconds : 0.0);
+    return ok;
+}
+
+bool load_book(const char *filepath, Book *out_book) {
+    mem_zero(out_book, sizeof(Book));
+    if (!map_file(filepath, &out_book->file)) {
+        fprintf(stderr, "ERROR: Couldn't open '%s' book!\n", filepath);
+        return false;
+    }
+    if (out_book->file.size % BOOK_ENTRY_SIZE != 0) {
+        fprintf(stderr, "ERROR: '%s' is not a Polyglot book!\n", filepath);
+        unmap_file(&out_book->file);
+        return false;
+    }
+    out_book->entry_count = out_book->file.size / BOOK_ENTRY_SIZE;
+    return true;
+}
+
+void free_book(Book *book) {
+    unmap_file(&book->file);
+    book->entry_count = 0;
+}
+
+Move probe_book(const Book *book, const Position *pos, u64 random) {
+    const u8 *entries = (const u8 *)book->file.data;
+
+    // First entry of the key.
+    s64 low = 0;
+    s64 high = book->entry_count;
+    while (low < high) {
+        s64 middle = low + (high - low) / 2;
+        if (read_u64_be(entries + middle * BOOK_ENTRY_SIZE) < pos->key)  low = middle + 1;
+        else                                                              high = middle;
+    }
+
+    u64 total_weight = 0;
+    s64 end = low;
+    while (end < book->entry_count && read_u64_be(entries + end * BOOK_ENTRY_SIZE) == pos->key) {
+        total_weight += read_u16_be(entries + end * BOOK_ENTRY_SIZE + 10);
+        end++;
+    }
+    if (total_weight == 0)  return MOVE_NONE;
+
+    u64 pick = random % total_weight;
+    u16 polyglot = 0;
+    for (s64 i = low; i < end; i++) {
+        u16 weight = read_u16_be(entries + i * BOOK_ENTRY_SIZE + 10);
+        if (pick < weight) {
+            polyglot = read_u16_be(entries + i * BOOK_ENTRY_SIZE + 8);
+            break;
+        }
+        pick -= weight;
+    }
+
+    // Only a legal move is trusted, the key could be a collision.
+    Move_List legal;
+    generate_legal_moves(pos, &legal);
+    For (legal.count) {
+        if (move_to_polyglot(legal.moves[it]) == polyglot)  return legal.moves[it];
+    }
+    return MOVE_NONE;
+}
@@ -0,0 +1,47 @@
+#ifndef PAWN_BOOK_H
+#define PAWN_BOOK_H
+
+#include "platform.h"
+#include "position.h"
+
+//
+// --- Structs ---
+//
+
+// Polyglot book entry. Stored on disk as 16 big-endian bytes, sorted by key.
+struct Book_Entry {
+    u64 key;
+    u16 move;   // Polyglot move: to (bits 0-5), from (bits 6-11), promotion (bits 12-14). Castling is king-takes-rook.
+    u16 weight;
+    u32 learn;
+};
+
+struct Book_Options {
+    const char *output_filepath;
+    const char **input_filepaths;
+    s32 input_count;
+    s32 max_ply;         // Only positions before this ply are counted.
+    s32 min_games;       // Moves played in fewer games are dropped.
+    s32 min_elo;         // Both players must be rated at least this. 0 accepts unrated games.
+    s32 threads;
+    s64 memory_limit;    // Bytes for all per-thread tables together; over it, tables spill to sorted run files.
+};
+
+// A book file opened for probing, kept mapped.
+struct Book {
+    Mapped_File file;
+    s64 entry_count;
+};
+
+//
+// --- Functions ---
+//
+u16 move_to_polyglot(Move move);
+bool build_book(const Book_Options *options);
+
+bool load_book(const char *filepath, Book *out_book);
+void free_book(Book *book);
+// A move for 'pos' picked by weight, 'random' choosing among them. MOVE_NONE when out of book.
+Move probe_book(const Book *book, const Position *pos, u64 random);
+
+#endif /* PAWN_BOOK_H */
@@ -0,0 +1,224 @@
+#include <stdio.h>
+
+#include "bench.h"
+#include "check.h"
+#include "eval.h"
+#include "fen.h"
+#include "mate.h"
+#include "movegen.h"
+#include "pgn.h"
+#include "platform.h"
+
+//
+// --- Tables ---
+//
+
+// The positions and keys published with the Polyglot book format.
+struct Key_Case {
+    const char *fen;
+    u64 key;
+};
+
+static const Key_Case POLYGLOT_KEY_CASES[] = {
+    { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",         0x463B96181691FC9CULL },
+    { "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1",      0x823C9B50FD114196ULL },
+    { "rnbqkbnr/ppp1pppp/8/3p4/4P3/8/PPPP1PPP/RNBQKBNR w KQkq d6 0 2",    0x0756B94461C50FB0ULL },
+    { "rnbqkbnr/ppp1pppp/8/3pP3/8/8/PPPP1PPP/RNBQKBNR b KQkq - 0 2",      0x662FAFB965DB29D4ULL },
+    { "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",    0x22A48B5A8E47FF78ULL },
+    { "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR b kq - 0 3",       0x652A607CA3F242C1ULL },
+    { "rnbq1bnr/ppp1pkpp/8/3pPp2/8/8/PPPPKPPP/RNBQ1BNR w - - 0 4",        0x00FDD303C946BDD9ULL },
+    { "rnbqkbnr/p1pppppp/8/8/PpP4P/8/1P1PPPP1/RNBQKBNR b KQkq c3 0 3",    0x3C8123EA7B067637ULL },
+    { "rnbqkbnr/p1pppppp/8/8/P6P/R1p5/1P1PPPP1/1NBQKBNR b Kkq - 0 4",     0x5C3F9B829B279560ULL },
+};
+
+// Games that start in every way import format allows, with the plies each of them has.
+static const char PGN_BOUNDARY_TEXT[] =
+    "[Event \"first\"]\n[Result \"1-0\"]\n\n1. e4 e5 2. Qh5 Nc6 3. Bc4 Nf6 4. Qxf7# 1-0\n\n"
+    "[White \"after a blank line\"]\n[Event \"tag order\"]\n\n1. d4 d5 *\n"
+    "[Site \"right after the movetext\"]\n\n1. c4 {\n[not a tag] } e5 2. Nc3 1/2-1/2\n"
+    "[White \"without a termination marker\"]\n\n1. Nf3\n"
+    "[Black \"last\"]\n1. g3 g6\n";
+static const s32 PGN_BOUNDARY_PLIES[] = { 7, 2, 3, 1, 2 };
+
+//
+// --- Checks ---
+//
+
+// Books written with other keys can't be read by any other Polyglot tool.
+static bool check_polyglot_keys() {
+    bool ok = true;
+    For (sizeof(POLYGLOT_KEY_CASES) / sizeof(POLYGLOT_KEY_CASES[0])) {
+        const Key_Case *test = &POLYGLOT_KEY_CASES[it];
+        Position pos;
+        if (!parse_fen(&pos, test->fen) || pos.key != test->key) {
+            fprintf(stderr, "Key %016llx, expected %016llx: %s\n", (unsigned long long)pos.key, (unsigned long long)test->key, test->fen);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// Games must be found wherever they start, and from any offset, or the threaded parser drops them at
+// chunk edges.
+static bool check_pgn_boundaries() {
+    const char *text = PGN_BOUNDARY_TEXT;
+    s64 size = (s64)sizeof(PGN_BOUNDARY_TEXT) - 1;
+    const s32 expected_count = (s32)(sizeof(PGN_BOUNDARY_PLIES) / sizeof(PGN_BOUNDARY_PLIES[0]));
+
+    Pgn_Game *game = ALLOC(sys_allocator, 1, Pgn_Game);
+    defer { FREE(sys_allocator, game); };
+
+    bool ok = true;
+    s64 starts[expected_count + 1];
+    s32 count = 0;
+    s64 offset = pgn_next_game_start(text, size, 0);
+    while (offset < size) {
+        const char *next = pgn_parse_game(text + offset, text + size, game);
+        if (count < expected_count) {
+            starts[count] = offset;
+            if (game->parse_error || game->move_count != PGN_BOUNDARY_PLIES[count]) {
+                fprintf(stderr, "Game %d has %d plies, expected %d!\n", count + 1, game->move_count, PGN_BOUNDARY_PLIES[count]);
+                ok = false;
+            }
+        }
+        count++;
+        offset = pgn_next_game_start(text, size, next - text);
+    }
+    if (count != expected_count) {
+        fprintf(stderr, "Found %d games, expected %d!\n", count, expected_count);
+        return false;
+    }
+
+    starts[count] = size;
+    s32 game_index = 0;
+    For (size) {
+        if (it > starts[game_index])  game_index++;
+        s64 found = pgn_next_game_start(text, size, it);
+        if (found != starts[game_index]) {
+            fprintf(stderr, "From offset %d the next game starts at %d, expected %d!\n", (s32)it, (s32)found, (s32)starts[game_index]);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+// evaluate_batch() weighs the terms with its own copy of the weights when built with AVX2. Runs over the
+// bench positions and everything one move away from them, whole and in counts that leave partial vectors
+// and blocks.
+static bool check_evaluate_batch() {
+    const s32 MAX_POSITIONS = 8192;
+    Position *positions = ALLOC(sys_allocator, MAX_POSITIONS, Position);
+    s32 *scores = ALLOC(sys_allocator, MAX_POSITIONS, s32);
+    defer {
+        FREE(sys_allocator, positions);
+        FREE(sys_allocator, scores);
+    };
+
+    s32 count = 0;
+    For (BENCH_POSITION_COUNT) {
+        Position pos;
+        if (!parse_fen(&pos, BENCH_POSITIONS[it]))  return false;
+        if (count < MAX_POSITIONS)  positions[count++] = pos;
+
+        Move_List list;
+        generate_legal_moves(&pos, &list);
+        For (list.count) {
+            if (count == MAX_POSITIONS)  break;
+            Position child = pos;
+            Undo_Info undo;
+            make_move(&child, list.moves[it], &undo);
+            positions[count++] = child;
+        }
+    }
+
+    const s32 COUNTS[] = { count, 1, 7, 9, 63, 65, 100, count - 1 };
+    bool ok = true;
+    For (sizeof(COUNTS) / sizeof(COUNTS[0])) {
+        s32 batch_count = COUNTS[it];
+        evaluate_batch(positions, batch_count, scores);
+        for (s32 i = 0; i < batch_count; i++) {
+            s32 expected = evaluate(&positions[i]);
+            if (scores[i] != expected) {
+                fprintf(stderr, "Batch of %d, position %d: %d, evaluate() gives %d!\n", batch_count, i, scores[i], expected);
+                ok = false;
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+// Long mates with few pieces, where the solver has to reuse what it learned between its iterations.
+// Node limits rather than time keep the outcome the same on every machine.
+struct Mate_Case {
+    const char *fen;
+    s32 moves;            // Limit of the search.
+    u64 nodes;
+    s32 expected_moves;   // Mate the search has to prove...
+    bool shortest;        // ...and show there is none shorter, or just find one within 'moves'.
+};
+
+static const Mate_Case MATE_CASES[] = {
+    { "8/8/8/4k3/8/8/8/3QK3 w - - 0 1", 20, 1000000, 7, true },
+    { "8/8/8/4k3/8/8/8/R3K3 w - - 0 1", 20, 3000000, 20, false },
+};
+
+static bool check_mate_solver() {
+    Mate_Solver *solver = create_mate_solver(64);
+    if (!solver)  return false;
+    defer { destroy_mate_solver(solver); };
+
+    bool ok = true;
+    For (sizeof(MATE_CASES) / sizeof(MATE_CASES[0])) {
+        const Mate_Case *test = &MATE_CASES[it];
+        Position pos;
+        if (!parse_fen(&pos, test->fen))  return false;
+
+        Mate_Limits limits = { };
+        limits.moves = test->moves;
+        limits.nodes = test->nodes;
+        Mate_Result result;
+        clear_mate_solver(solver);
+        solve_mate(solver, &pos, &limits, &result);
+
+        bool solved = result.proven && (test->shortest ? result.shortest && result.moves == test->expected_moves : result.moves <= test->expected_moves);
+        if (!solved) {
+            fprintf(stderr, "%s mate %d%s after %llu nodes, expected %s%d: %s\n", result.proven ? "Proved" : "No", result.moves,
+                    result.shortest ? " as the shortest" : "", (unsigned long long)result.nodes, test->shortest ? "the shortest of " : "at most ",
+                    test->expected_moves, test->fen);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+struct Check {
+    const char *name;
+    bool (*proc)();
+};
+
+static const Check CHECKS[] = {
+    { "polyglot keys", check_polyglot_keys },
+    { "pgn game boundaries", check_pgn_boundaries },
+    { "evaluate_batch", check_evaluate_batch },
+    { "long mates", check_mate_solver },
+};
+
+//
+// --- Interface ---
+//
+bool run_checks() {
+    ZoneScoped;
+
+    s32 count = (s32)(sizeof(CHECKS) / sizeof(CHECKS[0]));
+    s32 failed = 0;
+    For (count) {
+        u64 start_time = get_time_microseconds();
+        bool ok = CHECKS[it].proc();
+        u64 time = get_time_microseconds() - start_time;
+        if (!ok)  failed++;
+        printf("%-4s %-24s %8.3f s\n", ok ? "ok" : "FAIL", CHECKS[it].name, (double)time / 1000000.0);
+    }
+    printf("%d of %d checks failed\n", failed, count);
+    return failed == 0;
+}
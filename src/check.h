@@ -0,0 +1,15 @@
+#ifndef PAWN_CHECK_H
+#define PAWN_CHECK_H
+
+#include "common.h"
+
+//
+// --- Functions ---
+//
+
+// Checks what a change can break without the search or the move generator noticing, like the Polyglot
+// keys or where the PGN parser finds games. Prints a line per check to stdout and the details of a
+// failure to stderr; false if any failed.
+bool run_checks();
+
+#endif /* PAWN_CHECK_H */
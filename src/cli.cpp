@@ -0,0 +1,572 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cli.h"
+#include "analysis.h"
+#include "bench.h"
+#include "book.h"
+#include "check.h"
+#include "datagen.h"
+#include "mate.h"
+#include "position.h"
+#include "puzzle.h"
+#include "search.h"
+#include "suite.h"
+#include "tournament.h"
+
+//
+// --- Structs ---
+//
+typedef int (*Cli_Proc)(int arguments_count, char **arguments);
+
+struct Cli_Command {
+    const char *name;
+    Cli_Proc proc;
+    const char *usage;
+};
+
+//
+// --- Helpers ---
+//
+
+// Matches "--name value" at 'arguments[*index]' and advances past the value.
+static bool match_option(int arguments_count, char **arguments, int *index, const char *name, const char **out_value) {
+    if (strcmp(arguments[*index], name) != 0)  return false;
+    if (*index + 1 >= arguments_count) {
+        fprintf(stderr, "ERROR: Option '%s' expects a value!\n", name);
+        *out_value = NULL;
+        return true;
+    }
+    *index += 1;
+    *out_value = arguments[*index];
+    return true;
+}
+
+//
+// --- Commands ---
+//
+static int book_command(int arguments_count, char **arguments) {
+    Book_Options options = { };
+    options.output_filepath = "book.bin";
+    options.max_ply = 20;
+    options.min_games = 1;
+    options.min_elo = 0;
+    options.threads = 0;
+    options.memory_limit = 1024LL * 1024 * 1024;
+
+    const char **inputs = ALLOC(sys_allocator, arguments_count, const char *);
+    defer { FREE(sys_allocator, inputs); };
+    s32 input_count = 0;
+
+    for (int i = 0; i < arguments_count; i++) {
+        const char *value = NULL;
+        if (match_option(arguments_count, arguments, &i, "-o", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.output_filepath = value;
+        } else if (match_option(arguments_count, arguments, &i, "--max-ply", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.max_ply = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--min-games", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.min_games = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--min-elo", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.min_elo = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--threads", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.threads = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--memory", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.memory_limit = atoll(value) * 1024 * 1024;
+        } else if (match_option(arguments_count, arguments, &i, "--keys", &value)) {
+            if (!value || !load_zobrist_keys(value))  return EXIT_FAILURE;
+        } else if (arguments[i][0] == '-') {
+            fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[i]);
+            return EXIT_FAILURE;
+        } else {
+            inputs[input_count++] = arguments[i];
+        }
+    }
+
+    if (input_count == 0) {
+        fprintf(stderr, "ERROR: No PGN files given!\n");
+        return EXIT_FAILURE;
+    }
+
+    options.input_filepaths = inputs;
+    options.input_count = input_count;
+    return build_book(&options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int epd_command(int arguments_count, char **arguments) {
+    Suite_Options options = { };
+    options.threads = 0;
+    options.hash_megabytes = 16;
+
+    for (int i = 0; i < arguments_count; i++) {
+        const char *value = NULL;
+        if (match_option(arguments_count, arguments, &i, "-o", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.report_filepath = value;
+        } else if (match_option(arguments_count, arguments, &i, "--depth", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.depth = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--movetime", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.movetime = atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--threads", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.threads = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--hash", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.hash_megabytes = atoll(value);
+        } else if (arguments[i][0] == '-') {
+            fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[i]);
+            return EXIT_FAILURE;
+        } else if (!options.epd_filepath) {
+            options.epd_filepath = arguments[i];
+        } else {
+            fprintf(stderr, "ERROR: Only one EPD suite can be run at a time!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.epd_filepath) {
+        fprintf(stderr, "ERROR: No EPD suite given!\n");
+        return EXIT_FAILURE;
+    }
+    if (options.depth <= 0 && options.movetime <= 0)  options.movetime = 1000;
+
+    return run_epd_suite(&options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int analyze_command(int arguments_count, char **arguments) {
+    Analysis_Options options = { };
+    options.threads = 0;
+    options.hash_megabytes = ANALYSIS_DEFAULT_HASH;
+
+    for (int i = 0; i < arguments_count; i++) {
+        const char *value = NULL;
+        if (match_option(arguments_count, arguments, &i, "-o", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.output_filepath = value;
+        } else if (match_option(arguments_count, arguments, &i, "--depth", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.depth = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--movetime", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.movetime = atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--threads", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.threads = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--hash", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.hash_megabytes = atoll(value);
+        } else if (arguments[i][0] == '-') {
+            fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[i]);
+            return EXIT_FAILURE;
+        } else if (!options.pgn_filepath) {
+            options.pgn_filepath = arguments[i];
+        } else {
+            fprintf(stderr, "ERROR: Only one PGN file can be analyzed at a time!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.pgn_filepath) {
+        fprintf(stderr, "ERROR: No PGN file given!\n");
+        return EXIT_FAILURE;
+    }
+    if (options.depth <= 0 && options.movetime <= 0)  options.depth = ANALYSIS_DEFAULT_DEPTH;
+
+    return analyze_pgn_file(&options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int puzzles_command(int arguments_count, char **arguments) {
+    Puzzle_Options options = { };
+    options.filter_depth = PUZZLE_DEFAULT_FILTER_DEPTH;
+    options.min_ply = PUZZLE_DEFAULT_MIN_PLY;
+    options.mate_nodes = PUZZLE_DEFAULT_MATE_NODES;
+    options.threads = 0;
+    options.hash_megabytes = PUZZLE_DEFAULT_HASH;
+
+    for (int i = 0; i < arguments_count; i++) {
+        const char *value = NULL;
+        if (match_option(arguments_count, arguments, &i, "-o", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.output_filepath = value;
+        } else if (match_option(arguments_count, arguments, &i, "--depth", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.depth = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--movetime", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.movetime = atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--filter-depth", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.filter_depth = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--min-ply", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.min_ply = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--mate-nodes", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.mate_nodes = (u64)atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--threads", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.threads = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--hash", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.hash_megabytes = atoll(value);
+        } else if (arguments[i][0] == '-') {
+            fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[i]);
+            return EXIT_FAILURE;
+        } else if (!options.pgn_filepath) {
+            options.pgn_filepath = arguments[i];
+        } else {
+            fprintf(stderr, "ERROR: Puzzles are taken from one PGN file at a time!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.pgn_filepath) {
+        fprintf(stderr, "ERROR: No PGN file given!\n");
+        return EXIT_FAILURE;
+    }
+    if (options.filter_depth <= 0) {
+        fprintf(stderr, "ERROR: The filter depth must be positive!\n");
+        return EXIT_FAILURE;
+    }
+    if (options.depth <= 0 && options.movetime <= 0)  options.depth = PUZZLE_DEFAULT_DEPTH;
+
+    return extract_puzzles(&options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int mate_command(int arguments_count, char **arguments) {
+    Mate_Suite_Options options = { };
+    options.moves = 20;
+    options.threads = 0;
+    options.hash_megabytes = 64;
+
+    for (int i = 0; i < arguments_count; i++) {
+        const char *value = NULL;
+        if (match_option(arguments_count, arguments, &i, "-o", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.report_filepath = value;
+        } else if (match_option(arguments_count, arguments, &i, "--moves", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.moves = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--nodes", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.nodes = (u64)atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--movetime", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.movetime = atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--threads", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.threads = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--hash", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.hash_megabytes = atoll(value);
+        } else if (arguments[i][0] == '-') {
+            fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[i]);
+            return EXIT_FAILURE;
+        } else if (!options.epd_filepath) {
+            options.epd_filepath = arguments[i];
+        } else {
+            fprintf(stderr, "ERROR: Only one EPD suite can be run at a time!\n");
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (!options.epd_filepath) {
+        fprintf(stderr, "ERROR: No EPD suite given!\n");
+        return EXIT_FAILURE;
+    }
+    if (options.moves < 1 || options.moves > MATE_MAX_MOVES) {
+        fprintf(stderr, "ERROR: Mates can be from 1 to %d moves long!\n", MATE_MAX_MOVES);
+        return EXIT_FAILURE;
+    }
+    if (options.nodes == 0 && options.movetime <= 0)  options.movetime = 10000;
+
+    return run_mate_suite(&options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Options without the "base-" prefix set both players, with it only the baseline, player 1.
+static bool match_player_option(int arguments_count, char **arguments, int *index, Tournament_Options *options, bool *out_failed) {
+    const char *argument = arguments[*index];
+    if (strncmp(argument, "--", 2) != 0)  return false;
+    bool base = strncmp(argument + 2, "base-", 5) == 0;
+    const char *name = argument + (base ? 7 : 2);
+    if (strcmp(name, "depth") != 0 && strcmp(name, "nodes") != 0 && strcmp(name, "movetime") != 0
+        && strcmp(name, "time") != 0 && strcmp(name, "inc") != 0 && strcmp(name, "hash") != 0 && strcmp(name, "disable") != 0) {
+        return false;
+    }
+
+    const char *value = NULL;
+    match_option(arguments_count, arguments, index, argument, &value);
+    if (!value) {
+        *out_failed = true;
+        return true;
+    }
+
+    // "--disable NullMove,LMR": parts of the selective search to leave out.
+    u32 disabled = 0;
+    if (strcmp(name, "disable") == 0) {
+        const char *cursor = value;
+        while (*cursor) {
+            const char *end = strchr(cursor, ',');
+            if (!end)  end = cursor + strlen(cursor);
+            u32 feature = search_feature_from_name(cursor, (s32)(end - cursor));
+            if (!feature) {
+                fprintf(stderr, "ERROR: Unknown search feature '%.*s'!\n", (int)(end - cursor), cursor);
+                *out_failed = true;
+                return true;
+            }
+            disabled |= feature;
+            cursor = *end ? end + 1 : end;
+        }
+    }
+    for (s32 i = base ? 1 : 0; i < 2; i++) {
+        Tournament_Player *player = &options->players[i];
+        if (strcmp(name, "depth") == 0)     player->depth = atoi(value);
+        if (strcmp(name, "nodes") == 0)     player->nodes = (u64)atoll(value);
+        if (strcmp(name, "movetime") == 0)  player->movetime = atoll(value);
+        if (strcmp(name, "time") == 0)      player->time = atoll(value);
+        if (strcmp(name, "inc") == 0)       player->increment = atoll(value);
+        if (strcmp(name, "hash") == 0)      player->hash_megabytes = atoll(value);
+        if (strcmp(name, "disable") == 0)   player->disabled_features = disabled;
+    }
+    return true;
+}
+
+static int tournament_command(int arguments_count, char **arguments) {
+    Tournament_Options options = { };
+    options.players[0].name = "test";
+    options.players[1].name = "base";
+    For (2)  options.players[it].hash_megabytes = 16;
+    options.book_plies = 8;
+    options.games = 20000;
+    options.resign_score = 600;
+    options.resign_moves = 4;
+    options.draw_score = 10;
+    options.draw_moves = 8;
+    options.draw_min_ply = 80;
+    options.elo0 = 0.0;
+    options.elo1 = 5.0;
+    options.alpha = 0.05;
+    options.beta = 0.05;
+
+    for (int i = 0; i < arguments_count; i++) {
+        const char *value = NULL;
+        bool failed = false;
+        if (match_player_option(arguments_count, arguments, &i, &options, &failed)) {
+            if (failed)  return EXIT_FAILURE;
+        } else if (match_option(arguments_count, arguments, &i, "-o", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.report_filepath = value;
+        } else if (match_option(arguments_count, arguments, &i, "--epd", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.epd_filepath = value;
+        } else if (match_option(arguments_count, arguments, &i, "--book", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.book_filepath = value;
+        } else if (match_option(arguments_count, arguments, &i, "--book-plies", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.book_plies = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--games", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.games = atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--threads", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.threads = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--seed", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.seed = (u64)atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--resign", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.resign_score = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--draw", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.draw_score = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--elo0", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.elo0 = atof(value);
+        } else if (match_option(arguments_count, arguments, &i, "--elo1", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.elo1 = atof(value);
+        } else if (match_option(arguments_count, arguments, &i, "--alpha", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.alpha = atof(value);
+        } else if (match_option(arguments_count, arguments, &i, "--beta", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.beta = atof(value);
+        } else {
+            fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // 10 seconds plus 0.1 per move unless told otherwise.
+    For (2) {
+        Tournament_Player *player = &options.players[it];
+        if (player->depth <= 0 && player->nodes == 0 && player->movetime <= 0 && player->time <= 0) {
+            player->time = 10000;
+            player->increment = 100;
+        }
+    }
+
+    return run_tournament(&options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int datagen_command(int arguments_count, char **arguments) {
+    Datagen_Options options = { };
+    options.output_prefix = "data";
+    options.positions = 1000000;
+    options.depth = 8;
+    options.random_plies = 8;
+    options.min_ply = 16;
+    options.chunk_records = 1 << 20;
+    options.hash_megabytes = 16;
+    options.adjudicate_score = 1000;
+    options.adjudicate_plies = 8;
+
+    for (int i = 0; i < arguments_count; i++) {
+        const char *value = NULL;
+        if (match_option(arguments_count, arguments, &i, "-o", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.output_prefix = value;
+        } else if (match_option(arguments_count, arguments, &i, "--positions", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.positions = atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--depth", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.depth = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--nodes", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.nodes = (u64)atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--random-plies", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.random_plies = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--min-ply", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.min_ply = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--chunk", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.chunk_records = atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--threads", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.threads = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--hash", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.hash_megabytes = atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--seed", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.seed = (u64)atoll(value);
+        } else if (match_option(arguments_count, arguments, &i, "--adjudicate", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            options.adjudicate_score = atoi(value);
+        } else {
+            fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[i]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    return run_datagen(&options) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int bench_command(int arguments_count, char **arguments) {
+    s32 depth = BENCH_DEFAULT_DEPTH;
+    s64 hash_megabytes = BENCH_DEFAULT_HASH;
+
+    for (int i = 0; i < arguments_count; i++) {
+        const char *value = NULL;
+        if (match_option(arguments_count, arguments, &i, "--depth", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            depth = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--hash", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            hash_megabytes = atoll(value);
+        } else {
+            fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (depth <= 0) {
+        fprintf(stderr, "ERROR: Bench depth has to be at least 1!\n");
+        return EXIT_FAILURE;
+    }
+
+    return run_bench(depth, hash_megabytes) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int perft_command(int arguments_count, char **arguments) {
+    s32 depth = -1;
+    const char *fen = NULL;
+
+    for (int i = 0; i < arguments_count; i++) {
+        const char *value = NULL;
+        if (match_option(arguments_count, arguments, &i, "--depth", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            depth = atoi(value);
+        } else if (match_option(arguments_count, arguments, &i, "--fen", &value)) {
+            if (!value)  return EXIT_FAILURE;
+            fen = value;
+        } else {
+            fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[i]);
+            return EXIT_FAILURE;
+        }
+    }
+    if (depth < 0)  depth = fen ? 5 : 4;
+
+    return run_perft(fen, depth) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static int check_command(int arguments_count, char **arguments) {
+    if (arguments_count > 0) {
+        fprintf(stderr, "ERROR: Unknown option '%s'!\n", arguments[0]);
+        return EXIT_FAILURE;
+    }
+    return run_checks() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+static const Cli_Command COMMANDS[] = {
+    { "bench", bench_command, "bench [--depth 10] [--hash 16]" },
+    { "perft", perft_command, "perft [--depth 4] [--fen \"<fen>\"]" },
+    { "check", check_command, "check" },
+    { "book", book_command, "book [-o book.bin] [--max-ply 20] [--min-games 1] [--min-elo 0] [--threads N] [--memory MB] [--keys random64.txt] <games.pgn>..." },
+    { "epd",  epd_command,  "epd [--depth N | --movetime 1000] [--threads N] [--hash 16] [-o report.json] <suite.epd>" },
+    { "analyze", analyze_command, "analyze [--depth 14 | --movetime N] [--threads N] [--hash 256] [-o annotated.pgn] <games.pgn>" },
+    { "puzzles", puzzles_command, "puzzles [--depth 14 | --movetime N] [--filter-depth 8] [--min-ply 10] [--mate-nodes 2000000] [--threads N] [--hash 32] [-o puzzles.epd] <games.pgn>" },
+    { "mate", mate_command, "mate [--moves 20] [--nodes N] [--movetime 10000] [--threads N] [--hash 64] [-o report.json] <puzzles.epd>" },
+    { "tournament", tournament_command, "tournament [--[base-]depth|nodes|movetime|time|inc|hash N] [--[base-]disable NullMove,LMR,...] [--epd openings.epd | --book book.bin [--book-plies 8]] "
+                                        "[--games 20000] [--threads N] [--elo0 0 --elo1 5 --alpha 0.05 --beta 0.05] [--resign 600] [--draw 10] [--seed N] [-o report.json]" },
+    { "datagen", datagen_command, "datagen [--depth 8] [--nodes N] [--positions 1000000] [--random-plies 8] [--min-ply 16] [--chunk 1048576] "
+                                  "[--threads N] [--hash 16] [--adjudicate 1000] [--seed N] [-o data]" },
+};
+
+static void print_usage(const char *program) {
+    printf("Usage:\n");
+    For (sizeof(COMMANDS) / sizeof(COMMANDS[0])) {
+        printf("  %s %s\n", program, COMMANDS[it].usage);
+    }
+}
+
+bool run_cli_command(int arguments_count, char **arguments, int *out_exit_code) {
+    if (arguments_count < 2)  return false;
+
+    const char *name = arguments[1];
+    if (strcmp(name, "help") == 0 || strcmp(name, "--help") == 0) {
+        print_usage(arguments[0]);
+        *out_exit_code = EXIT_SUCCESS;
+        return true;
+    }
+
+    For (sizeof(COMMANDS) / sizeof(COMMANDS[0])) {
+        if (strcmp(name, COMMANDS[it].name) == 0) {
+            init_chess();
+            *out_exit_code = COMMANDS[it].proc(arguments_count - 2, arguments + 2);
+            return true;
+        }
+    }
+    return false;
+}
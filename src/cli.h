@@ -0,0 +1,14 @@
+#ifndef PAWN_CLI_H
+#define PAWN_CLI_H
+
+#include "common.h"
+
+//
+// --- Functions ---
+//
+
+// Runs a headless command-line tool if the first argument names one ("pawn book ...").
+// Returns false when no tool was requested and the game should start as usual.
+bool run_cli_command(int arguments_count, char **arguments, int *out_exit_code);
+
+#endif /* PAWN_CLI_H */
@@ -0,0 +1,324 @@
+// fopen()
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "datagen.h"
+#include "json.h"
+#include "movegen.h"
+#include "search.h"
+
+//
+// --- Constants ---
+//
+const s32 DATAGEN_MAX_PLY = 1024;      // Longer games are drawn.
+const s32 DATAGEN_PATH_SIZE = 1024;
+const char TRAINING_CHUNK_MAGIC[8] = { 'P', 'A', 'W', 'N', 'T', 'D', '0', '1' };
+
+static_assert(sizeof(Training_Record) == 40, "Training records are read back as 40-byte blocks.");
+static_assert(sizeof(Training_Chunk_Header) == 16, "Chunk header must keep the records 8-byte aligned.");
+
+//
+// --- Structs ---
+//
+struct Datagen_Job {
+    const Datagen_Options *options;
+    std::atomic<s64> records;
+    std::atomic<s64> games;
+    std::atomic<u64> nodes;
+};
+
+struct Datagen_Worker {
+    Datagen_Job *job;
+    s32 index;
+    Transposition_Table tt;
+    Searcher *searcher;
+    u64 random_state;
+    u64 keys[DATAGEN_MAX_PLY + 1];                // Of every position of the game, for repetitions.
+    Training_Record records[DATAGEN_MAX_PLY];     // Of the game being played, written out once the result is known.
+
+    FILE *chunk;                                  // Open chunk file, NULL before the first record.
+    s32 chunk_count;                              // Chunk files created, all but the last one full.
+    s64 chunk_size;                               // Records in the open chunk.
+    bool failed;
+};
+
+//
+// --- Helpers ---
+//
+static u64 splitmix64(u64 *state) {
+    u64 z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void get_chunk_filepath(const Datagen_Options *options, s32 worker, s32 chunk, char *buffer) {
+    snprintf(buffer, DATAGEN_PATH_SIZE, "%s_%02d_%05d.bin", options->output_prefix, worker, chunk);
+}
+
+// Writes the final record count into the header.
+static bool close_chunk(Datagen_Worker *worker) {
+    if (!worker->chunk)  return true;
+
+    Training_Chunk_Header header;
+    memcpy(header.magic, TRAINING_CHUNK_MAGIC, sizeof(header.magic));
+    header.record_count = (u64)worker->chunk_size;
+    bool ok = fseek(worker->chunk, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, worker->chunk) == 1;
+    if (fclose(worker->chunk) != 0)  ok = false;
+    worker->chunk = NULL;
+    return ok;
+}
+
+static bool open_chunk(Datagen_Worker *worker) {
+    char filepath[DATAGEN_PATH_SIZE];
+    get_chunk_filepath(worker->job->options, worker->index, worker->chunk_count, filepath);
+    worker->chunk = fopen(filepath, "wb");
+    if (!worker->chunk) {
+        fprintf(stderr, "ERROR: Couldn't create '%s' chunk file!\n", filepath);
+        return false;
+    }
+    worker->chunk_count++;
+    worker->chunk_size = 0;
+
+    Training_Chunk_Header header;
+    mem_zero(&header, sizeof(header));
+    return fwrite(&header, sizeof(header), 1, worker->chunk) == 1;
+}
+
+static bool write_records(Datagen_Worker *worker, s32 count) {
+    s64 chunk_records = worker->job->options->chunk_records;
+    For (count) {
+        if (!worker->chunk || worker->chunk_size >= chunk_records) {
+            if (!close_chunk(worker) || !open_chunk(worker))  return false;
+        }
+        if (fwrite(&worker->records[it], sizeof(Training_Record), 1, worker->chunk) != 1)  return false;
+        worker->chunk_size++;
+    }
+    return true;
+}
+
+// Plays random moves from the start position. False if the game ended on the way.
+static bool play_random_opening(Datagen_Worker *worker, Position *pos, s32 *ply) {
+    set_start_position(pos);
+    *ply = 0;
+    worker->keys[0] = pos->key;
+    For (worker->job->options->random_plies) {
+        Move_List legal;
+        generate_legal_moves(pos, &legal);
+        if (legal.count == 0)  return false;
+
+        Undo_Info undo;
+        make_move(pos, legal.moves[splitmix64(&worker->random_state) % (u64)legal.count], &undo);
+        *ply += 1;
+        worker->keys[*ply] = pos->key;
+    }
+    return has_legal_moves(pos);
+}
+
+// Returns the number of records left in 'worker->records', with the result filled in.
+static s32 play_game(Datagen_Worker *worker) {
+    ZoneScoped;
+
+    const Datagen_Options *options = worker->job->options;
+    Position pos;
+    s32 ply;
+    while (!play_random_opening(worker, &pos, &ply)) { }
+
+    tt_clear(&worker->tt);
+    clear_searcher(worker->searcher);
+
+    Search_Limits limits = { };
+    limits.depth = options->depth;
+    limits.nodes = options->nodes;
+
+    s32 record_count = 0;
+    s32 result = 0;
+    s32 winning_plies = 0;      // In a row with white (> 0) or black (< 0) past the adjudication score.
+    for (;;) {
+        s32 us = pos.side_to_move;
+        bool check = in_check(&pos);
+        if (!has_legal_moves(&pos)) {
+            if (check)  result = (us == WHITE) ? -1 : 1;
+            break;
+        }
+        if (pos.halfmove_clock >= FIFTY_MOVE_PLY || is_threefold_repetition(&pos, worker->keys, ply)
+            || is_insufficient_material(&pos) || ply >= DATAGEN_MAX_PLY)  break;
+
+        Search_Result search = search_position(worker->searcher, &pos, &limits, worker->keys, ply);
+        worker->job->nodes.fetch_add(search.nodes, std::memory_order_relaxed);
+        s32 white_score = (us == WHITE) ? search.score : -search.score;
+
+        if (options->adjudicate_score > 0) {
+            if (white_score >= options->adjudicate_score)        winning_plies = (winning_plies > 0) ? winning_plies + 1 : 1;
+            else if (white_score <= -options->adjudicate_score)  winning_plies = (winning_plies < 0) ? winning_plies - 1 : -1;
+            else                                                 winning_plies = 0;
+            if (winning_plies >= options->adjudicate_plies || -winning_plies >= options->adjudicate_plies) {
+                result = (winning_plies > 0) ? 1 : -1;
+                break;
+            }
+        }
+
+        // Quiet positions only: the score of a position with a capture pending says little about its features.
+        bool quiet = !check && !is_capture(search.best_move) && !is_promotion(search.best_move) && !is_mate_score(search.score);
+        if (quiet && ply >= options->min_ply) {
+            Training_Record *record = &worker->records[record_count++];
+            pack_position(&pos, &record->position);
+            record->score = (s16)white_score;
+            record->move = search.best_move;
+            record->ply = (u16)ply;
+            record->padding = 0;
+        }
+
+        Undo_Info undo;
+        make_move(&pos, search.best_move, &undo);
+        ply++;
+        worker->keys[ply] = pos.key;
+    }
+
+    For (record_count)  worker->records[it].result = (s8)result;
+    return record_count;
+}
+
+static bool setup_datagen_worker(void *data, s32 index, void *job_data) {
+    Datagen_Worker *worker = (Datagen_Worker *)data;
+    Datagen_Job *job = (Datagen_Job *)job_data;
+    worker->job = job;
+    worker->index = index;
+    worker->random_state = job->options->seed ^ ((u64)(index + 1) * 0xD1B54A32D192ED03ULL);
+    if (!tt_init(&worker->tt, job->options->hash_megabytes))  return false;
+    worker->searcher = create_searcher(&worker->tt);
+    return true;
+}
+
+static void cleanup_datagen_worker(void *data) {
+    Datagen_Worker *worker = (Datagen_Worker *)data;
+    destroy_searcher(worker->searcher);
+    tt_free(&worker->tt);
+}
+
+static void datagen_worker_proc(void *data) {
+    ZoneScoped;
+
+    Datagen_Worker *worker = (Datagen_Worker *)data;
+    Datagen_Job *job = worker->job;
+
+    while (job->records.load() < job->options->positions) {
+        s32 count = play_game(worker);
+        if (!write_records(worker, count)) {
+            worker->failed = true;
+            break;
+        }
+        s64 records = job->records.fetch_add(count) + count;
+        s64 games = job->games.fetch_add(1) + 1;
+        fprintf(stderr, "\r%lld games, %lld positions", (long long)games, (long long)records);
+    }
+    if (!close_chunk(worker))  worker->failed = true;
+}
+
+static bool write_index(const Datagen_Options *options, Datagen_Job *job, const Datagen_Worker *workers, s32 worker_count, u64 wall_time) {
+    char filepath[DATAGEN_PATH_SIZE];
+    snprintf(filepath, sizeof(filepath), "%s.json", options->output_prefix);
+    FILE *file = open_output_file(filepath, "index");
+    if (!file)  return false;
+
+    Json_Writer writer;
+    json_begin(&writer, file);
+    json_begin_object(&writer, NULL);
+
+    json_write_int(&writer, "record_size", sizeof(Training_Record));
+    json_write_int(&writer, "header_size", sizeof(Training_Chunk_Header));
+    json_write_int(&writer, "depth", options->depth);
+    json_write_uint(&writer, "nodes_per_move", options->nodes);
+    json_write_int(&writer, "random_plies", options->random_plies);
+    json_write_uint(&writer, "seed", options->seed);
+    json_write_int(&writer, "games", job->games.load());
+    json_write_int(&writer, "records", job->records.load());
+    json_write_uint(&writer, "nodes", job->nodes.load());
+    json_write_float(&writer, "wall_time_ms", (double)wall_time / 1000.0);
+    json_write_float(&writer, "records_per_second", (wall_time > 0) ? (double)job->records.load() * 1000000.0 / (double)wall_time : 0.0);
+
+    json_begin_array(&writer, "chunks");
+    For (worker_count) {
+        const Datagen_Worker *worker = &workers[it];
+        for (s32 chunk = 0; chunk < worker->chunk_count; chunk++) {
+            char chunk_filepath[DATAGEN_PATH_SIZE];
+            get_chunk_filepath(options, worker->index, chunk, chunk_filepath);
+            json_begin_object(&writer, NULL);
+            json_write_string(&writer, "file", chunk_filepath);
+            json_write_int(&writer, "records", (chunk + 1 < worker->chunk_count) ? options->chunk_records : worker->chunk_size);
+            json_end_object(&writer);
+        }
+    }
+    json_end_array(&writer);
+
+    json_end_object(&writer);
+    json_end(&writer);
+    return fclose(file) == 0;
+}
+
+//
+// --- Interface ---
+//
+bool run_datagen(const Datagen_Options *options) {
+    ZoneScoped;
+
+    if (options->positions <= 0 || options->chunk_records <= 0) {
+        fprintf(stderr, "ERROR: No positions to generate!\n");
+        return false;
+    }
+    if (options->depth <= 0 && options->nodes == 0) {
+        fprintf(stderr, "ERROR: Data generation needs a depth or a node limit!\n");
+        return false;
+    }
+
+    s32 thread_count = (options->threads > 0) ? options->threads : get_cpu_count();
+
+    Datagen_Job job;
+    job.options = options;
+    job.records.store(0);
+    job.games.store(0);
+    job.nodes.store(0);
+
+    Worker_Pool pool;
+    if (!create_worker_pool(&pool, thread_count, sizeof(Datagen_Worker), setup_datagen_worker, cleanup_datagen_worker, &job))  return false;
+    defer { destroy_worker_pool(&pool); };
+    Datagen_Worker *workers = (Datagen_Worker *)pool.workers;
+
+    u64 start_time = get_time_microseconds();
+    run_worker_pool(&pool, datagen_worker_proc);
+    fprintf(stderr, "\n");
+    bool ok = true;
+    For (pool.count) {
+        if (workers[it].failed)  ok = false;
+    }
+    if (!ok)  fprintf(stderr, "ERROR: Couldn't write training data to '%s' chunks!\n", options->output_prefix);
+    u64 wall_time = get_time_microseconds() - start_time;
+
+    if (ok)  ok = write_index(options, &job, workers, pool.count, wall_time);
+    return ok;
+}
+
+bool open_training_chunk(const char *filepath, Training_Chunk *out_chunk) {
+    if (!map_file(filepath, &out_chunk->file))  return false;
+
+    const Training_Chunk_Header *header = (const Training_Chunk_Header *)out_chunk->file.data;
+    bool valid = out_chunk->file.size >= (s64)sizeof(Training_Chunk_Header)
+              && memcmp(header->magic, TRAINING_CHUNK_MAGIC, sizeof(header->magic)) == 0
+              && (u64)out_chunk->file.size == sizeof(Training_Chunk_Header) + header->record_count * sizeof(Training_Record);
+    if (!valid) {
+        fprintf(stderr, "ERROR: '%s' is not a training data chunk!\n", filepath);
+        unmap_file(&out_chunk->file);
+        return false;
+    }
+    out_chunk->records = (const Training_Record *)(out_chunk->file.data + sizeof(Training_Chunk_Header));
+    out_chunk->record_count = (s64)header->record_count;
+    return true;
+}
+
+void close_training_chunk(Training_Chunk *chunk) {
+    unmap_file(&chunk->file);
+}
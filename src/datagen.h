@@ -0,0 +1,62 @@
+#ifndef PAWN_DATAGEN_H
+#define PAWN_DATAGEN_H
+
+#include "packed.h"
+#include "platform.h"
+
+//
+// --- Structs ---
+//
+
+// One position of a self-play game, as written to the chunk files. 40 bytes.
+struct Training_Record {
+    Packed_Position position;
+    s16 score;                    // Centipawns from white's point of view.
+    Move move;                    // Best move of the search.
+    u16 ply;                      // Of the game, the random opening included.
+    s8 result;                    // Of the game from white's point of view: 1, 0 or -1.
+    u8 padding;
+};
+
+// Start of a chunk file, followed by 'record_count' records.
+struct Training_Chunk_Header {
+    char magic[8];
+    u64 record_count;
+};
+
+// A chunk file opened for reading, kept mapped.
+struct Training_Chunk {
+    Mapped_File file;
+    const Training_Record *records;
+    s64 record_count;
+};
+
+struct Datagen_Options {
+    const char *output_prefix;    // Chunks go to "<prefix>_<thread>_<n>.bin", the index listing them to "<prefix>.json".
+    s64 positions;                // Records to write; games are always written whole, so a few more.
+    s32 depth;                    // Per move; either or both.
+    u64 nodes;
+    s32 random_plies;             // Random moves from the start position, so no two games are the same.
+    s32 min_ply;                  // Positions before this ply aren't written.
+    s64 chunk_records;            // Records per chunk file.
+    s32 threads;                  // Games played at once. 0 uses every core.
+    s64 hash_megabytes;
+    u64 seed;
+
+    // A game is won once the score stays this far on one side for this many plies. 0 turns it off.
+    s32 adjudicate_score;
+    s32 adjudicate_plies;
+};
+
+//
+// --- Functions ---
+//
+
+// Plays fixed-depth self-play games on every core and writes the quiet positions, with the search
+// score and the game result, to chunked binary files.
+bool run_datagen(const Datagen_Options *options);
+
+bool open_training_chunk(const char *filepath, Training_Chunk *out_chunk);
+void close_training_chunk(Training_Chunk *chunk);
+
+#endif /* PAWN_DATAGEN_H */
@@ -0,0 +1,274 @@
+#include "engine.h"
+
+//
+// --- Constants ---
+//
+const u32 ENGINE_IDLE_SLEEP = 1; // Milliseconds between looks at the command queue while idle.
+
+//
+// --- Helpers ---
+//
+static s32 engine_hashfull(const Engine *engine) {
+    if (engine->mcts)  return mcts_hashfull(engine->mcts);
+    return tt_hashfull(&engine->tt);
+}
+
+static void stop_engine_search(Engine *engine) {
+    if (engine->mcts)  stop_mcts(engine->mcts);
+    else               stop_search(engine->searcher);
+}
+
+static bool is_stop_requested(const Engine *engine) {
+    if (engine->mcts)  return engine->mcts->stop.load(std::memory_order_relaxed);
+    return engine->searcher->stop.load(std::memory_order_relaxed);
+}
+
+static bool is_engine_pondering(const Engine *engine) {
+    return engine->mcts ? is_mcts_pondering(engine->mcts) : is_pondering(engine->searcher);
+}
+
+static void engine_ponder_hit_now(Engine *engine) {
+    if (engine->mcts)  mcts_ponder_hit(engine->mcts);
+    else               ponder_hit(engine->searcher);
+}
+
+// Iteration infos are dropped when the UI falls behind, it only shows the newest anyway.
+static void engine_report_proc(void *data, const Search_Report *report) {
+    Engine *engine = (Engine *)data;
+    Engine_Info *info = &engine->report;
+    info->kind = ENGINE_INFO_ITERATION;
+    info->depth = report->depth;
+    info->seldepth = report->seldepth;
+    info->score = report->score;
+    info->bound = report->bound;
+    info->multi_pv = report->multi_pv;
+    info->nodes = report->nodes;
+    info->time = report->time;
+    info->nps = (report->time > 0) ? report->nodes * 1000000 / report->time : 0;
+    info->hashfull = engine_hashfull(engine);
+    info->best_move = (report->pv_length > 0) ? report->pv[0] : MOVE_NONE;
+    info->ponder_move = (report->pv_length > 1) ? report->pv[1] : MOVE_NONE;
+    info->pv_length = report->pv_length;
+    For (report->pv_length)  info->pv[it] = report->pv[it];
+    moves_to_san(&engine->position, report->pv, report->pv_length, info->pv_text);
+
+    spsc_push(&engine->infos, *info);
+}
+
+static void send_best_move(Engine *engine, u32 search_id, const Search_Result *result) {
+    Engine_Info *info = &engine->report;
+    info->search_id = search_id;
+    info->kind = ENGINE_INFO_BEST_MOVE;
+    info->depth = result->depth;
+    info->seldepth = result->seldepth;
+    info->score = result->score;
+    info->bound = BOUND_EXACT;
+    info->multi_pv = 1;
+    info->nodes = result->nodes;
+    info->time = result->time;
+    info->nps = (result->time > 0) ? result->nodes * 1000000 / result->time : 0;
+    info->hashfull = engine_hashfull(engine);
+    info->best_move = result->best_move;
+    info->ponder_move = result->ponder_move;
+    info->pv_length = 0;
+    info->pv_text[0] = '\0';
+
+    // Unlike iteration infos the result must arrive; the UI drains the queue every frame.
+    while (!spsc_push(&engine->infos, *info)) {
+        if (!spsc_empty(&engine->commands))  break;
+        sleep_milliseconds(ENGINE_IDLE_SLEEP);
+    }
+}
+
+static u32 send_go(Engine *engine, const Search_Limits *limits, bool ponder) {
+    Engine_Command command;
+    command.kind = ENGINE_GO;
+    command.limits = *limits;
+    command.ponder = ponder;
+    command.search_id = engine->last_search_id + 1;
+    if (command.search_id == 0)  command.search_id = 1;
+    if (!engine_send(engine, &command))  return 0;
+
+    engine->last_search_id = command.search_id;
+    return command.search_id;
+}
+
+// The flag is set here rather than by the UI so a hit can't be undone by a search starting late; the
+// fences pair with the one in 'engine_ponder_hit()', so one side always sees the other.
+static void start_ponder_search(Engine *engine, const Engine_Command *command) {
+    if (!command->ponder) {
+        engine_ponder_hit_now(engine);
+        return;
+    }
+    if (engine->mcts)  start_mcts_pondering(engine->mcts);
+    else               start_pondering(engine->searcher);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (engine->ponder_hit_id.load(std::memory_order_relaxed) == command->search_id)  engine_ponder_hit_now(engine);
+}
+
+static void engine_thread_proc(void *data) {
+    Engine *engine = (Engine *)data;
+
+    for (;;) {
+        Engine_Command command;
+        if (!spsc_pop(&engine->commands, &command)) {
+            sleep_milliseconds(ENGINE_IDLE_SLEEP);
+            continue;
+        }
+
+        switch (command.kind) {
+            case ENGINE_SET_POSITION: {
+                engine->position = command.position;
+                engine->game_key_count = command.game_key_count;
+                For (command.game_key_count)  engine->game_keys[it] = command.game_keys[it];
+            } break;
+
+            case ENGINE_GO: {
+                ZoneScopedN("engine_go");
+
+                // A stop raised for a command queued behind this one must not be lost: clear the request
+                // first, then look at the queue. The fence pairs with the one in 'engine_send()'.
+                // A superseded search still ends with a (move-less) result, so the UI isn't left waiting.
+                Search_Result result = { };
+                if (engine->mcts)  clear_mcts_stop_request(engine->mcts);
+                else               clear_stop_request(engine->searcher);
+                start_ponder_search(engine, &command);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                engine->report.search_id = command.search_id;
+                if (spsc_empty(&engine->commands)) {
+                    if (engine->mcts) {
+                        result = mcts_search(engine->mcts, &engine->position, &command.limits, engine->game_keys, engine->game_key_count);
+                    } else {
+                        result = search_position(engine->searcher, &engine->position, &command.limits, engine->game_keys, engine->game_key_count);
+                    }
+                    while (is_engine_pondering(engine) && !is_stop_requested(engine)) {
+                        sleep_milliseconds(ENGINE_IDLE_SLEEP);
+                    }
+                }
+                send_best_move(engine, command.search_id, &result);
+            } break;
+
+            case ENGINE_STOP: {
+                // The search, if any, was already stopped by 'engine_send()'.
+            } break;
+
+            case ENGINE_NEW_GAME: {
+                // The tree is grown anew every search anyway.
+                if (engine->mcts)  break;
+                tt_clear(&engine->tt);
+                clear_searcher(engine->searcher);
+            } break;
+
+            case ENGINE_QUIT: {
+                return;
+            } break;
+        }
+    }
+}
+
+//
+// --- Interface ---
+//
+Engine *start_engine(s64 hash_megabytes, const char *tt_filepath, Engine_Algorithm algorithm, s32 threads) {
+    ZoneScoped;
+
+    Engine *engine = ALLOC(sys_allocator, 1, Engine);
+    mem_zero(engine, sizeof(Engine));
+    engine->algorithm = algorithm;
+    if (algorithm == ENGINE_MCTS) {
+        engine->mcts = create_mcts(hash_megabytes);
+        if (!engine->mcts) {
+            FREE(sys_allocator, engine);
+            return NULL;
+        }
+        engine->mcts->thread_count = threads;
+        engine->mcts->report_proc = engine_report_proc;
+        engine->mcts->report_data = engine;
+    } else {
+        if (!tt_init(&engine->tt, hash_megabytes)) {
+            FREE(sys_allocator, engine);
+            return NULL;
+        }
+        // A stale or damaged snapshot just means a cold start.
+        s64 snapshot_size;
+        engine->tt_filepath = tt_filepath;
+        if (tt_filepath && get_file_size(tt_filepath, &snapshot_size))  tt_load(&engine->tt, tt_filepath);
+        engine->searcher = create_searcher(&engine->tt);
+        engine->searcher->report_proc = engine_report_proc;
+        engine->searcher->report_data = engine;
+    }
+    set_start_position(&engine->position);
+    spsc_init(&engine->commands);
+    spsc_init(&engine->infos);
+    engine->ponder_hit_id.store(0);
+
+    engine->thread = create_thread(engine_thread_proc, engine);
+    return engine;
+}
+
+void stop_engine(Engine *engine) {
+    if (!engine)  return;
+
+    Engine_Command command;
+    command.kind = ENGINE_QUIT;
+    while (!engine_send(engine, &command))  sleep_milliseconds(ENGINE_IDLE_SLEEP);
+    join_thread(&engine->thread);
+
+    if (engine->mcts) {
+        destroy_mcts(engine->mcts);
+    } else {
+        if (engine->tt_filepath)  tt_save(&engine->tt, engine->tt_filepath);
+        destroy_searcher(engine->searcher);
+        tt_free(&engine->tt);
+    }
+    FREE(sys_allocator, engine);
+}
+
+bool engine_send(Engine *engine, const Engine_Command *command) {
+    if (!spsc_push(&engine->commands, *command))  return false;
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    stop_engine_search(engine);
+    return true;
+}
+
+bool engine_set_position(Engine *engine, const Position *pos, const u64 *game_keys, s32 game_key_count) {
+    Engine_Command command;
+    command.kind = ENGINE_SET_POSITION;
+    command.position = *pos;
+    if (game_key_count > FIFTY_MOVE_PLY) {
+        game_keys += game_key_count - FIFTY_MOVE_PLY;
+        game_key_count = FIFTY_MOVE_PLY;
+    }
+    command.game_key_count = game_key_count;
+    For (game_key_count)  command.game_keys[it] = game_keys[it];
+    return engine_send(engine, &command);
+}
+
+u32 engine_go(Engine *engine, const Search_Limits *limits) {
+    return send_go(engine, limits, false);
+}
+
+u32 engine_go_ponder(Engine *engine, const Search_Limits *limits) {
+    return send_go(engine, limits, true);
+}
+
+void engine_ponder_hit(Engine *engine, u32 search_id) {
+    engine->ponder_hit_id.store(search_id, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (engine->last_search_id == search_id)  engine_ponder_hit_now(engine);
+}
+
+bool engine_stop(Engine *engine) {
+    Engine_Command command;
+    command.kind = ENGINE_STOP;
+    return engine_send(engine, &command);
+}
+
+bool engine_poll(Engine *engine, Engine_Info *out_info) {
+    return spsc_pop(&engine->infos, out_info);
+}
+
+void engine_search_summary(Engine *engine, Search_Summary *out_summary) {
+    mem_zero(out_summary, sizeof(Search_Summary));
+    if (engine->searcher)  summarize_search(&engine->searcher, 1, out_summary);
+}
@@ -0,0 +1,123 @@
+#ifndef PAWN_ENGINE_H
+#define PAWN_ENGINE_H
+
+#include "mcts.h"
+#include "notation.h"
+#include "platform.h"
+#include "search.h"
+#include "spsc.h"
+#include "stats.h"
+
+//
+// --- Constants ---
+//
+const int ENGINE_COMMAND_QUEUE_SIZE = 16;
+const int ENGINE_INFO_QUEUE_SIZE = 64;
+const int ENGINE_PV_TEXT_SIZE = MAX_PLY * MOVE_TEXT_SIZE;
+
+//
+// --- Enums ---
+//
+enum Engine_Command_Kind {
+    ENGINE_SET_POSITION = 0,
+    ENGINE_GO = 1,
+    ENGINE_STOP = 2,
+    ENGINE_NEW_GAME = 3,
+    ENGINE_QUIT = 4
+};
+
+enum Engine_Algorithm {
+    ENGINE_ALPHA_BETA = 0,
+    ENGINE_MCTS = 1              // Monte Carlo tree search; the hash megabytes go to its node pool.
+};
+
+enum Engine_Info_Kind {
+    ENGINE_INFO_ITERATION = 0,   // A completed iteration of the running search.
+    ENGINE_INFO_BEST_MOVE = 1    // The search is over.
+};
+
+//
+// --- Structs ---
+//
+struct Engine_Command {
+    Engine_Command_Kind kind;
+    Position position;           // ENGINE_SET_POSITION.
+    s32 game_key_count;          // ENGINE_SET_POSITION, keys of the positions before it, for repetitions.
+    u64 game_keys[FIFTY_MOVE_PLY];
+    Search_Limits limits;        // ENGINE_GO.
+    u32 search_id;               // ENGINE_GO, echoed in every info of that search.
+    bool ponder;                 // ENGINE_GO, limits wait for 'engine_ponder_hit()'.
+};
+
+// Snapshot of the search, sent by value so the UI never touches engine memory.
+struct Engine_Info {
+    Engine_Info_Kind kind;
+    u32 search_id;               // Infos of a superseded search can still be queued, compare with 'engine_go()'.
+    s32 depth;
+    s32 seldepth;
+    s32 score;
+    s32 bound;                   // BOUND_LOWER or BOUND_UPPER while a line is searched again with a wider window.
+    s32 multi_pv;                // Line number, 1 for the best.
+    u64 nodes;
+    u64 nps;
+    u64 time;                    // Microseconds.
+    s32 hashfull;
+    Move best_move;
+    Move ponder_move;
+    s32 pv_length;
+    Move pv[MAX_PLY];
+    char pv_text[ENGINE_PV_TEXT_SIZE];   // SAN, formatted on the engine thread.
+};
+
+// Service thread owning the table and the searcher. The UI thread is the only producer of
+// commands and the only consumer of infos, so both queues are single-producer single-consumer.
+struct Engine {
+    Engine_Algorithm algorithm;
+    Transposition_Table tt;
+    const char *tt_filepath;     // Snapshot loaded at start and saved at stop, NULL for none.
+    Searcher *searcher;
+    Mcts *mcts;                  // ENGINE_MCTS only.
+    Position position;
+    s32 game_key_count;
+    u64 game_keys[FIFTY_MOVE_PLY];
+    Thread thread;
+
+    Spsc_Queue<Engine_Command, ENGINE_COMMAND_QUEUE_SIZE> commands;
+    Spsc_Queue<Engine_Info, ENGINE_INFO_QUEUE_SIZE> infos;
+    Engine_Info report;          // Scratch for building infos on the engine thread.
+    u32 last_search_id;          // UI thread only.
+    std::atomic<u32> ponder_hit_id;   // Ponder search that was hit, also before the engine thread got to it.
+};
+
+//
+// --- Functions ---
+//
+// With 'tt_filepath' the table starts from the snapshot there, if there is one, and is saved back on
+// 'stop_engine()'. The path has to stay valid until then. An ENGINE_MCTS engine has no table to save,
+// and grows its tree on 'threads' threads; the alpha-beta engine searches on its service thread alone.
+Engine *start_engine(s64 hash_megabytes, const char *tt_filepath = NULL, Engine_Algorithm algorithm = ENGINE_ALPHA_BETA, s32 threads = 1);
+void stop_engine(Engine *engine);
+
+// UI thread. Never blocks: false if the command queue is full. Every command supersedes a running
+// search, so sending one also stops it right away.
+bool engine_send(Engine *engine, const Engine_Command *command);
+// 'game_keys' lead up to 'pos', oldest first; only the last FIFTY_MOVE_PLY of them are kept.
+bool engine_set_position(Engine *engine, const Position *pos, const u64 *game_keys = NULL, s32 game_key_count = 0);
+u32 engine_go(Engine *engine, const Search_Limits *limits); // Search id, 0 if the queue is full.
+bool engine_stop(Engine *engine);
+
+// UI thread. Searches the position set last, the one after the expected reply, while the opponent
+// thinks. The limits start counting at 'engine_ponder_hit()', which keeps the search with its tree
+// and table going. On a miss just send the next command; the ponder search still sends its result,
+// which is to be ignored. Even when the search is over early its result waits for the hit or a command.
+u32 engine_go_ponder(Engine *engine, const Search_Limits *limits);
+void engine_ponder_hit(Engine *engine, u32 search_id);
+
+// UI thread. Pops the oldest pending info, false when there is none.
+bool engine_poll(Engine *engine, Engine_Info *out_info);
+
+// Any thread. Counters of the running or last search, read without stopping it. An ENGINE_MCTS engine
+// has none and leaves the summary zeroed.
+void engine_search_summary(Engine *engine, Search_Summary *out_summary);
+
+#endif /* PAWN_ENGINE_H */
@@ -0,0 +1,373 @@
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "eval.h"
+
+//
+// --- Tables ---
+//
+const s32 PIECE_VALUES[7] = { 0, 0, 900, 500, 330, 320, 100 };
+
+static const s32 MATERIAL_MG[7] = { 0, 0, 900, 500, 330, 320, 100 };
+static const s32 MATERIAL_EG[7] = { 0, 0, 950, 520, 320, 300, 120 };
+
+// Game phase weight per Piece_Kind; 24 is the full set of pieces.
+static const s32 PHASE_WEIGHTS[7] = { 0, 0, 4, 2, 1, 1, 0 };
+const s32 PHASE_MAX = 24;
+
+// Piece-square tables from white's point of view, rank 8 first (index with 'square ^ 56' for white).
+static const s32 PAWN_MG[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const s32 PAWN_EG[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     80,  80,  80,  80,  80,  80,  80,  80,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     30,  30,  30,  30,  30,  30,  30,  30,
+     15,  15,  15,  15,  15,  15,  15,  15,
+      5,   5,   5,   5,   5,   5,   5,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const s32 KNIGHT_PST[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50,
+};
+
+static const s32 BISHOP_PST[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+};
+
+static const s32 ROOK_PST[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+};
+
+static const s32 QUEEN_PST[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+};
+
+static const s32 KING_MG[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+};
+
+static const s32 KING_EG[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
+
+static const s32 *PST_MG[7] = { NULL, KING_MG, QUEEN_PST, ROOK_PST, BISHOP_PST, KNIGHT_PST, PAWN_MG };
+static const s32 *PST_EG[7] = { NULL, KING_EG, QUEEN_PST, ROOK_PST, BISHOP_PST, KNIGHT_PST, PAWN_EG };
+
+// Indexed by relative rank.
+static const s32 PASSED_PAWN_MG[8] = { 0, 5, 10, 15, 25, 40, 60, 0 };
+static const s32 PASSED_PAWN_EG[8] = { 0, 10, 15, 25, 45, 75, 120, 0 };
+
+// Per attacked square, centered on a typical count.
+static const s32 MOBILITY_MG[7] = { 0, 0, 1, 2, 4, 4, 0 };
+static const s32 MOBILITY_EG[7] = { 0, 0, 2, 4, 5, 4, 0 };
+static const s32 MOBILITY_CENTER[7] = { 0, 0, 14, 7, 7, 4, 0 };
+
+const s32 BISHOP_PAIR_MG = 30;
+const s32 BISHOP_PAIR_EG = 50;
+const s32 DOUBLED_PAWN_MG = -10;
+const s32 DOUBLED_PAWN_EG = -20;
+const s32 ISOLATED_PAWN_MG = -10;
+const s32 ISOLATED_PAWN_EG = -15;
+const s32 ROOK_OPEN_FILE = 20;
+const s32 ROOK_SEMI_OPEN_FILE = 10;
+const s32 TEMPO = 10;
+
+//
+// --- Evaluation ---
+//
+static Bitboard file_bb(s32 file) {
+    return FILE_A_BB << file;
+}
+
+static Bitboard adjacent_files_bb(s32 file) {
+    return ((file > 0) ? file_bb(file - 1) : 0) | ((file < 7) ? file_bb(file + 1) : 0);
+}
+
+// Squares in front of 'square' from 'color's point of view, on the same file and both adjacent ones.
+static Bitboard passed_pawn_span(s32 color, s32 square) {
+    Bitboard files = file_bb(square_file(square)) | adjacent_files_bb(square_file(square));
+    s32 rank = square_rank(square);
+    Bitboard ahead;
+    if (color == WHITE)  ahead = (rank == 7) ? 0 : ~0ULL << (8 * (rank + 1));
+    else                 ahead = (1ULL << (8 * rank)) - 1;
+    return files & ahead;
+}
+
+// What one side's evaluation is made of before the weights are applied. Everything that is multiplied
+// by a weight is kept as a count, so evaluate() and evaluate_batch() share the extraction and only differ
+// in how they weigh it.
+struct Eval_Terms {
+    s32 base_mg;              // Material, piece-square tables and passed pawns, already weighted.
+    s32 base_eg;
+    s32 mobility[4];          // Queen, rook, bishop, knight: attacked squares over MOBILITY_CENTER, summed.
+    s32 rook_open_files;
+    s32 rook_semi_open_files;
+    s32 isolated_pawns;
+    s32 doubled_pawns;
+    s32 bishop_pair;
+    s32 phase;
+};
+
+static void extract_terms(const Position *pos, s32 us, Eval_Terms *terms) {
+    s32 them = us ^ 1;
+    Bitboard occupancy = occupied(pos);
+    Bitboard our_pawns = pieces_of(pos, us, PAWN);
+    Bitboard their_pawns = pieces_of(pos, them, PAWN);
+    Bitboard their_pawn_attacks = (them == WHITE) ? ((their_pawns << 7) & ~FILE_H_BB) | ((their_pawns << 9) & ~FILE_A_BB)
+                                                  : ((their_pawns >> 9) & ~FILE_H_BB) | ((their_pawns >> 7) & ~FILE_A_BB);
+    Bitboard mobility_area = ~(pos->colors[us] | their_pawn_attacks);
+
+    *terms = { };
+    for (s32 kind = KING; kind <= PAWN; kind++) {
+        Bitboard b = pieces_of(pos, us, kind);
+        terms->phase += PHASE_WEIGHTS[kind] * popcount(b);
+
+        while (b) {
+            s32 square = pop_lsb(&b);
+            s32 index = (us == WHITE) ? square ^ 56 : square;
+            terms->base_mg += MATERIAL_MG[kind] + PST_MG[kind][index];
+            terms->base_eg += MATERIAL_EG[kind] + PST_EG[kind][index];
+
+            Bitboard attacks = 0;
+            switch (kind) {
+                case QUEEN:  attacks = queen_attacks(square, occupancy); break;
+                case ROOK:   attacks = rook_attacks(square, occupancy); break;
+                case BISHOP: attacks = bishop_attacks(square, occupancy); break;
+                case KNIGHT: attacks = knight_attacks(square); break;
+                default: break;
+            }
+            if (attacks)  terms->mobility[kind - QUEEN] += popcount(attacks & mobility_area) - MOBILITY_CENTER[kind];
+
+            if (kind == ROOK) {
+                Bitboard file = file_bb(square_file(square));
+                if (!(file & our_pawns)) {
+                    if (file & their_pawns)  terms->rook_semi_open_files++;
+                    else                     terms->rook_open_files++;
+                }
+            }
+
+            if (kind == PAWN) {
+                s32 file = square_file(square);
+                if (!(adjacent_files_bb(file) & our_pawns))  terms->isolated_pawns++;
+                if (!(passed_pawn_span(us, square) & their_pawns)) {
+                    s32 rank = relative_rank(us, square);
+                    terms->base_mg += PASSED_PAWN_MG[rank];
+                    terms->base_eg += PASSED_PAWN_EG[rank];
+                }
+            }
+        }
+    }
+
+    For (8 /*files*/) {
+        if (more_than_one(our_pawns & file_bb(it)))  terms->doubled_pawns++;
+    }
+
+    if (more_than_one(pieces_of(pos, us, BISHOP)))  terms->bishop_pair = 1;
+}
+
+static void weigh_terms(const Eval_Terms *terms, s32 *mg, s32 *eg) {
+    *mg = terms->base_mg + ROOK_OPEN_FILE * terms->rook_open_files + ROOK_SEMI_OPEN_FILE * terms->rook_semi_open_files
+        + ISOLATED_PAWN_MG * terms->isolated_pawns + DOUBLED_PAWN_MG * terms->doubled_pawns + BISHOP_PAIR_MG * terms->bishop_pair;
+    *eg = terms->base_eg
+        + ISOLATED_PAWN_EG * terms->isolated_pawns + DOUBLED_PAWN_EG * terms->doubled_pawns + BISHOP_PAIR_EG * terms->bishop_pair;
+    for (s32 kind = QUEEN; kind <= KNIGHT; kind++) {
+        *mg += MOBILITY_MG[kind] * terms->mobility[kind - QUEEN];
+        *eg += MOBILITY_EG[kind] * terms->mobility[kind - QUEEN];
+    }
+}
+
+s32 evaluate(const Position *pos) {
+    Eval_Terms terms[2];
+    extract_terms(pos, WHITE, &terms[WHITE]);
+    extract_terms(pos, BLACK, &terms[BLACK]);
+
+    s32 mg[2], eg[2];
+    weigh_terms(&terms[WHITE], &mg[WHITE], &eg[WHITE]);
+    weigh_terms(&terms[BLACK], &mg[BLACK], &eg[BLACK]);
+    s32 phase = terms[WHITE].phase + terms[BLACK].phase;
+    if (phase > PHASE_MAX)  phase = PHASE_MAX;
+
+    s32 us = pos->side_to_move;
+    s32 them = us ^ 1;
+    s32 score = ((mg[us] - mg[them]) * phase + (eg[us] - eg[them]) * (PHASE_MAX - phase)) / PHASE_MAX;
+    return score + TEMPO;
+}
+
+//
+// --- Batch Evaluation ---
+//
+const s32 EVAL_BLOCK = 64; // Positions extracted before they are weighed, a multiple of 8 lanes.
+
+// Terms of a block of positions, white minus black, one array per term.
+struct Eval_Block {
+    s32 base_mg[EVAL_BLOCK];
+    s32 base_eg[EVAL_BLOCK];
+    s32 mobility[4][EVAL_BLOCK];
+    s32 rook_open_files[EVAL_BLOCK];
+    s32 rook_semi_open_files[EVAL_BLOCK];
+    s32 isolated_pawns[EVAL_BLOCK];
+    s32 doubled_pawns[EVAL_BLOCK];
+    s32 bishop_pair[EVAL_BLOCK];
+    s32 phase[EVAL_BLOCK];
+    s32 sign[EVAL_BLOCK];     // +1 when white is to move, -1 when black is.
+    s32 scores[EVAL_BLOCK];
+};
+
+static void extract_block(Eval_Block *block, s32 lane, const Position *pos) {
+    Eval_Terms terms[2];
+    extract_terms(pos, WHITE, &terms[WHITE]);
+    extract_terms(pos, BLACK, &terms[BLACK]);
+    const Eval_Terms *w = &terms[WHITE];
+    const Eval_Terms *b = &terms[BLACK];
+
+    block->base_mg[lane] = w->base_mg - b->base_mg;
+    block->base_eg[lane] = w->base_eg - b->base_eg;
+    For (4)  block->mobility[it][lane] = w->mobility[it] - b->mobility[it];
+    block->rook_open_files[lane] = w->rook_open_files - b->rook_open_files;
+    block->rook_semi_open_files[lane] = w->rook_semi_open_files - b->rook_semi_open_files;
+    block->isolated_pawns[lane] = w->isolated_pawns - b->isolated_pawns;
+    block->doubled_pawns[lane] = w->doubled_pawns - b->doubled_pawns;
+    block->bishop_pair[lane] = w->bishop_pair - b->bishop_pair;
+    block->phase[lane] = w->phase + b->phase;
+    block->sign[lane] = (pos->side_to_move == WHITE) ? 1 : -1;
+}
+
+// Weighs 'lanes' positions of the block, a multiple of 8. The taper is symmetric in the sign, so it is
+// computed from white's point of view and flipped afterwards, which gives the same truncation as evaluate().
+static void weigh_block(Eval_Block *block, s32 lanes) {
+#if defined(__AVX2__)
+    // Tapered scores stay far below 2^24, so the float division is exact before it is truncated.
+    const __m256i phase_max = _mm256_set1_epi32(PHASE_MAX);
+    const __m256 phase_max_ps = _mm256_set1_ps((float)PHASE_MAX);
+    const __m256i tempo = _mm256_set1_epi32(TEMPO);
+    for (s32 i = 0; i < lanes; i += 8) {
+#define LOAD(array) _mm256_loadu_si256((const __m256i *)&(array)[i])
+#define WEIGH(sum, weight, array) sum = _mm256_add_epi32(sum, _mm256_mullo_epi32(_mm256_set1_epi32(weight), LOAD(array)))
+        __m256i mg = LOAD(block->base_mg);
+        __m256i eg = LOAD(block->base_eg);
+        WEIGH(mg, ROOK_OPEN_FILE, block->rook_open_files);
+        WEIGH(mg, ROOK_SEMI_OPEN_FILE, block->rook_semi_open_files);
+        WEIGH(mg, ISOLATED_PAWN_MG, block->isolated_pawns);
+        WEIGH(eg, ISOLATED_PAWN_EG, block->isolated_pawns);
+        WEIGH(mg, DOUBLED_PAWN_MG, block->doubled_pawns);
+        WEIGH(eg, DOUBLED_PAWN_EG, block->doubled_pawns);
+        WEIGH(mg, BISHOP_PAIR_MG, block->bishop_pair);
+        WEIGH(eg, BISHOP_PAIR_EG, block->bishop_pair);
+        for (s32 kind = QUEEN; kind <= KNIGHT; kind++) {
+            WEIGH(mg, MOBILITY_MG[kind], block->mobility[kind - QUEEN]);
+            WEIGH(eg, MOBILITY_EG[kind], block->mobility[kind - QUEEN]);
+        }
+
+        __m256i phase = _mm256_min_epi32(LOAD(block->phase), phase_max);
+        __m256i tapered = _mm256_add_epi32(_mm256_mullo_epi32(mg, phase), _mm256_mullo_epi32(eg, _mm256_sub_epi32(phase_max, phase)));
+        __m256i score = _mm256_cvttps_epi32(_mm256_div_ps(_mm256_cvtepi32_ps(tapered), phase_max_ps));
+        score = _mm256_add_epi32(_mm256_sign_epi32(score, LOAD(block->sign)), tempo);
+        _mm256_storeu_si256((__m256i *)&block->scores[i], score);
+#undef WEIGH
+#undef LOAD
+    }
+#else
+    // The same weigh_terms() as evaluate(), so only the AVX2 path keeps a copy of the weights; 'pawn check'
+    // compares it against evaluate().
+    for (s32 i = 0; i < lanes; i++) {
+        Eval_Terms terms;
+        terms.base_mg = block->base_mg[i];
+        terms.base_eg = block->base_eg[i];
+        For (4)  terms.mobility[it] = block->mobility[it][i];
+        terms.rook_open_files = block->rook_open_files[i];
+        terms.rook_semi_open_files = block->rook_semi_open_files[i];
+        terms.isolated_pawns = block->isolated_pawns[i];
+        terms.doubled_pawns = block->doubled_pawns[i];
+        terms.bishop_pair = block->bishop_pair[i];
+        terms.phase = block->phase[i];
+
+        s32 mg, eg;
+        weigh_terms(&terms, &mg, &eg);
+
+        s32 phase = (block->phase[i] > PHASE_MAX) ? PHASE_MAX : block->phase[i];
+        s32 score = (mg * phase + eg * (PHASE_MAX - phase)) / PHASE_MAX;
+        block->scores[i] = block->sign[i] * score + TEMPO;
+    }
+#endif
+}
+
+void evaluate_batch(const Position *positions, s64 count, s32 *out_scores) {
+    ZoneScoped;
+
+    Eval_Block block;
+    for (s64 first = 0; first < count; first += EVAL_BLOCK) {
+        s32 lanes = (count - first < EVAL_BLOCK) ? (s32)(count - first) : EVAL_BLOCK;
+        For (lanes)  extract_block(&block, it, &positions[first + it]);
+
+        // Pad the last block to whole vectors with empty lanes.
+        s32 padded = (lanes + 7) & ~7;
+        for (s32 lane = lanes; lane < padded; lane++) {
+            block.base_mg[lane] = block.base_eg[lane] = 0;
+            For (4)  block.mobility[it][lane] = 0;
+            block.rook_open_files[lane] = block.rook_semi_open_files[lane] = 0;
+            block.isolated_pawns[lane] = block.doubled_pawns[lane] = block.bishop_pair[lane] = 0;
+            block.phase[lane] = 0;
+            block.sign[lane] = 1;
+        }
+
+        weigh_block(&block, padded);
+        memcpy(out_scores + first, block.scores, lanes * sizeof(s32));
+    }
+}
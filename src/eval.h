@@ -0,0 +1,22 @@
+#ifndef PAWN_EVAL_H
+#define PAWN_EVAL_H
+
+#include "position.h"
+
+//
+// --- Constants ---
+//
+extern const s32 PIECE_VALUES[7]; // Midgame material by Piece_Kind, used for move ordering too.
+
+//
+// --- Functions ---
+//
+
+// Static evaluation in centipawns from the point of view of the side to move.
+s32 evaluate(const Position *pos);
+
+// Same scores as evaluate() for 'count' unrelated positions, for tuning and dataset filtering. The terms
+// of a block of positions are extracted into one array each and weighed together with AVX2 when available.
+void evaluate_batch(const Position *positions, s64 count, s32 *out_scores);
+
+#endif /* PAWN_EVAL_H */
@@ -0,0 +1,507 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "fen.h"
+#include "notation.h"
+
+const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+//
+// --- Structs ---
+//
+
+// Lines starting in [start, end) belong to the chunk.
+struct Epd_Chunk {
+    s64 start;
+    s64 end;
+    s64 line_count;
+    s64 first_record;
+    s64 record_count;
+};
+
+struct Epd_Job {
+    const char *text;
+    Epd_Chunk *chunks;
+    s32 chunk_count;
+    Epd_Record *records;      // NULL while lines are being counted.
+    std::atomic<s32> next_chunk;
+};
+
+const s64 EPD_CHUNK_SIZE = 1 << 20;
+
+//
+// --- Helpers ---
+//
+static const char PIECE_CHARS[] = " KQRBNP";
+
+static inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static Piece_Code char_to_piece(char c) {
+    switch (c) {
+        case 'K': return make_piece(WHITE, KING);
+        case 'Q': return make_piece(WHITE, QUEEN);
+        case 'R': return make_piece(WHITE, ROOK);
+        case 'B': return make_piece(WHITE, BISHOP);
+        case 'N': return make_piece(WHITE, KNIGHT);
+        case 'P': return make_piece(WHITE, PAWN);
+        case 'k': return make_piece(BLACK, KING);
+        case 'q': return make_piece(BLACK, QUEEN);
+        case 'r': return make_piece(BLACK, ROOK);
+        case 'b': return make_piece(BLACK, BISHOP);
+        case 'n': return make_piece(BLACK, KNIGHT);
+        case 'p': return make_piece(BLACK, PAWN);
+        default:  return NO_PIECE;
+    }
+}
+
+static char piece_to_char(Piece_Code piece) {
+    char c = PIECE_CHARS[piece_kind(piece)];
+    return (piece_color(piece) == BLACK) ? (char)(c + ('a' - 'A')) : c;
+}
+
+static const char *skip_blanks(const char *p, const char *end) {
+    while (p < end && is_blank(*p))  p++;
+    return p;
+}
+
+static const char *parse_number(const char *p, const char *end, s32 *out_value) {
+    if (p >= end || *p < '0' || *p > '9')  return NULL;
+    s32 value = 0;
+    while (p < end && *p >= '0' && *p <= '9') {
+        if (value < 100000)  value = value * 10 + (*p - '0');
+        p++;
+    }
+    *out_value = value;
+    return p;
+}
+
+static void sanitize_castling(Position *pos) {
+    if (pos->board[E1] != make_piece(WHITE, KING))  pos->castling &= ~(CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN);
+    if (pos->board[E8] != make_piece(BLACK, KING))  pos->castling &= ~(CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN);
+    if (pos->board[H1] != make_piece(WHITE, ROOK))  pos->castling &= ~CASTLE_WHITE_KING;
+    if (pos->board[A1] != make_piece(WHITE, ROOK))  pos->castling &= ~CASTLE_WHITE_QUEEN;
+    if (pos->board[H8] != make_piece(BLACK, ROOK))  pos->castling &= ~CASTLE_BLACK_KING;
+    if (pos->board[A8] != make_piece(BLACK, ROOK))  pos->castling &= ~CASTLE_BLACK_QUEEN;
+}
+
+//
+// --- FEN ---
+//
+const char *parse_fen(Position *pos, const char *text, const char *end) {
+    clear_position(pos);
+
+    const char *p = skip_blanks(text, end);
+
+    // Piece placement, rank 8 first.
+    s32 rank = 7;
+    s32 file = 0;
+    for (; p < end && !is_blank(*p); p++) {
+        char c = *p;
+        if (c == '/') {
+            if (file != 8 || rank == 0)  return NULL;
+            rank--;
+            file = 0;
+        } else if (c >= '1' && c <= '8') {
+            file += c - '0';
+            if (file > 8)  return NULL;
+        } else {
+            Piece_Code piece = char_to_piece(c);
+            if (piece == NO_PIECE || file >= 8)  return NULL;
+            put_piece(pos, piece, make_square(file, rank));
+            file++;
+        }
+    }
+    if (rank != 0 || file != 8)  return NULL;
+
+    // Side to move.
+    p = skip_blanks(p, end);
+    if (p >= end)  return NULL;
+    if (*p == 'w')       pos->side_to_move = WHITE;
+    else if (*p == 'b')  pos->side_to_move = BLACK;
+    else return NULL;
+    p++;
+
+    // Castling rights.
+    p = skip_blanks(p, end);
+    if (p >= end)  return NULL;
+    if (*p == '-') {
+        p++;
+    } else {
+        for (; p < end && !is_blank(*p); p++) {
+            switch (*p) {
+                case 'K': pos->castling |= CASTLE_WHITE_KING; break;
+                case 'Q': pos->castling |= CASTLE_WHITE_QUEEN; break;
+                case 'k': pos->castling |= CASTLE_BLACK_KING; break;
+                case 'q': pos->castling |= CASTLE_BLACK_QUEEN; break;
+                default:  return NULL;
+            }
+        }
+    }
+    sanitize_castling(pos);
+
+    // En passant target.
+    p = skip_blanks(p, end);
+    if (p >= end)  return NULL;
+    s32 ep_square = NO_SQUARE;
+    if (*p == '-') {
+        p++;
+    } else {
+        if (p + 1 >= end || p[0] < 'a' || p[0] > 'h' || (p[1] != '3' && p[1] != '6'))  return NULL;
+        ep_square = make_square(p[0] - 'a', p[1] - '1');
+        p += 2;
+    }
+
+    // Optional halfmove clock and fullmove number; EPD has opcodes here instead.
+    const char *after = skip_blanks(p, end);
+    s32 halfmove = 0;
+    s32 fullmove = 1;
+    const char *number_end = parse_number(after, end, &halfmove);
+    if (number_end) {
+        p = number_end;
+        number_end = parse_number(skip_blanks(p, end), end, &fullmove);
+        if (number_end)  p = number_end;
+    }
+    pos->halfmove_clock = (u16)halfmove;
+    pos->fullmove_number = (u16)((fullmove > 0) ? fullmove : 1);
+
+    if (!is_valid_position(pos))  return NULL;
+
+    // Only keep an en passant square behind a pawn that just made a double push.
+    if (ep_square != NO_SQUARE) {
+        s32 us = pos->side_to_move;
+        s32 pushed = (us == WHITE) ? ep_square - 8 : ep_square + 8;
+        if (relative_rank(us, ep_square) != 5 || pos->board[ep_square] != NO_PIECE || pos->board[pushed] != make_piece(us ^ 1, PAWN)) {
+            ep_square = NO_SQUARE;
+        }
+    }
+
+    pos->key = compute_key(pos);
+    update_ep_square(pos, ep_square);
+    return p;
+}
+
+bool parse_fen(Position *pos, const char *text) {
+    return parse_fen(pos, text, text + strlen(text)) != NULL;
+}
+
+s32 position_to_epd(const Position *pos, char *buffer) {
+    s32 size = 0;
+    for (s32 rank = 7; rank >= 0; rank--) {
+        s32 empty = 0;
+        For (8 /*files*/) {
+            Piece_Code piece = pos->board[make_square(it, rank)];
+            if (piece == NO_PIECE) {
+                empty++;
+                continue;
+            }
+            if (empty > 0)  buffer[size++] = (char)('0' + empty);
+            empty = 0;
+            buffer[size++] = piece_to_char(piece);
+        }
+        if (empty > 0)  buffer[size++] = (char)('0' + empty);
+        if (rank > 0)   buffer[size++] = '/';
+    }
+
+    buffer[size++] = ' ';
+    buffer[size++] = (pos->side_to_move == WHITE) ? 'w' : 'b';
+
+    buffer[size++] = ' ';
+    if (pos->castling == 0)                  buffer[size++] = '-';
+    if (pos->castling & CASTLE_WHITE_KING)   buffer[size++] = 'K';
+    if (pos->castling & CASTLE_WHITE_QUEEN)  buffer[size++] = 'Q';
+    if (pos->castling & CASTLE_BLACK_KING)   buffer[size++] = 'k';
+    if (pos->castling & CASTLE_BLACK_QUEEN)  buffer[size++] = 'q';
+
+    buffer[size++] = ' ';
+    if (pos->ep_square == NO_SQUARE) {
+        buffer[size++] = '-';
+    } else {
+        buffer[size++] = (char)('a' + square_file(pos->ep_square));
+        buffer[size++] = (char)('1' + square_rank(pos->ep_square));
+    }
+
+    buffer[size] = '\0';
+    return size;
+}
+
+s32 position_to_fen(const Position *pos, char *buffer) {
+    s32 size = position_to_epd(pos, buffer);
+    size += snprintf(buffer + size, (size_t)(FEN_MAX_SIZE - size), " %d %d", (int)pos->halfmove_clock, (int)pos->fullmove_number);
+    return size;
+}
+
+//
+// --- EPD ---
+//
+
+// Reads a move list operand up to ';' into 'moves' and returns where it stopped.
+static const char *parse_epd_moves(const Position *pos, const char *p, const char *end, Move *moves, s32 *out_count, bool *out_ok) {
+    s32 count = 0;
+    for (;;) {
+        p = skip_blanks(p, end);
+        if (p >= end || *p == ';')  break;
+
+        const char *token = p;
+        while (p < end && !is_blank(*p) && *p != ';')  p++;
+
+        Move move = parse_san_move(pos, token, (s32)(p - token));
+        if (move == MOVE_NONE) {
+            *out_ok = false;
+            continue;
+        }
+        if (count < EPD_MAX_MOVES)  moves[count++] = move;
+    }
+    *out_count = count;
+    return p;
+}
+
+// Reads a string operand ("..." or a bare word) up to ';'. Escapes are kept as written.
+static const char *parse_epd_string(const char *p, const char *end, const char **out_text, s32 *out_size) {
+    p = skip_blanks(p, end);
+    const char *text = p;
+    if (p < end && *p == '"') {
+        text = ++p;
+        while (p < end && *p != '"') {
+            if (*p == '\\' && p + 1 < end)  p++;
+            p++;
+        }
+        *out_text = text;
+        *out_size = (s32)(p - text);
+        if (p < end)  p++;
+    } else {
+        while (p < end && *p != ';')  p++;
+        const char *text_end = p;
+        while (text_end > text && is_blank(text_end[-1]))  text_end--;
+        *out_text = text;
+        *out_size = (s32)(text_end - text);
+    }
+    return p;
+}
+
+bool parse_epd_line(const char *text, const char *end, Epd_Record *record) {
+    record->best_move_count = 0;
+    record->avoid_move_count = 0;
+    record->direct_mate = 0;
+    record->id = NULL;
+    record->comment = NULL;
+    record->id_size = 0;
+    record->comment_size = 0;
+
+    const char *p = parse_fen(&record->position, text, end);
+    if (!p)  return false;
+
+    bool ok = true;
+    for (;;) {
+        p = skip_blanks(p, end);
+        if (p >= end)  break;
+        if (*p == ';') {
+            p++;
+            continue;
+        }
+
+        const char *opcode = p;
+        while (p < end && !is_blank(*p) && *p != ';')  p++;
+        s64 opcode_size = p - opcode;
+
+        if (opcode_size == 2 && memcmp(opcode, "bm", 2) == 0) {
+            p = parse_epd_moves(&record->position, p, end, record->best_moves, &record->best_move_count, &ok);
+        } else if (opcode_size == 2 && memcmp(opcode, "am", 2) == 0) {
+            p = parse_epd_moves(&record->position, p, end, record->avoid_moves, &record->avoid_move_count, &ok);
+        } else if (opcode_size == 2 && memcmp(opcode, "id", 2) == 0) {
+            p = parse_epd_string(p, end, &record->id, &record->id_size);
+        } else if (opcode_size == 2 && memcmp(opcode, "c0", 2) == 0) {
+            p = parse_epd_string(p, end, &record->comment, &record->comment_size);
+        } else if (opcode_size == 2 && memcmp(opcode, "dm", 2) == 0) {
+            const char *number_end = parse_number(skip_blanks(p, end), end, &record->direct_mate);
+            if (!number_end)  return false;
+            p = number_end;
+        } else if (opcode_size == 4 && (memcmp(opcode, "hmvc", 4) == 0 || memcmp(opcode, "fmvn", 4) == 0)) {
+            s32 value;
+            const char *number_end = parse_number(skip_blanks(p, end), end, &value);
+            if (!number_end)  return false;
+            if (opcode[0] == 'h')  record->position.halfmove_clock = (u16)value;
+            else                   record->position.fullmove_number = (u16)((value > 0) ? value : 1);
+            p = number_end;
+        } else {
+            // Unknown opcode: skip operands, keeping quoted ';' intact.
+            while (p < end && *p != ';') {
+                if (*p == '"') {
+                    p++;
+                    while (p < end && *p != '"')  p++;
+                }
+                if (p < end)  p++;
+            }
+        }
+    }
+    return ok;
+}
+
+static bool append_text(char *buffer, s32 buffer_size, s32 *size, const char *text, s32 text_size) {
+    if (*size + text_size >= buffer_size)  return false;
+    memcpy(buffer + *size, text, (size_t)text_size);
+    *size += text_size;
+    return true;
+}
+
+static bool append_moves(const Position *pos, const char *opcode, const Move *moves, s32 count, char *buffer, s32 buffer_size, s32 *size) {
+    if (count == 0)  return true;
+    if (!append_text(buffer, buffer_size, size, opcode, (s32)strlen(opcode)))  return false;
+    For (count) {
+        char san[MOVE_TEXT_SIZE];
+        s32 san_size = move_to_san(pos, moves[it], san);
+        if (!append_text(buffer, buffer_size, size, " ", 1) || !append_text(buffer, buffer_size, size, san, san_size))  return false;
+    }
+    return append_text(buffer, buffer_size, size, ";", 1);
+}
+
+static bool append_string(const char *opcode, const char *text, s32 text_size, char *buffer, s32 buffer_size, s32 *size) {
+    if (!text)  return true;
+    return append_text(buffer, buffer_size, size, opcode, (s32)strlen(opcode))
+        && append_text(buffer, buffer_size, size, text, text_size)
+        && append_text(buffer, buffer_size, size, "\";", 2);
+}
+
+s32 epd_record_to_string(const Epd_Record *record, char *buffer, s32 buffer_size) {
+    const Position *pos = &record->position;
+    if (buffer_size < FEN_MAX_SIZE)  return -1;
+
+    s32 size = position_to_epd(pos, buffer);
+    bool ok = append_moves(pos, " bm", record->best_moves, record->best_move_count, buffer, buffer_size, &size)
+           && append_moves(pos, " am", record->avoid_moves, record->avoid_move_count, buffer, buffer_size, &size)
+           && append_string(" id \"", record->id, record->id_size, buffer, buffer_size, &size)
+           && append_string(" c0 \"", record->comment, record->comment_size, buffer, buffer_size, &size);
+
+    if (ok && (pos->halfmove_clock != 0 || pos->fullmove_number != 1)) {
+        char counters[32];
+        s32 counters_size = snprintf(counters, sizeof(counters), " hmvc %d; fmvn %d;", (int)pos->halfmove_clock, (int)pos->fullmove_number);
+        ok = append_text(buffer, buffer_size, &size, counters, counters_size);
+    }
+    if (!ok)  return -1;
+
+    buffer[size] = '\0';
+    return size;
+}
+
+//
+// --- Batch loading ---
+//
+static void epd_worker_proc(void *data) {
+    ZoneScoped;
+
+    Epd_Job *job = (Epd_Job *)data;
+    for (;;) {
+        s32 index = job->next_chunk.fetch_add(1);
+        if (index >= job->chunk_count)  break;
+        Epd_Chunk *chunk = &job->chunks[index];
+
+        const char *p = job->text + chunk->start;
+        const char *end = job->text + chunk->end;
+        if (!job->records) {
+            // First pass: count lines, so every chunk knows where its records go.
+            s64 lines = 0;
+            while (p < end) {
+                const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+                lines++;
+                if (!newline)  break;
+                p = newline + 1;
+            }
+            chunk->line_count = lines;
+            continue;
+        }
+
+        Epd_Record *out = job->records + chunk->first_record;
+        s64 count = 0;
+        while (p < end) {
+            const char *newline = (const char *)memchr(p, '\n', (size_t)(end - p));
+            const char *line_end = newline ? newline : end;
+
+            const char *first = skip_blanks(p, line_end);
+            if (first < line_end && *first != '#' && parse_epd_line(first, line_end, &out[count]))  count++;
+
+            p = line_end + 1;
+        }
+        chunk->record_count = count;
+    }
+}
+
+static void run_epd_workers(Epd_Job *job, Thread *threads, s32 thread_count) {
+    job->next_chunk.store(0);
+    if (thread_count == 1) {
+        epd_worker_proc(job);
+        return;
+    }
+    For (thread_count)  threads[it] = create_thread(epd_worker_proc, job);
+    For (thread_count)  join_thread(&threads[it]);
+}
+
+bool load_epd_file(const char *filepath, Epd_File *out_epd, s32 threads) {
+    ZoneScoped;
+
+    *out_epd = { };
+    if (!map_file(filepath, &out_epd->file))  return false;
+
+    const char *text = out_epd->file.data;
+    s64 size = out_epd->file.size;
+
+    // Chunk borders are moved forward to line starts.
+    s32 chunk_count = (s32)((size + EPD_CHUNK_SIZE - 1) / EPD_CHUNK_SIZE);
+    Epd_Chunk *chunks = ALLOC(sys_allocator, chunk_count + 1, Epd_Chunk);
+    defer { FREE(sys_allocator, chunks); };
+    For (chunk_count) {
+        s64 start = it * EPD_CHUNK_SIZE;
+        if (it > 0) {
+            const char *newline = (const char *)memchr(text + start - 1, '\n', (size_t)(size - start + 1));
+            start = newline ? (newline - text) + 1 : size;
+            if (start < chunks[it - 1].start)  start = chunks[it - 1].start;
+        }
+        chunks[it].start = start;
+    }
+    For (chunk_count) {
+        chunks[it].end = (it + 1 < chunk_count) ? chunks[it + 1].start : size;
+    }
+
+    s32 thread_count = (threads > 0) ? threads : get_cpu_count();
+    if (thread_count > chunk_count)  thread_count = (chunk_count > 0) ? chunk_count : 1;
+    Thread *worker_threads = ALLOC(sys_allocator, thread_count, Thread);
+    defer { FREE(sys_allocator, worker_threads); };
+
+    Epd_Job job;
+    job.text = text;
+    job.chunks = chunks;
+    job.chunk_count = chunk_count;
+    job.records = NULL;
+    run_epd_workers(&job, worker_threads, thread_count);
+
+    s64 line_count = 0;
+    For (chunk_count) {
+        chunks[it].first_record = line_count;
+        line_count += chunks[it].line_count;
+    }
+
+    out_epd->records = ALLOC(sys_allocator, (line_count > 0) ? line_count : 1, Epd_Record);
+    job.records = out_epd->records;
+    run_epd_workers(&job, worker_threads, thread_count);
+
+    // Close the gaps left by skipped lines.
+    s64 count = 0;
+    For (chunk_count) {
+        Epd_Chunk *chunk = &chunks[it];
+        if (count != chunk->first_record) {
+            memmove(out_epd->records + count, out_epd->records + chunk->first_record, (size_t)chunk->record_count * sizeof(Epd_Record));
+        }
+        count += chunk->record_count;
+    }
+    out_epd->count = count;
+    out_epd->skipped_lines = line_count - count;
+    return true;
+}
+
+void free_epd_file(Epd_File *epd) {
+    if (epd->records)  FREE(sys_allocator, epd->records);
+    unmap_file(&epd->file);
+    *epd = { };
+}
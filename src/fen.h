@@ -0,0 +1,68 @@
+#ifndef PAWN_FEN_H
+#define PAWN_FEN_H
+
+#include "position.h"
+#include "platform.h"
+
+//
+// --- Constants ---
+//
+const int FEN_MAX_SIZE = 128;     // Longest FEN/EPD position text plus the terminator.
+const int EPD_MAX_MOVES = 8;      // Per 'bm'/'am' opcode; extra moves are dropped.
+
+extern const char *START_FEN;
+
+//
+// --- Structs ---
+//
+
+// Opcode strings point into the loaded text, quotes stripped.
+struct Epd_Record {
+    Position position;
+    Move best_moves[EPD_MAX_MOVES];   // "bm"
+    Move avoid_moves[EPD_MAX_MOVES];  // "am"
+    s32 best_move_count;
+    s32 avoid_move_count;
+    s32 direct_mate;                  // "dm", moves to mate, 0 if missing.
+    const char *id;                   // "id", NULL if missing.
+    const char *comment;              // "c0", NULL if missing.
+    s32 id_size;
+    s32 comment_size;
+};
+
+struct Epd_File {
+    Mapped_File file;                 // Kept mapped for the opcode strings.
+    Epd_Record *records;
+    s64 count;
+    s64 skipped_lines;                // Blank, '#' comment or invalid lines.
+};
+
+//
+// --- Functions ---
+//
+
+// Accepts both 6-field FEN and 4-field EPD positions (halfmove clock 0, fullmove number 1).
+// 'text' doesn't need to be NUL-terminated; parsing stops at 'end' or at the first character after the position.
+// Castling rights without the king and rook on their home squares are dropped, an en passant square
+// is kept only when it can be captured. Returns NULL on malformed text or an impossible position.
+const char *parse_fen(Position *pos, const char *text, const char *end);
+bool parse_fen(Position *pos, const char *text);
+
+// Both write into 'buffer' of at least FEN_MAX_SIZE bytes and return the length.
+s32 position_to_fen(const Position *pos, char *buffer);
+s32 position_to_epd(const Position *pos, char *buffer); // Just the four position fields.
+
+// Parses one line ("<position> bm Nf3; id \"x\";"), 'end' being the end of the line.
+// Understands 'bm', 'am', 'id', 'c0', 'hmvc' and 'fmvn'; other opcodes are skipped.
+bool parse_epd_line(const char *text, const char *end, Epd_Record *record);
+
+// Writes the record back as one EPD line (no newline), moves in SAN. Returns the length,
+// or -1 if it doesn't fit into 'buffer_size' bytes.
+s32 epd_record_to_string(const Epd_Record *record, char *buffer, s32 buffer_size);
+
+// Memory-maps the file and parses every line on 'threads' workers (0 uses every core) into
+// one contiguous array, in file order.
+bool load_epd_file(const char *filepath, Epd_File *out_epd, s32 threads = 0);
+void free_epd_file(Epd_File *epd);
+
+#endif /* PAWN_FEN_H */
@@ -0,0 +1,53 @@
+#include "history.h"
+
+//
+// --- Interface ---
+//
+void reset_history(Game_History *history, const Position *pos) {
+    history->start = *pos;
+    history->position = *pos;
+    history->ply = 0;
+    history->ply_count = 0;
+}
+
+bool history_make_move(Game_History *history, Move move) {
+    if (history->ply >= MAX_GAME_PLY)  return false;
+
+    s32 ply = history->ply;
+    if (ply < history->ply_count && history->moves[ply] == move) {
+        return history_redo(history);
+    }
+
+    history->moves[ply] = move;
+    make_move(&history->position, move, &history->undo[ply]);
+    history->ply = ply + 1;
+    history->ply_count = ply + 1;
+    return true;
+}
+
+bool history_undo(Game_History *history) {
+    if (!can_undo(history))  return false;
+
+    history->ply--;
+    unmake_move(&history->position, history->moves[history->ply], &history->undo[history->ply]);
+    return true;
+}
+
+bool history_redo(Game_History *history) {
+    if (!can_redo(history))  return false;
+
+    make_move(&history->position, history->moves[history->ply], &history->undo[history->ply]);
+    history->ply++;
+    return true;
+}
+
+void history_go_to(Game_History *history, s32 ply) {
+    while (history->ply > ply && history_undo(history)) { }
+    while (history->ply < ply && history_redo(history)) { }
+}
+
+s32 get_history_keys(const Game_History *history, u64 *keys) {
+    s32 first = (history->ply > FIFTY_MOVE_PLY) ? history->ply - FIFTY_MOVE_PLY : 0;
+    for (s32 i = first; i < history->ply; i++)  keys[i - first] = history->undo[i].key;
+    return history->ply - first;
+}
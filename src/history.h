@@ -0,0 +1,48 @@
+#ifndef PAWN_HISTORY_H
+#define PAWN_HISTORY_H
+
+#include "common.h"
+#include "position.h"
+
+//
+// --- Constants ---
+//
+const int MAX_GAME_PLY = 1024;
+
+//
+// --- Structs ---
+//
+
+// Moves of one game from 'start', with what each move destroyed so it can be taken back.
+// Plies [0, ply) are played into 'position', plies [ply, ply_count) are kept for redo until a
+// different move is made. 'undo[i].key' is the key of the position before move i.
+struct Game_History {
+    Position start;
+    Position position;
+    s32 ply;
+    s32 ply_count;
+    Move moves[MAX_GAME_PLY];
+    Undo_Info undo[MAX_GAME_PLY];
+};
+
+//
+// --- Functions ---
+//
+void reset_history(Game_History *history, const Position *pos);
+
+// Plays a legal move, dropping the moves kept for redo unless it is the next one of them.
+// False when the history is full.
+bool history_make_move(Game_History *history, Move move);
+bool history_undo(Game_History *history);
+bool history_redo(Game_History *history);
+// Undoes or redoes moves until 'ply' moves are played, for replaying the game.
+void history_go_to(Game_History *history, s32 ply);
+
+// Copies the keys of the positions before the current one, at most the last FIFTY_MOVE_PLY, oldest first.
+s32 get_history_keys(const Game_History *history, u64 *keys);
+
+inline bool can_undo(const Game_History *history) { return history->ply > 0; }
+inline bool can_redo(const Game_History *history) { return history->ply < history->ply_count; }
+inline Move last_move(const Game_History *history) { return (history->ply > 0) ? history->moves[history->ply - 1] : MOVE_NONE; }
+
+#endif /* PAWN_HISTORY_H */
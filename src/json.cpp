@@ -0,0 +1,104 @@
+#include <string.h>
+
+#include "json.h"
+
+static void write_escaped(FILE *file, const char *text, s64 size) {
+    fputc('"', file);
+    for (s64 i = 0; i < size; i++) {
+        unsigned char c = (unsigned char)text[i];
+        switch (c) {
+            case '"':  fputs("\\\"", file); break;
+            case '\\': fputs("\\\\", file); break;
+            case '\n': fputs("\\n", file); break;
+            case '\r': fputs("\\r", file); break;
+            case '\t': fputs("\\t", file); break;
+            default:
+                if (c < 0x20)  fprintf(file, "\\u%04x", c);
+                else           fputc(c, file);
+        }
+    }
+    fputc('"', file);
+}
+
+// Comma, newline, indentation and key in front of every value.
+static void begin_value(Json_Writer *writer, const char *key) {
+    if (writer->depth > 0) {
+        if (writer->has_items[writer->depth])  fputc(',', writer->file);
+        fputc('\n', writer->file);
+        For (writer->depth)  fputs("  ", writer->file);
+    }
+    writer->has_items[writer->depth] = true;
+
+    if (key) {
+        write_escaped(writer->file, key, (s64)strlen(key));
+        fputs(": ", writer->file);
+    }
+}
+
+static void begin_scope(Json_Writer *writer, const char *key, char bracket) {
+    begin_value(writer, key);
+    fputc(bracket, writer->file);
+    assert(writer->depth + 1 < JSON_MAX_DEPTH && "JSON nested too deep.");
+    writer->depth++;
+    writer->has_items[writer->depth] = false;
+}
+
+static void end_scope(Json_Writer *writer, char bracket) {
+    bool had_items = writer->has_items[writer->depth];
+    writer->depth--;
+    if (had_items) {
+        fputc('\n', writer->file);
+        For (writer->depth)  fputs("  ", writer->file);
+    }
+    fputc(bracket, writer->file);
+}
+
+void json_begin(Json_Writer *writer, FILE *file) {
+    writer->file = file;
+    writer->depth = 0;
+    writer->has_items[0] = false;
+}
+
+void json_end(Json_Writer *writer) {
+    fputc('\n', writer->file);
+    fflush(writer->file);
+}
+
+void json_begin_object(Json_Writer *writer, const char *key) { begin_scope(writer, key, '{'); }
+void json_end_object(Json_Writer *writer)                    { end_scope(writer, '}'); }
+void json_begin_array(Json_Writer *writer, const char *key)  { begin_scope(writer, key, '['); }
+void json_end_array(Json_Writer *writer)                     { end_scope(writer, ']'); }
+
+void json_write_string(Json_Writer *writer, const char *key, const char *value, s64 size) {
+    begin_value(writer, key);
+    if (!value) {
+        fputs("null", writer->file);
+        return;
+    }
+    write_escaped(writer->file, value, (size >= 0) ? size : (s64)strlen(value));
+}
+
+void json_write_int(Json_Writer *writer, const char *key, s64 value) {
+    begin_value(writer, key);
+    fprintf(writer->file, "%lld", (long long)value);
+}
+
+void json_write_uint(Json_Writer *writer, const char *key, u64 value) {
+    begin_value(writer, key);
+    fprintf(writer->file, "%llu", (unsigned long long)value);
+}
+
+void json_write_float(Json_Writer *writer, const char *key, double value) {
+    begin_value(writer, key);
+    fprintf(writer->file, "%.3f", value);
+}
+
+void json_write_bool(Json_Writer *writer, const char *key, bool value) {
+    begin_value(writer, key);
+    fputs(value ? "true" : "false", writer->file);
+}
+
+void json_write_null(Json_Writer *writer, const char *key) {
+    begin_value(writer, key);
+    fputs("null", writer->file);
+}
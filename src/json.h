@@ -0,0 +1,42 @@
+#ifndef PAWN_JSON_H
+#define PAWN_JSON_H
+
+#include <stdio.h>
+
+#include "common.h"
+
+//
+// --- Constants ---
+//
+const int JSON_MAX_DEPTH = 32;
+
+//
+// --- Structs ---
+//
+
+// Streams pretty-printed JSON. 'key' is NULL for values inside arrays (and the top level).
+struct Json_Writer {
+    FILE *file;
+    s32 depth;
+    bool has_items[JSON_MAX_DEPTH];
+};
+
+//
+// --- Functions ---
+//
+void json_begin(Json_Writer *writer, FILE *file);
+void json_end(Json_Writer *writer);
+
+void json_begin_object(Json_Writer *writer, const char *key);
+void json_end_object(Json_Writer *writer);
+void json_begin_array(Json_Writer *writer, const char *key);
+void json_end_array(Json_Writer *writer);
+
+void json_write_string(Json_Writer *writer, const char *key, const char *value, s64 size = -1); // NULL writes null.
+void json_write_int(Json_Writer *writer, const char *key, s64 value);
+void json_write_uint(Json_Writer *writer, const char *key, u64 value);
+void json_write_float(Json_Writer *writer, const char *key, double value);
+void json_write_bool(Json_Writer *writer, const char *key, bool value);
+void json_write_null(Json_Writer *writer, const char *key);
+
+#endif /* PAWN_JSON_H */
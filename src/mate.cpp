@@ -0,0 +1,387 @@
+#include <stdio.h>
+#include <xmmintrin.h> // _mm_prefetch()
+
+#include "mate.h"
+#include "platform.h"
+
+//
+// --- Constants ---
+//
+const u32 PN_INFINITE = 1u << 30;
+const u32 PN_MAX = PN_INFINITE - 1;   // Sums saturate here, so only solved positions are infinite.
+
+//
+// --- Table ---
+//
+static inline void prefetch(const Mate_Solver *solver, u64 key) {
+    _mm_prefetch((const char *)&solver->buckets[key & (solver->bucket_count - 1)], _MM_HINT_T0);
+}
+
+// Values of a position for a search with 'depth' plies left. A proof needs to fit in the plies left, a
+// disproof has to be from at least as deep a search. False, and 1/1, when the table has nothing to use.
+static bool lookup(const Mate_Solver *solver, u64 key, s32 depth, u32 *proof, u32 *disproof, s32 *mate_plies) {
+    *proof = 1;
+    *disproof = 1;
+    *mate_plies = 0;
+
+    const Mate_Bucket *bucket = &solver->buckets[key & (solver->bucket_count - 1)];
+    For (MATE_BUCKET_ENTRIES) {
+        const Mate_Entry *entry = &bucket->entries[it];
+        if (entry->key != key)  continue;
+
+        if (entry->mate_plies <= depth) {
+            *proof = 0;
+            *disproof = PN_INFINITE;
+            *mate_plies = entry->mate_plies;
+            return true;
+        }
+        if (entry->refuted_plies > depth) {
+            *proof = PN_INFINITE;
+            *disproof = 0;
+            return true;
+        }
+        if (entry->proof == 0)  return false;
+
+        // Unsolved values from another depth are still a fair estimate.
+        *proof = entry->proof;
+        *disproof = entry->disproof;
+        return true;
+    }
+    return false;
+}
+
+// Adds to what the table knows about the position. A proof or disproof doesn't replace the other one,
+// nor the numbers of unsolved searches at other depths.
+static void store(Mate_Solver *solver, u64 key, s32 depth, u32 proof, u32 disproof, s32 mate_plies, u64 work) {
+    Mate_Bucket *bucket = &solver->buckets[key & (solver->bucket_count - 1)];
+
+    Mate_Entry *entry = NULL;
+    Mate_Entry *replace = &bucket->entries[0];
+    For (MATE_BUCKET_ENTRIES) {
+        if (bucket->entries[it].key == key) {
+            entry = &bucket->entries[it];
+            break;
+        }
+        if (bucket->entries[it].work < replace->work)  replace = &bucket->entries[it];
+    }
+    if (!entry) {
+        entry = replace;
+        mem_zero(entry, sizeof(Mate_Entry));
+        entry->key = key;
+        entry->mate_plies = MATE_UNPROVEN;
+    }
+
+    if (proof == 0) {
+        if (mate_plies < entry->mate_plies)  entry->mate_plies = (u8)mate_plies;
+    } else if (disproof == 0) {
+        if (depth + 1 > entry->refuted_plies)  entry->refuted_plies = (u8)(depth + 1);
+    } else {
+        entry->proof = proof;
+        entry->disproof = disproof;
+        entry->depth = (u8)depth;
+    }
+    u32 saturated_work = (work > 0xFFFFFFFF) ? 0xFFFFFFFF : (u32)work;
+    if (saturated_work > entry->work)  entry->work = saturated_work;
+}
+
+//
+// --- Search ---
+//
+static u32 add_saturated(u32 a, u32 b) {
+    if (a >= PN_INFINITE || b >= PN_INFINITE)  return PN_INFINITE;
+    return (a + b > PN_MAX) ? PN_MAX : a + b;
+}
+
+static bool should_stop(Mate_Solver *solver) {
+    if (solver->stopped)  return true;
+    if ((solver->nodes & 1023) == 0) {
+        if (solver->stop.load(std::memory_order_relaxed)
+            || (solver->max_nodes > 0 && solver->nodes >= solver->max_nodes)
+            || (solver->deadline > 0 && get_time_microseconds() >= solver->deadline)) {
+            solver->stopped = true;
+        }
+    }
+    return solver->stopped;
+}
+
+// A position with the defender to move that was just reached: mate, stalemate, out of plies, or worth as
+// many proof numbers as the defender has replies.
+static void evaluate_defender(Mate_Solver *solver, s32 depth) {
+    Move_List replies;
+    generate_legal_moves(&solver->pos, &replies);
+    if (replies.count == 0) {
+        if (in_check(&solver->pos))  store(solver, solver->pos.key, depth, 0, PN_INFINITE, 0, 1);
+        else                         store(solver, solver->pos.key, depth, PN_INFINITE, 0, 0, 1);
+    } else if (depth == 0) {
+        store(solver, solver->pos.key, depth, PN_INFINITE, 0, 0, 1);
+    } else {
+        store(solver, solver->pos.key, depth, (u32)replies.count, 1, 0, 1);
+    }
+}
+
+// A position with the attacker to move that was just reached: lost for the attacker without moves or
+// plies, otherwise worth as many disproof numbers as the attacker has moves.
+static void evaluate_attacker(Mate_Solver *solver, s32 depth) {
+    Move_List moves;
+    generate_legal_moves(&solver->pos, &moves);
+    if (moves.count == 0 || depth == 0)  store(solver, solver->pos.key, depth, PN_INFINITE, 0, 0, 1);
+    else                                 store(solver, solver->pos.key, depth, 1, (u32)moves.count, 0, 1);
+}
+
+// Expands the current position until its proof number reaches 'proof_threshold' or its disproof
+// number reaches 'disproof_threshold', and leaves both in the table. The attacker is to move at even plies.
+static void search_node(Mate_Solver *solver, s32 ply, s32 depth, u32 proof_threshold, u32 disproof_threshold) {
+    Mate_Frame *frame = &solver->frames[ply];
+    Position *pos = &solver->pos;
+    bool attacker = (ply & 1) == 0;
+    u64 key = pos->key;
+    u64 start_nodes = solver->nodes++;
+
+    generate_legal_moves(pos, &frame->list);
+    if (frame->list.count == 0 || depth == 0) {
+        bool mate = !attacker && frame->list.count == 0 && in_check(pos);
+        if (mate)  store(solver, key, depth, 0, PN_INFINITE, 0, 1);
+        else       store(solver, key, depth, PN_INFINITE, 0, 0, 1);
+        return;
+    }
+
+    // Children, initialized when the table doesn't know them yet. Going back to a position of the path
+    // gains nothing for the attacker and draws for the defender, so both count as disproven.
+    // The children's buckets are requested all at once, so their loads overlap instead of waiting in turn.
+    s32 count = frame->list.count;
+    For (count) {
+        frame->keys[it] = key_after(pos, frame->list.moves[it]);
+        prefetch(solver, frame->keys[it]);
+    }
+    For (count) {
+        u64 child_key = frame->keys[it];
+        frame->repetition[it] = false;
+        for (s32 i = ply - 1; i >= 0; i--) {
+            if (solver->path[i] == child_key) {
+                frame->repetition[it] = true;
+                break;
+            }
+        }
+        u32 proof, disproof;
+        s32 mate_plies;
+        if (!frame->repetition[it] && !lookup(solver, child_key, depth - 1, &proof, &disproof, &mate_plies)) {
+            Move move = frame->list.moves[it];
+            Undo_Info undo;
+            make_move(pos, move, &undo);
+            if (attacker)  evaluate_defender(solver, depth - 1);
+            else           evaluate_attacker(solver, depth - 1);
+            unmake_move(pos, move, &undo);
+        }
+    }
+
+    u32 proof = 0;
+    u32 disproof = 0;
+    s32 mate_plies = 0;
+    for (;;) {
+        // Attacker: proof is the smallest child proof, disproof the sum. Defender: the other way around.
+        u32 best = PN_INFINITE + 1;
+        u32 second = PN_INFINITE;
+        u32 sum = 0;
+        u32 best_other = 0;
+        s32 best_index = -1;
+        s32 mate_index = -1;
+        s32 best_mate_plies = attacker ? MATE_MAX_PLY + 1 : -1;
+        For (count) {
+            u32 child_proof = PN_INFINITE;
+            u32 child_disproof = 0;
+            s32 child_mate_plies = 0;
+            if (!frame->repetition[it])  lookup(solver, frame->keys[it], depth - 1, &child_proof, &child_disproof, &child_mate_plies);
+
+            u32 minimized = attacker ? child_proof : child_disproof;
+            u32 summed = attacker ? child_disproof : child_proof;
+            sum = add_saturated(sum, summed);
+            if (child_proof == 0) {
+                // Shortest proven mate for the attacker, longest for the defender.
+                if (attacker ? child_mate_plies < best_mate_plies : child_mate_plies > best_mate_plies) {
+                    best_mate_plies = child_mate_plies;
+                    mate_index = it;
+                }
+                if (attacker)  continue;
+            }
+            if (minimized < best) {
+                second = best;
+                best = minimized;
+                best_other = summed;
+                best_index = it;
+            } else if (minimized < second) {
+                second = minimized;
+            }
+        }
+        if (best > PN_INFINITE)  best = PN_INFINITE;
+        if (second > PN_INFINITE)  second = PN_INFINITE;
+
+        if (attacker) {
+            if (mate_index >= 0)  best_index = mate_index;
+            proof = (mate_index >= 0) ? 0 : best;
+            disproof = (proof == 0) ? PN_INFINITE : sum;
+        } else {
+            disproof = best;
+            proof = (disproof == 0) ? PN_INFINITE : sum;
+        }
+        Move best_move = frame->list.moves[best_index];
+        if (proof == 0) {
+            mate_plies = best_mate_plies + 1;
+            break;
+        }
+        if (disproof == 0 || proof >= proof_threshold || disproof >= disproof_threshold)  break;
+        if (should_stop(solver))  break;
+
+        // Stay below the second best child by a margin (the 1 + epsilon trick), so the search doesn't
+        // keep switching between two children of about the same value. Long mates need a wide margin,
+        // epsilon at 1/4 took about twice as long to prove a rook ending.
+        u64 second_limit = (u64)second * 3 + 1;
+        u64 child_proof_threshold, child_disproof_threshold;
+        if (attacker) {
+            child_proof_threshold = (second_limit < proof_threshold) ? second_limit : proof_threshold;
+            child_disproof_threshold = (u64)disproof_threshold - disproof + best_other;
+        } else {
+            child_disproof_threshold = (second_limit < disproof_threshold) ? second_limit : disproof_threshold;
+            child_proof_threshold = (u64)proof_threshold - proof + best_other;
+        }
+        if (child_proof_threshold > PN_INFINITE)  child_proof_threshold = PN_INFINITE;
+        if (child_disproof_threshold > PN_INFINITE)  child_disproof_threshold = PN_INFINITE;
+
+        Undo_Info undo;
+        make_move(pos, best_move, &undo);
+        solver->path[ply + 1] = pos->key;
+        search_node(solver, ply + 1, depth - 1, (u32)child_proof_threshold, (u32)child_disproof_threshold);
+        unmake_move(pos, best_move, &undo);
+    }
+
+    store(solver, key, depth, proof, disproof, mate_plies, solver->nodes - start_nodes);
+}
+
+// Picks the quickest mate for the attacker or the longest defence for the defender among the proven
+// children of the current position. MOVE_NONE when the table lost a child the proof needs.
+static Move pick_pv_move(Mate_Solver *solver, s32 ply, s32 depth, s32 *out_mate_plies) {
+    Position *pos = &solver->pos;
+    bool attacker = (ply & 1) == 0;
+    Move_List list;
+    generate_legal_moves(pos, &list);
+
+    Move best_move = MOVE_NONE;
+    For (list.count) {
+        Undo_Info undo;
+        make_move(pos, list.moves[it], &undo);
+        u32 proof, disproof;
+        s32 mate_plies;
+        lookup(solver, pos->key, depth - 1, &proof, &disproof, &mate_plies);
+        unmake_move(pos, list.moves[it], &undo);
+
+        if (proof != 0) {
+            if (attacker)  continue;
+            return MOVE_NONE;
+        }
+        if (best_move == MOVE_NONE || (attacker ? mate_plies < *out_mate_plies : mate_plies > *out_mate_plies)) {
+            best_move = list.moves[it];
+            *out_mate_plies = mate_plies;
+        }
+    }
+    return best_move;
+}
+
+// Follows the proof from the root. Parts of it the table lost on the way are proven again.
+static s32 extract_pv(Mate_Solver *solver, const Position *root, s32 depth, Move *pv) {
+    solver->pos = *root;
+    solver->path[0] = root->key;
+    s32 length = 0;
+    for (s32 ply = 0; ply < depth; ply++) {
+        s32 mate_plies = 0;
+        Move move = pick_pv_move(solver, ply, depth - ply, &mate_plies);
+        if (move == MOVE_NONE && !solver->stopped) {
+            search_node(solver, ply, depth - ply, PN_INFINITE, PN_INFINITE);
+            move = pick_pv_move(solver, ply, depth - ply, &mate_plies);
+        }
+        if (move == MOVE_NONE)  break;
+
+        Undo_Info undo;
+        make_move(&solver->pos, move, &undo);
+        solver->path[ply + 1] = solver->pos.key;
+        pv[length++] = move;
+        if (mate_plies == 0)  break;
+    }
+    return length;
+}
+
+//
+// --- Interface ---
+//
+Mate_Solver *create_mate_solver(s64 hash_megabytes) {
+    if (hash_megabytes < 1)  hash_megabytes = 1;
+    u64 bucket_count = 1;
+    while (bucket_count * 2 * sizeof(Mate_Bucket) <= (u64)hash_megabytes * 1024 * 1024)  bucket_count *= 2;
+
+    Mate_Bucket *buckets = ALLOC(sys_allocator, (s64)bucket_count, Mate_Bucket);
+    if (!buckets) {
+        fprintf(stderr, "ERROR: Couldn't allocate %lld MB for the mate solver!\n", (long long)hash_megabytes);
+        return NULL;
+    }
+
+    Mate_Solver *solver = ALLOC(sys_allocator, 1, Mate_Solver);
+    mem_zero(solver, sizeof(Mate_Solver));
+    solver->buckets = buckets;
+    solver->bucket_count = bucket_count;
+    clear_mate_solver(solver);
+    return solver;
+}
+
+void destroy_mate_solver(Mate_Solver *solver) {
+    FREE(sys_allocator, solver->buckets);
+    FREE(sys_allocator, solver);
+}
+
+void clear_mate_solver(Mate_Solver *solver) {
+    ZoneScoped;
+
+    mem_zero(solver->buckets, (s64)(solver->bucket_count * sizeof(Mate_Bucket)));
+    solver->stop.store(false);
+}
+
+void stop_mate_solver(Mate_Solver *solver) {
+    solver->stop.store(true, std::memory_order_relaxed);
+}
+
+bool solve_mate(Mate_Solver *solver, const Position *root, const Mate_Limits *limits, Mate_Result *out_result) {
+    ZoneScoped;
+
+    u64 start_time = get_time_microseconds();
+    solver->nodes = 0;
+    solver->max_nodes = limits->nodes;
+    solver->deadline = (limits->movetime > 0) ? start_time + (u64)limits->movetime * 1000 : 0;
+    solver->stopped = false;
+
+    mem_zero(out_result, sizeof(Mate_Result));
+    s32 moves = (limits->moves < 1) ? 1 : (limits->moves > MATE_MAX_MOVES) ? MATE_MAX_MOVES : limits->moves;
+    while (moves > 0) {
+        s32 depth = 2 * moves - 1;
+        solver->pos = *root;
+        solver->path[0] = root->key;
+        search_node(solver, 0, depth, PN_INFINITE, PN_INFINITE);
+        if (solver->stopped)  break;
+
+        u32 proof, disproof;
+        s32 mate_plies;
+        lookup(solver, root->key, depth, &proof, &disproof, &mate_plies);
+        if (proof != 0) {
+            // No mate at all, or none shorter than the one already proven.
+            if (out_result->proven)  out_result->shortest = true;
+            else                     out_result->disproven = true;
+            break;
+        }
+
+        out_result->proven = true;
+        out_result->moves = (mate_plies + 1) / 2;
+        out_result->pv_length = extract_pv(solver, root, depth, out_result->pv);
+        moves = out_result->moves - 1;
+        if (moves == 0)  out_result->shortest = true;
+    }
+
+    out_result->nodes = solver->nodes;
+    out_result->time = get_time_microseconds() - start_time;
+    return out_result->proven;
+}
@@ -0,0 +1,100 @@
+#ifndef PAWN_MATE_H
+#define PAWN_MATE_H
+
+#include <atomic>
+
+#include "movegen.h"
+#include "position.h"
+
+//
+// --- Constants ---
+//
+const int MATE_MAX_MOVES = 100;
+const int MATE_MAX_PLY = 2 * MATE_MAX_MOVES;
+
+//
+// --- Structs ---
+//
+
+// What is known about one position, from the point of view of the side that is mating. A proof holds for
+// every deeper search and a disproof for every shallower one, so both are kept next to the numbers of
+// the last unsolved search, and each search depth uses whatever applies to it. 24 bytes, four to a bucket.
+struct Mate_Entry {
+    u64 key;              // 0 for an empty entry.
+    u32 proof;            // Of the last search that didn't solve it, 'depth' plies deep; 0 if there was none.
+    u32 disproof;
+    u32 work;             // Nodes spent below the entry, the cheapest ones are replaced first.
+    u8 depth;
+    u8 mate_plies;        // Shortest mate proven so far, with best play from both sides, or MATE_UNPROVEN.
+    u8 refuted_plies;     // No mate within fewer plies than this; 0 when nothing is known.
+    u8 padding;
+};
+
+const u8 MATE_UNPROVEN = 0xFF;
+
+const int MATE_BUCKET_ENTRIES = 4;
+
+struct Mate_Bucket {
+    Mate_Entry entries[MATE_BUCKET_ENTRIES];
+};
+
+// Zero fields mean "no limit", except 'moves'.
+struct Mate_Limits {
+    s32 moves;            // Longest mate to look for, at most MATE_MAX_MOVES.
+    u64 nodes;
+    s64 movetime;         // Milliseconds.
+};
+
+struct Mate_Result {
+    bool proven;          // A mate in 'moves' was found; with neither flag a limit was hit first.
+    bool disproven;       // There is no mate within 'limits->moves'.
+    bool shortest;        // The proven mate couldn't be shortened before a limit was hit.
+    s32 moves;
+    s32 pv_length;        // The mate line, defended as long as possible.
+    Move pv[MATE_MAX_PLY];
+    u64 nodes;
+    u64 time;             // Microseconds.
+};
+
+// Moves of a position on the path being searched.
+struct Mate_Frame {
+    Move_List list;
+    u64 keys[MAX_MOVES];  // Of the positions after each move.
+    bool repetition[MAX_MOVES];
+};
+
+// Depth-first proof-number search for forced mates, on its own table. Large; create with
+// 'create_mate_solver()'. One solver is used by one thread at a time.
+struct Mate_Solver {
+    Mate_Bucket *buckets;
+    u64 bucket_count;     // Power of two.
+
+    Position pos;
+    u64 path[MATE_MAX_PLY + 1];
+    Mate_Frame frames[MATE_MAX_PLY];
+
+    u64 nodes;
+    u64 max_nodes;
+    u64 deadline;         // Microseconds, 0 for none.
+    std::atomic<bool> stop;
+    bool stopped;
+};
+
+//
+// --- Functions ---
+//
+Mate_Solver *create_mate_solver(s64 hash_megabytes);
+void destroy_mate_solver(Mate_Solver *solver);
+// Forgets every position, and a stop request.
+void clear_mate_solver(Mate_Solver *solver);
+
+// Looks for a forced mate for the side to move in at most 'limits->moves' moves, and once one is proven
+// keeps looking for a shorter one until that fails. The proof is sound; a disproof can be wrong when it
+// relied on a repetition of the search path, so a mate is occasionally missed, never made up.
+// Returns 'out_result->proven'. Positions proven or disproven stay in the table for the next call.
+bool solve_mate(Mate_Solver *solver, const Position *root, const Mate_Limits *limits, Mate_Result *out_result);
+
+// Can be called from any thread; the request stays until 'clear_mate_solver()'.
+void stop_mate_solver(Mate_Solver *solver);
+
+#endif /* PAWN_MATE_H */
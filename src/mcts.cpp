@@ -0,0 +1,434 @@
+#include <math.h>
+#include <stdio.h>
+
+#include "mcts.h"
+#include "eval.h"
+
+//
+// --- Constants ---
+//
+const u32 MCTS_UNEXPANDED = 0;         // The root is node 0, so no node has it as its first child.
+const u32 MCTS_TERMINAL = 0xFFFFFFFE;  // No legal moves.
+const u32 MCTS_EXPANDING = 0xFFFFFFFF; // A thread is filling in the children.
+
+const s64 MCTS_ONE = 65536;            // A win, in 'Mcts_Node::value' units.
+const u32 MCTS_VIRTUAL_LOSS = 3;       // Visits a thread adds on the way down and takes back on the way up.
+const u32 MCTS_EXPAND_VISITS = 2;      // Leaves are evaluated once before they get children.
+const float MCTS_FIRST_PLAY_REDUCTION = 0.2f; // Unvisited children start at the parent's value minus this.
+const float MCTS_DEFAULT_EXPLORATION = 0.7f;
+const s32 MCTS_DEFAULT_PLAYOUT_PLIES = 8;
+const double MCTS_EVAL_SCALE = 400.0;  // Centipawns for 10 to 1 odds.
+
+const u64 MCTS_REPORT_INTERVAL = 1000000;   // Microseconds.
+const u64 MCTS_LIMIT_CHECK_INTERVAL = 256;  // Playouts of the main thread.
+
+//
+// --- Structs ---
+//
+struct Mcts_Worker {
+    Mcts *mcts;
+    Position pos;
+    u64 random;
+    s32 key_count;
+    u32 path[MAX_PLY + 1];
+    u64 keys[FIFTY_MOVE_PLY + MAX_PLY + 1];
+};
+
+//
+// --- Helpers ---
+//
+static u64 next_random(u64 *state) {
+    u64 x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+static float score_to_value(s32 score) {
+    return (float)(1.0 / (1.0 + pow(10.0, -(double)score / MCTS_EVAL_SCALE)));
+}
+
+static s32 value_to_score(float value) {
+    if (value < 0.0001f)  value = 0.0001f;
+    if (value > 0.9999f)  value = 0.9999f;
+    return (s32)(MCTS_EVAL_SCALE * log10((double)value / (1.0 - (double)value)));
+}
+
+// Mean value for the side that played the node's move, 'fallback' while it has no visits.
+static float node_value(const Mcts_Node *node, float fallback) {
+    u32 visits = node->visits.load(std::memory_order_relaxed);
+    if (visits == 0)  return fallback;
+    return (float)((double)node->value.load(std::memory_order_relaxed) / (double)MCTS_ONE / (double)visits);
+}
+
+// Repetitions inside the tree draw at once, ones of the game before the root need a third occurrence,
+// as in the alpha-beta search.
+static bool is_draw(const Mcts_Worker *worker, s32 ply) {
+    const Position *pos = &worker->pos;
+    if (pos->halfmove_clock >= FIFTY_MOVE_PLY || is_insufficient_material(pos))  return true;
+
+    s32 index = worker->mcts->game_key_count + ply;
+    s32 distance = find_repetition(pos->key, worker->keys, index, pos->halfmove_clock);
+    if (distance == 0)  return false;
+    if (distance < ply)  return true;
+    return find_repetition(pos->key, worker->keys, index - distance, pos->halfmove_clock - distance) != 0;
+}
+
+// Value of the worker's position for the side to move.
+static float evaluate_leaf(Mcts_Worker *worker) {
+    Mcts *mcts = worker->mcts;
+    Position pos = worker->pos;
+    bool flipped = false;
+
+    if (mcts->leaf_policy == MCTS_LEAF_PLAYOUT) {
+        For (mcts->playout_plies) {
+            Move_List list;
+            generate_legal_moves(&pos, &list);
+            if (list.count == 0) {
+                float value = in_check(&pos) ? 0.0f : 0.5f;
+                return flipped ? 1.0f - value : value;
+            }
+            Undo_Info undo;
+            make_move(&pos, list.moves[next_random(&worker->random) % (u64)list.count], &undo);
+            flipped = !flipped;
+        }
+    }
+
+    float value = score_to_value(evaluate(&pos));
+    return flipped ? 1.0f - value : value;
+}
+
+// Gives the node its children unless another thread is at it. Leaves it unexpanded when the pool is full.
+static void expand(Mcts *mcts, Mcts_Node *node, const Position *pos) {
+    u32 expected = MCTS_UNEXPANDED;
+    if (!node->first_child.compare_exchange_strong(expected, MCTS_EXPANDING, std::memory_order_acquire))  return;
+
+    Move_List list;
+    generate_legal_moves(pos, &list);
+    if (list.count == 0) {
+        node->first_child.store(MCTS_TERMINAL, std::memory_order_release);
+        return;
+    }
+
+    u32 first = mcts->node_count.fetch_add((u32)list.count, std::memory_order_relaxed);
+    if ((u64)first + (u64)list.count > mcts->capacity) {
+        mcts->full.store(true, std::memory_order_relaxed);
+        node->first_child.store(MCTS_UNEXPANDED, std::memory_order_release);
+        return;
+    }
+
+    For (list.count) {
+        Mcts_Node *child = &mcts->nodes[first + it];
+        child->first_child.store(MCTS_UNEXPANDED, std::memory_order_relaxed);
+        child->visits.store(0, std::memory_order_relaxed);
+        child->value.store(0, std::memory_order_relaxed);
+        child->move = list.moves[it];
+        child->child_count = 0;
+    }
+    node->child_count = (u16)list.count;
+    node->first_child.store(first, std::memory_order_release);
+}
+
+// UCT: mean value plus an exploration bonus that shrinks with the child's visits.
+static u32 select_child(Mcts *mcts, const Mcts_Node *node, u32 first) {
+    u32 parent_visits = node->visits.load(std::memory_order_relaxed);
+    float first_play = (1.0f - node_value(node, 0.5f)) - MCTS_FIRST_PLAY_REDUCTION;
+    if (first_play < 0.0f)  first_play = 0.0f;
+    float log_visits = logf((float)parent_visits + 1.0f);
+
+    u32 best = first;
+    float best_score = -1.0f;
+    For (node->child_count) {
+        const Mcts_Node *child = &mcts->nodes[first + it];
+        u32 visits = child->visits.load(std::memory_order_relaxed);
+        float score = node_value(child, first_play) + mcts->exploration * sqrtf(log_visits / ((float)visits + 1.0f));
+        if (score > best_score) {
+            best_score = score;
+            best = first + it;
+        }
+    }
+    return best;
+}
+
+// One walk from the root to a leaf and back.
+static void run_playout(Mcts_Worker *worker) {
+    Mcts *mcts = worker->mcts;
+    Position *pos = &worker->pos;
+    *pos = mcts->root;
+
+    s32 ply = 0;
+    u32 index = 0;
+    worker->path[0] = 0;
+    mcts->nodes[0].visits.fetch_add(MCTS_VIRTUAL_LOSS, std::memory_order_relaxed);
+
+    float value;  // For the side to move at the end of the walk.
+    for (;;) {
+        Mcts_Node *node = &mcts->nodes[index];
+        if (ply > 0 && is_draw(worker, ply)) {
+            value = 0.5f;
+            break;
+        }
+
+        u32 first = node->first_child.load(std::memory_order_acquire);
+        if (first == MCTS_UNEXPANDED && !mcts->full.load(std::memory_order_relaxed)
+            && node->visits.load(std::memory_order_relaxed) >= MCTS_EXPAND_VISITS + MCTS_VIRTUAL_LOSS - 1) {
+            expand(mcts, node, pos);
+            first = node->first_child.load(std::memory_order_acquire);
+        }
+        if (first == MCTS_TERMINAL) {
+            value = in_check(pos) ? 0.0f : 0.5f;
+            break;
+        }
+        if (first == MCTS_UNEXPANDED || first == MCTS_EXPANDING || ply >= MAX_PLY) {
+            value = evaluate_leaf(worker);
+            break;
+        }
+
+        index = select_child(mcts, node, first);
+        Mcts_Node *child = &mcts->nodes[index];
+        child->visits.fetch_add(MCTS_VIRTUAL_LOSS, std::memory_order_relaxed);
+
+        worker->keys[mcts->game_key_count + ply] = pos->key;
+        Undo_Info undo;
+        make_move(pos, child->move, &undo);
+        ply++;
+        worker->path[ply] = index;
+    }
+
+    // The leaf's own value is for the side that moved into it, then it alternates up to the root.
+    s64 leaf = (s64)(value * (float)MCTS_ONE);
+    for (s32 i = ply; i >= 0; i--) {
+        Mcts_Node *node = &mcts->nodes[worker->path[i]];
+        node->value.fetch_add(((ply - i) & 1) ? leaf : MCTS_ONE - leaf, std::memory_order_relaxed);
+        node->visits.fetch_sub(MCTS_VIRTUAL_LOSS - 1, std::memory_order_relaxed);
+    }
+
+    mcts->playouts.fetch_add(1, std::memory_order_relaxed);
+    mcts->depth_sum.fetch_add((u64)ply, std::memory_order_relaxed);
+    s32 seldepth = mcts->seldepth.load(std::memory_order_relaxed);
+    while (ply > seldepth && !mcts->seldepth.compare_exchange_weak(seldepth, ply, std::memory_order_relaxed)) { }
+}
+
+static void init_worker(Mcts *mcts, Mcts_Worker *worker, s32 index) {
+    worker->mcts = mcts;
+    worker->random = 0x9E3779B97F4A7C15ULL * (u64)(index + 1);
+    For (mcts->game_key_count)  worker->keys[it] = mcts->game_keys[it];
+}
+
+static void helper_thread_proc(void *data) {
+    ZoneScoped;
+
+    Mcts_Worker *worker = (Mcts_Worker *)data;
+    while (!worker->mcts->done.load(std::memory_order_relaxed))  run_playout(worker);
+}
+
+static const Mcts_Node *most_visited_child(const Mcts *mcts, const Mcts_Node *node) {
+    u32 first = node->first_child.load(std::memory_order_acquire);
+    if (first == MCTS_UNEXPANDED || first == MCTS_TERMINAL || first == MCTS_EXPANDING)  return NULL;
+
+    const Mcts_Node *best = NULL;
+    For (node->child_count) {
+        const Mcts_Node *child = &mcts->nodes[first + it];
+        if (!best || child->visits.load(std::memory_order_relaxed) > best->visits.load(std::memory_order_relaxed))  best = child;
+    }
+    return (best && best->visits.load(std::memory_order_relaxed) > 0) ? best : NULL;
+}
+
+static s32 principal_variation(const Mcts *mcts, Move *pv) {
+    s32 length = 0;
+    const Mcts_Node *node = &mcts->nodes[0];
+    while (length < MAX_PLY) {
+        node = most_visited_child(mcts, node);
+        if (!node)  break;
+        pv[length++] = node->move;
+    }
+    return length;
+}
+
+static void fill_result(Mcts *mcts, Search_Result *result, Move *pv, s32 *pv_length) {
+    *pv_length = principal_variation(mcts, pv);
+    u64 playouts = mcts->playouts.load(std::memory_order_relaxed);
+    const Mcts_Node *best = most_visited_child(mcts, &mcts->nodes[0]);
+
+    result->best_move = (*pv_length > 0) ? pv[0] : MOVE_NONE;
+    result->ponder_move = (*pv_length > 1) ? pv[1] : MOVE_NONE;
+    result->score = best ? value_to_score(node_value(best, 0.5f)) : 0;
+    // A terminal child that is winning is a mate in one, the visits before it was expanded aside.
+    // Deeper mates stay ordinary scores.
+    if (best && best->first_child.load(std::memory_order_acquire) == MCTS_TERMINAL && node_value(best, 0.5f) > 0.9f) {
+        result->score = SCORE_MATE - 1;
+    }
+    result->depth = (playouts > 0) ? (s32)(mcts->depth_sum.load(std::memory_order_relaxed) / playouts) : 0;
+    result->seldepth = mcts->seldepth.load(std::memory_order_relaxed);
+    result->nodes = playouts;
+    result->time = get_time_microseconds() - mcts->start_time;
+}
+
+static void report(Mcts *mcts) {
+    if (!mcts->report_proc)  return;
+
+    Search_Result result;
+    Move pv[MAX_PLY];
+    s32 pv_length;
+    fill_result(mcts, &result, pv, &pv_length);
+    if (pv_length == 0)  return;
+
+    Search_Report report;
+    report.depth = result.depth;
+    report.seldepth = result.seldepth;
+    report.score = result.score;
+    report.bound = BOUND_EXACT;
+    report.multi_pv = 1;
+    report.nodes = result.nodes;
+    report.line_nodes = result.nodes;
+    report.time = result.time;
+    report.pv = pv;
+    report.pv_length = pv_length;
+    mcts->report_proc(mcts->report_data, &report);
+}
+
+// True while still pondering. On the ponder hit the clock restarts, so the limits count from there.
+static bool update_pondering(Mcts *mcts, bool *pondering) {
+    if (!*pondering)  return false;
+    if (mcts->ponder.load(std::memory_order_relaxed))  return true;
+    *pondering = false;
+    mcts->start_time = get_time_microseconds();
+    return false;
+}
+
+static bool limits_reached(Mcts *mcts, bool *pondering) {
+    if (mcts->stop.load(std::memory_order_relaxed))  return true;
+    if (update_pondering(mcts, pondering) || mcts->limits.infinite)  return false;
+
+    const Search_Limits *limits = &mcts->limits;
+    u64 playouts = mcts->playouts.load(std::memory_order_relaxed);
+    if (limits->nodes > 0 && playouts >= limits->nodes)  return true;
+    if (limits->depth > 0 && playouts > 0 && mcts->depth_sum.load(std::memory_order_relaxed) >= (u64)limits->depth * playouts)  return true;
+
+    // No iterations to settle on, so the soft limit is where the search ends.
+    u64 elapsed = get_time_microseconds() - mcts->start_time;
+    return mcts->tm.active && (elapsed >= mcts->tm.soft_limit || time_manager_out_of_time(&mcts->tm, elapsed));
+}
+
+//
+// --- Interface ---
+//
+Mcts *create_mcts(s64 megabytes) {
+    ZoneScoped;
+
+    if (megabytes < 1)  megabytes = 1;
+    u64 capacity = (u64)megabytes * 1024 * 1024 / sizeof(Mcts_Node);
+    if (capacity > MCTS_TERMINAL - 1)  capacity = MCTS_TERMINAL - 1;
+
+    Mcts_Node *nodes = ALLOC(sys_allocator, (s64)capacity, Mcts_Node);
+    if (!nodes) {
+        fprintf(stderr, "ERROR: Couldn't allocate %lld MB for the search tree!\n", (long long)megabytes);
+        return NULL;
+    }
+
+    Mcts *mcts = ALLOC(sys_allocator, 1, Mcts);
+    mem_zero(mcts, sizeof(Mcts));
+    mcts->nodes = nodes;
+    mcts->capacity = (u32)capacity;
+    mcts->leaf_policy = MCTS_LEAF_EVAL;
+    mcts->playout_plies = MCTS_DEFAULT_PLAYOUT_PLIES;
+    mcts->exploration = MCTS_DEFAULT_EXPLORATION;
+    mcts->thread_count = 1;
+    mcts->stop.store(false);
+    mcts->ponder.store(false);
+    return mcts;
+}
+
+void destroy_mcts(Mcts *mcts) {
+    FREE(sys_allocator, mcts->nodes);
+    FREE(sys_allocator, mcts);
+}
+
+Search_Result mcts_search(Mcts *mcts, const Position *root, const Search_Limits *limits, const u64 *game_keys, s32 game_key_count) {
+    ZoneScoped;
+
+    mcts->start_time = get_time_microseconds();
+    mcts->root = *root;
+    mcts->limits = *limits;
+    if (game_key_count > FIFTY_MOVE_PLY) {
+        game_keys += game_key_count - FIFTY_MOVE_PLY;
+        game_key_count = FIFTY_MOVE_PLY;
+    }
+    mcts->game_key_count = game_key_count;
+    For (game_key_count)  mcts->game_keys[it] = game_keys[it];
+    start_time_manager(&mcts->tm, limits->time_left, limits->increment, limits->moves_to_go, limits->movetime);
+
+    // A new tree every search: node 0 is the root, the pool hands out the rest in order.
+    Mcts_Node *root_node = &mcts->nodes[0];
+    root_node->first_child.store(MCTS_UNEXPANDED);
+    root_node->visits.store(0);
+    root_node->value.store(0);
+    root_node->move = MOVE_NONE;
+    root_node->child_count = 0;
+    mcts->node_count.store(1);
+    mcts->full.store(false);
+    mcts->done.store(false);
+    mcts->playouts.store(0);
+    mcts->depth_sum.store(0);
+    mcts->seldepth.store(0);
+    expand(mcts, root_node, root);
+
+    Search_Result result = { };
+    if (root_node->first_child.load() == MCTS_TERMINAL || mcts->full.load()) {
+        result.time = get_time_microseconds() - mcts->start_time;
+        return result;
+    }
+
+    s32 thread_count = mcts->thread_count;
+    if (thread_count < 1)                 thread_count = 1;
+    if (thread_count > MCTS_MAX_THREADS)  thread_count = MCTS_MAX_THREADS;
+    Mcts_Worker *workers = ALLOC(sys_allocator, thread_count, Mcts_Worker);
+    Thread *threads = ALLOC(sys_allocator, thread_count, Thread);
+    defer {
+        FREE(sys_allocator, workers);
+        FREE(sys_allocator, threads);
+    };
+    For (thread_count)  init_worker(mcts, &workers[it], it);
+    for (s32 i = 1; i < thread_count; i++)  threads[i] = create_thread(helper_thread_proc, &workers[i]);
+
+    bool pondering = is_mcts_pondering(mcts);
+    u64 next_report = mcts->start_time + MCTS_REPORT_INTERVAL;
+    for (u64 playout = 0;; playout++) {
+        run_playout(&workers[0]);
+        if ((playout & (MCTS_LIMIT_CHECK_INTERVAL - 1)) != 0)  continue;
+        if (limits_reached(mcts, &pondering))  break;
+
+        u64 now = get_time_microseconds();
+        if (now >= next_report) {
+            report(mcts);
+            next_report = now + MCTS_REPORT_INTERVAL;
+        }
+    }
+
+    mcts->done.store(true);
+    for (s32 i = 1; i < thread_count; i++)  join_thread(&threads[i]);
+
+    report(mcts);
+    Move pv[MAX_PLY];
+    s32 pv_length;
+    fill_result(mcts, &result, pv, &pv_length);
+    return result;
+}
+
+void stop_mcts(Mcts *mcts) {
+    mcts->stop.store(true, std::memory_order_relaxed);
+}
+
+void clear_mcts_stop_request(Mcts *mcts) {
+    mcts->stop.store(false, std::memory_order_relaxed);
+}
+
+void start_mcts_pondering(Mcts *mcts) {
+    mcts->ponder.store(true, std::memory_order_relaxed);
+}
+
+void mcts_ponder_hit(Mcts *mcts) {
+    mcts->ponder.store(false, std::memory_order_relaxed);
+}
@@ -0,0 +1,94 @@
+#ifndef PAWN_MCTS_H
+#define PAWN_MCTS_H
+
+#include <atomic>
+
+#include "platform.h"
+#include "search.h"
+
+//
+// --- Constants ---
+//
+const int MCTS_MAX_THREADS = 256;
+
+//
+// --- Enums ---
+//
+enum Mcts_Leaf_Policy {
+    MCTS_LEAF_EVAL = 0,       // The static evaluation of the new leaf.
+    MCTS_LEAF_PLAYOUT = 1     // A short random playout from the leaf, then the static evaluation.
+};
+
+//
+// --- Structs ---
+//
+
+// Values are in 1/65536ths of a win for the side that played 'move', so a draw adds half of one.
+// Every field that threads share is updated with atomic adds or a single compare-exchange.
+struct Mcts_Node {
+    std::atomic<u32> first_child; // Index in the pool, or MCTS_UNEXPANDED, MCTS_EXPANDING, MCTS_TERMINAL.
+    std::atomic<u32> visits;      // Virtual losses of the threads below the node included.
+    std::atomic<s64> value;
+    Move move;
+    u16 child_count;
+};
+
+// Monte Carlo tree search: UCT selection with virtual losses, so several threads walk one tree at once.
+// Nodes come from a pool allocated once, a whole search never allocates. Large; create with 'create_mcts()'.
+struct Mcts {
+    Mcts_Node *nodes;
+    u32 capacity;
+    std::atomic<u32> node_count;  // Claimed; goes past 'capacity' by the claims that found the pool full.
+    std::atomic<bool> full;       // Out of nodes, leaves are evaluated without being expanded.
+
+    Mcts_Leaf_Policy leaf_policy;
+    s32 playout_plies;
+    float exploration;
+    s32 thread_count;
+
+    Position root;
+    s32 game_key_count;
+    u64 game_keys[FIFTY_MOVE_PLY];
+    Search_Limits limits;
+    u64 start_time;               // Reset on ponder hit, like 'Searcher::start_time'.
+    Time_Manager tm;
+    std::atomic<bool> stop;
+    std::atomic<bool> ponder;
+    std::atomic<bool> done;       // Tells the helper threads the search is over.
+
+    std::atomic<u64> playouts;
+    std::atomic<u64> depth_sum;
+    std::atomic<s32> seldepth;
+
+    Search_Report_Proc report_proc;
+    void *report_data;
+};
+
+//
+// --- Functions ---
+//
+
+// The pool takes 'megabytes', about 40000 nodes each.
+Mcts *create_mcts(s64 megabytes);
+void destroy_mcts(Mcts *mcts);
+
+// Grows a new tree from 'root' on 'mcts->thread_count' threads, the calling one included, until a limit
+// is hit or 'stop_mcts()' is called. 'limits->depth' is reached when the playouts average that depth;
+// 'limits->nodes' counts playouts. Reports the most visited line about once a second.
+Search_Result mcts_search(Mcts *mcts, const Position *root, const Search_Limits *limits, const u64 *game_keys = NULL, s32 game_key_count = 0);
+
+// Same contract as the alpha-beta 'stop_search()', 'start_pondering()' and 'ponder_hit()'.
+void stop_mcts(Mcts *mcts);
+void clear_mcts_stop_request(Mcts *mcts);
+void start_mcts_pondering(Mcts *mcts);
+void mcts_ponder_hit(Mcts *mcts);
+inline bool is_mcts_pondering(const Mcts *mcts) { return mcts->ponder.load(std::memory_order_relaxed); }
+
+// Per mille of the pool in use, like UCI 'hashfull'.
+inline s32 mcts_hashfull(const Mcts *mcts) {
+    u64 used = mcts->node_count.load(std::memory_order_relaxed);
+    if (used > mcts->capacity)  used = mcts->capacity;
+    return (s32)(used * 1000 / mcts->capacity);
+}
+
+#endif /* PAWN_MCTS_H */
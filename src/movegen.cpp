@@ -0,0 +1,233 @@
+#include "movegen.h"
+
+static inline void add_move(Move_List *list, s32 from, s32 to, s32 flags) {
+    list->moves[list->count++] = new_move(from, to, flags);
+}
+
+// Queen first, so move ordering that keeps generation order tries it before under-promotions.
+static inline void add_promotions(Move_List *list, s32 from, s32 to, s32 flags) {
+    For (4 /*promotion kinds*/) {
+        add_move(list, from, to, flags | (3 - it));
+    }
+}
+
+static void generate_pawn_moves(const Position *pos, Move_List *list, s32 generate_type, Bitboard targets) {
+    s32 us = pos->side_to_move;
+    s32 them = us ^ 1;
+    s32 forward = (us == WHITE) ? 8 : -8;
+    Bitboard promotion_rank = (us == WHITE) ? RANK_8_BB : RANK_1_BB;
+    Bitboard double_push_rank = (us == WHITE) ? RANK_4_BB : RANK_5_BB;
+    Bitboard empty = ~occupied(pos);
+    Bitboard enemies = pos->colors[them] & targets;
+    Bitboard pawns = pieces_of(pos, us, PAWN);
+
+    Bitboard single = pawn_push(us, pawns) & empty;
+    Bitboard double_push = pawn_push(us, single) & empty & double_push_rank & targets;
+    single &= targets;
+
+    if (generate_type & GENERATE_CAPTURES) {
+        Bitboard promotions = single & promotion_rank;
+        while (promotions) {
+            s32 to = pop_lsb(&promotions);
+            add_promotions(list, to - forward, to, MOVE_PROMOTION);
+        }
+
+        Bitboard attackers = pawns;
+        while (attackers) {
+            s32 from = pop_lsb(&attackers);
+            Bitboard captures = pawn_attacks(us, from) & enemies;
+            while (captures) {
+                s32 to = pop_lsb(&captures);
+                if (square_bb(to) & promotion_rank) {
+                    add_promotions(list, from, to, MOVE_PROMOTION_CAPTURE);
+                } else {
+                    add_move(list, from, to, MOVE_CAPTURE);
+                }
+            }
+        }
+
+        if (pos->ep_square != NO_SQUARE) {
+            // When evading a check, the en passant capture is only useful if the pushed pawn is the checker.
+            s32 captured_square = pos->ep_square - forward;
+            if (targets & (square_bb(pos->ep_square) | square_bb(captured_square))) {
+                Bitboard capturers = pawn_attacks(them, pos->ep_square) & pawns;
+                while (capturers) {
+                    add_move(list, pop_lsb(&capturers), pos->ep_square, MOVE_EP_CAPTURE);
+                }
+            }
+        }
+    }
+
+    if (generate_type & GENERATE_QUIETS) {
+        Bitboard pushes = single & ~promotion_rank;
+        while (pushes) {
+            s32 to = pop_lsb(&pushes);
+            add_move(list, to - forward, to, MOVE_QUIET);
+        }
+        while (double_push) {
+            s32 to = pop_lsb(&double_push);
+            add_move(list, to - 2 * forward, to, MOVE_DOUBLE_PUSH);
+        }
+    }
+}
+
+static void generate_piece_moves(const Position *pos, Move_List *list, s32 kind, Bitboard targets) {
+    s32 us = pos->side_to_move;
+    Bitboard occupancy = occupied(pos);
+    Bitboard enemies = pos->colors[us ^ 1];
+    Bitboard pieces = pieces_of(pos, us, kind);
+
+    while (pieces) {
+        s32 from = pop_lsb(&pieces);
+        Bitboard attacks;
+        switch (kind) {
+            case KNIGHT: attacks = knight_attacks(from); break;
+            case BISHOP: attacks = bishop_attacks(from, occupancy); break;
+            case ROOK:   attacks = rook_attacks(from, occupancy); break;
+            case QUEEN:  attacks = queen_attacks(from, occupancy); break;
+            default:     attacks = king_attacks(from); break;
+        }
+        attacks &= targets;
+        while (attacks) {
+            s32 to = pop_lsb(&attacks);
+            add_move(list, from, to, (square_bb(to) & enemies) ? MOVE_CAPTURE : MOVE_QUIET);
+        }
+    }
+}
+
+static void generate_castling(const Position *pos, Move_List *list) {
+    s32 us = pos->side_to_move;
+    s32 them = us ^ 1;
+    Bitboard occupancy = occupied(pos);
+    u8 king_side = (us == WHITE) ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+    u8 queen_side = (us == WHITE) ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+    s32 king = (us == WHITE) ? E1 : E8;
+
+    if ((pos->castling & king_side)
+        && !(occupancy & (square_bb(king + 1) | square_bb(king + 2)))
+        && !is_square_attacked(pos, king + 1, them)
+        && !is_square_attacked(pos, king + 2, them)) {
+        add_move(list, king, king + 2, MOVE_KING_CASTLE);
+    }
+
+    if ((pos->castling & queen_side)
+        && !(occupancy & (square_bb(king - 1) | square_bb(king - 2) | square_bb(king - 3)))
+        && !is_square_attacked(pos, king - 1, them)
+        && !is_square_attacked(pos, king - 2, them)) {
+        add_move(list, king, king - 2, MOVE_QUEEN_CASTLE);
+    }
+}
+
+void generate_moves(const Position *pos, Move_List *list, s32 generate_type) {
+    s32 us = pos->side_to_move;
+    s32 king = king_square(pos, us);
+    Bitboard own = pos->colors[us];
+    Bitboard enemies = pos->colors[us ^ 1];
+    Bitboard checking = checkers(pos);
+
+    list->count = 0;
+
+    Bitboard targets = 0;
+    if (generate_type & GENERATE_CAPTURES)  targets |= enemies;
+    if (generate_type & GENERATE_QUIETS)    targets |= ~occupied(pos);
+
+    generate_piece_moves(pos, list, KING, targets & ~own);
+    if (checking && more_than_one(checking))  return;
+
+    Bitboard evasion_mask = ~0ULL;
+    if (checking) {
+        evasion_mask = between_table[king][lsb(checking)] | checking;
+    }
+
+    // Pawn pushes onto empty squares and promotions are filtered separately from 'targets'.
+    generate_pawn_moves(pos, list, generate_type, evasion_mask);
+    targets &= evasion_mask;
+    generate_piece_moves(pos, list, KNIGHT, targets);
+    generate_piece_moves(pos, list, BISHOP, targets);
+    generate_piece_moves(pos, list, ROOK, targets);
+    generate_piece_moves(pos, list, QUEEN, targets);
+
+    if (!checking && (generate_type & GENERATE_QUIETS) && (pos->castling & ((us == WHITE) ? (CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN) : (CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN)))) {
+        generate_castling(pos, list);
+    }
+}
+
+Bitboard pinned_pieces(const Position *pos, s32 color) {
+    s32 king = king_square(pos, color);
+    Bitboard them = pos->colors[color ^ 1];
+    Bitboard occupancy = occupied(pos);
+    Bitboard snipers = ((rook_attacks(king, 0) & (pos->pieces[ROOK] | pos->pieces[QUEEN]))
+                     | (bishop_attacks(king, 0) & (pos->pieces[BISHOP] | pos->pieces[QUEEN]))) & them;
+
+    Bitboard pinned = 0;
+    while (snipers) {
+        Bitboard blockers = between_table[king][pop_lsb(&snipers)] & occupancy;
+        if (blockers && !more_than_one(blockers))  pinned |= blockers & pos->colors[color];
+    }
+    return pinned;
+}
+
+bool is_legal(const Position *pos, Move move, Bitboard pinned) {
+    s32 us = pos->side_to_move;
+    s32 them = us ^ 1;
+    s32 from = move_from(move);
+    s32 to = move_to(move);
+    s32 king = king_square(pos, us);
+
+    if (move_flags(move) == MOVE_EP_CAPTURE) {
+        s32 captured_square = (us == WHITE) ? to - 8 : to + 8;
+        Bitboard occupancy = (occupied(pos) ^ square_bb(from) ^ square_bb(captured_square)) | square_bb(to);
+        Bitboard bishops = (pos->pieces[BISHOP] | pos->pieces[QUEEN]) & pos->colors[them];
+        Bitboard rooks = (pos->pieces[ROOK] | pos->pieces[QUEEN]) & pos->colors[them];
+        return !(bishop_attacks(king, occupancy) & bishops) && !(rook_attacks(king, occupancy) & rooks);
+    }
+
+    if (from == king) {
+        if (is_castling(move))  return true; // Path was checked during generation.
+        Bitboard occupancy = occupied(pos) ^ square_bb(from);
+        return !(attackers_to(pos, to, occupancy) & pos->colors[them]);
+    }
+
+    return !(pinned & square_bb(from)) || (line_table[from][to] & square_bb(king));
+}
+
+void generate_legal_moves(const Position *pos, Move_List *list) {
+    generate_moves(pos, list, GENERATE_ALL);
+
+    Bitboard pinned = pinned_pieces(pos, pos->side_to_move);
+    s32 king = king_square(pos, pos->side_to_move);
+    s32 count = 0;
+    For (list->count) {
+        Move move = list->moves[it];
+        // Most moves are neither king moves, en passant, nor by pinned pieces and need no check.
+        bool needs_check = (pinned && (pinned & square_bb(move_from(move)))) || move_from(move) == king || move_flags(move) == MOVE_EP_CAPTURE;
+        if (!needs_check || is_legal(pos, move, pinned)) {
+            list->moves[count++] = move;
+        }
+    }
+    list->count = count;
+}
+
+bool has_legal_moves(const Position *pos) {
+    Move_List list;
+    generate_legal_moves(pos, &list);
+    return list.count > 0;
+}
+
+u64 perft(Position *pos, s32 depth) {
+    if (depth <= 0)  return 1;
+
+    Move_List list;
+    generate_legal_moves(pos, &list);
+    // The leaves are counted without being made.
+    if (depth == 1)  return (u64)list.count;
+
+    u64 nodes = 0;
+    For (list.count) {
+        Undo_Info undo;
+        make_move(pos, list.moves[it], &undo);
+        nodes += perft(pos, depth - 1);
+        unmake_move(pos, list.moves[it], &undo);
+    }
+    return nodes;
+}
@@ -0,0 +1,45 @@
+#ifndef PAWN_MOVEGEN_H
+#define PAWN_MOVEGEN_H
+
+#include "position.h"
+
+//
+// --- Constants ---
+//
+const int MAX_MOVES = 256; // Known maximum is 218 legal moves in a single position.
+
+//
+// --- Enums ---
+//
+enum Generate_Type {
+    GENERATE_CAPTURES = (1 << 0), // Captures and all promotions.
+    GENERATE_QUIETS = (1 << 1),   // Everything else, castling included.
+    GENERATE_ALL = GENERATE_CAPTURES | GENERATE_QUIETS
+};
+
+//
+// --- Structs ---
+//
+struct Move_List {
+    Move moves[MAX_MOVES];
+    s32 count;
+};
+
+//
+// --- Functions ---
+//
+
+// Pseudo-legal moves: pieces may be left pinned, but check evasions are respected
+// (only king moves in double check, only blocks/captures of the checker in single check)
+// and castling is generated only when the king doesn't pass through attacked squares.
+void generate_moves(const Position *pos, Move_List *list, s32 generate_type);
+void generate_legal_moves(const Position *pos, Move_List *list);
+
+Bitboard pinned_pieces(const Position *pos, s32 color);
+bool is_legal(const Position *pos, Move move, Bitboard pinned);
+bool has_legal_moves(const Position *pos);
+
+// Leaf nodes of the legal move tree 'depth' plies deep, 1 for depth 0. 'pos' is left as it was.
+u64 perft(Position *pos, s32 depth);
+
+#endif /* PAWN_MOVEGEN_H */
@@ -0,0 +1,82 @@
+#ifndef PAWN_MPMC_H
+#define PAWN_MPMC_H
+
+#include <atomic>
+
+#include "spsc.h"
+
+//
+// --- Structs ---
+//
+
+// Lock-free bounded ring buffer for any number of producer and consumer threads.
+// 'N' is a power of two. Every slot carries a sequence number telling whose turn it is: 'index' when
+// it is free for the push claiming 'index', 'index + 1' once the item is in for the pop claiming it.
+template <typename T>
+struct Mpmc_Slot {
+    std::atomic<u32> sequence;
+    T item;
+};
+
+template <typename T, u32 N>
+struct Mpmc_Queue {
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> head;  // Next item to pop, claimed by consumers.
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> tail;  // Next slot to push, claimed by producers.
+    alignas(CACHE_LINE_SIZE) Mpmc_Slot<T> slots[N];
+};
+
+//
+// --- Functions ---
+//
+template <typename T, u32 N>
+void mpmc_init(Mpmc_Queue<T, N> *queue) {
+    static_assert((N & (N - 1)) == 0, "Mpmc_Queue size must be a power of two.");
+    For (N)  queue->slots[it].sequence.store((u32)it, std::memory_order_relaxed);
+    queue->head.store(0);
+    queue->tail.store(0);
+}
+
+// Any thread. False when the queue is full; nothing waits.
+template <typename T, u32 N>
+bool mpmc_push(Mpmc_Queue<T, N> *queue, const T &item) {
+    u32 tail = queue->tail.load(std::memory_order_relaxed);
+    for (;;) {
+        Mpmc_Slot<T> *slot = &queue->slots[tail & (N - 1)];
+        s32 turn = (s32)(slot->sequence.load(std::memory_order_acquire) - tail);
+        if (turn == 0) {
+            if (queue->tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+                slot->item = item;
+                slot->sequence.store(tail + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (turn < 0) {
+            // Still holds the item from N pushes ago.
+            return false;
+        } else {
+            tail = queue->tail.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+// Any thread. False when the queue is empty.
+template <typename T, u32 N>
+bool mpmc_pop(Mpmc_Queue<T, N> *queue, T *out_item) {
+    u32 head = queue->head.load(std::memory_order_relaxed);
+    for (;;) {
+        Mpmc_Slot<T> *slot = &queue->slots[head & (N - 1)];
+        s32 turn = (s32)(slot->sequence.load(std::memory_order_acquire) - (head + 1));
+        if (turn == 0) {
+            if (queue->head.compare_exchange_weak(head, head + 1, std::memory_order_relaxed)) {
+                *out_item = slot->item;
+                slot->sequence.store(head + N, std::memory_order_release);
+                return true;
+            }
+        } else if (turn < 0) {
+            return false;
+        } else {
+            head = queue->head.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+#endif /* PAWN_MPMC_H */
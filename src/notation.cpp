@@ -0,0 +1,274 @@
+#include <string.h>
+
+#include "notation.h"
+#include "movegen.h"
+
+static s32 char_to_piece_kind(char c) {
+    switch (c) {
+        case 'K': return KING;
+        case 'Q': return QUEEN;
+        case 'R': return ROOK;
+        case 'B': return BISHOP;
+        case 'N': return KNIGHT;
+        default:  return EMPTY;
+    }
+}
+
+static Move parse_castling(const Position *pos, s32 text_size) {
+    s32 flags;
+    if (text_size == 3)       flags = MOVE_KING_CASTLE;  // O-O
+    else if (text_size == 5)  flags = MOVE_QUEEN_CASTLE; // O-O-O
+    else return MOVE_NONE;
+
+    Move_List list;
+    generate_moves(pos, &list, GENERATE_QUIETS);
+    For (list.count) {
+        if (move_flags(list.moves[it]) == flags)  return list.moves[it];
+    }
+    return MOVE_NONE;
+}
+
+// Pieces of the side to move and of 'kind' (not pawns) that attack 'to'.
+static Bitboard piece_candidates(const Position *pos, s32 kind, s32 to) {
+    Bitboard occupancy = occupied(pos);
+    Bitboard attacks;
+    switch (kind) {
+        case KING:   attacks = king_attacks(to); break;
+        case QUEEN:  attacks = queen_attacks(to, occupancy); break;
+        case ROOK:   attacks = rook_attacks(to, occupancy); break;
+        case BISHOP: attacks = bishop_attacks(to, occupancy); break;
+        default:     attacks = knight_attacks(to); break;
+    }
+    return attacks & pieces_of(pos, pos->side_to_move, kind);
+}
+
+// Legal when not in check is answered by 'is_legal()'; evasions are rare enough to just be played out.
+static bool is_legal_candidate(const Position *pos, Move move, Bitboard pinned, bool check) {
+    if (!check)  return is_legal(pos, move, pinned);
+
+    Position copy = *pos;
+    Undo_Info undo;
+    make_move(&copy, move, &undo);
+    return !is_square_attacked(&copy, king_square(&copy, pos->side_to_move), copy.side_to_move);
+}
+
+Move parse_san_move(const Position *pos, const char *text, s32 text_size) {
+    // Strip suffixes: check, mate and annotation glyphs.
+    while (text_size > 0) {
+        char c = text[text_size - 1];
+        if (c == '+' || c == '#' || c == '!' || c == '?')  text_size--;
+        else break;
+    }
+    if (text_size < 2)  return MOVE_NONE;
+
+    if (text[0] == 'O' || text[0] == '0')  return parse_castling(pos, text_size);
+
+    s32 kind = char_to_piece_kind(text[0]);
+    s32 start = 0;
+    if (kind == EMPTY) {
+        kind = PAWN;
+    } else {
+        start = 1;
+    }
+
+    s32 promotion = EMPTY;
+    s32 end = text_size;
+    if (end >= 2 && text[end - 2] == '=') {
+        promotion = char_to_piece_kind(text[end - 1]);
+        end -= 2;
+    } else if (kind == PAWN && end >= 1 && char_to_piece_kind(text[end - 1]) != EMPTY) {
+        promotion = char_to_piece_kind(text[end - 1]); // "e8Q"
+        end -= 1;
+    }
+    if (end - start < 2)  return MOVE_NONE;
+
+    char to_file = text[end - 2];
+    char to_rank = text[end - 1];
+    if (to_file < 'a' || to_file > 'h' || to_rank < '1' || to_rank > '8')  return MOVE_NONE;
+    s32 to = make_square(to_file - 'a', to_rank - '1');
+
+    // Whatever is left between the piece letter and the destination is disambiguation and 'x'.
+    s32 from_file = -1;
+    s32 from_rank = -1;
+    for (s32 i = start; i < end - 2; i++) {
+        char c = text[i];
+        if (c >= 'a' && c <= 'h')       from_file = c - 'a';
+        else if (c >= '1' && c <= '8')  from_rank = c - '1';
+        else if (c != 'x' && c != ':' && c != '-')  return MOVE_NONE;
+    }
+
+    s32 us = pos->side_to_move;
+    s32 them = us ^ 1;
+    if (pos->colors[us] & square_bb(to))  return MOVE_NONE;
+    if (promotion == KING || promotion == PAWN)  return MOVE_NONE;
+
+    bool capture = pos->board[to] != NO_PIECE;
+
+    // Only pieces of the right kind that reach the destination are candidates.
+    Bitboard candidates;
+    if (kind == PAWN) {
+        bool last_rank = relative_rank(us, to) == 7;
+        if (last_rank != (promotion != EMPTY))  return MOVE_NONE;
+
+        candidates = 0;
+        Bitboard ours = pieces_of(pos, us, PAWN);
+        if (capture || to == pos->ep_square)  candidates |= pawn_attacks(them, to) & ours;
+        if (!capture) {
+            s32 behind = (us == WHITE) ? to - 8 : to + 8;
+            if (ours & square_bb(behind)) {
+                candidates |= square_bb(behind);
+            } else if (relative_rank(us, to) == 3 && pos->board[behind] == NO_PIECE) {
+                candidates |= ours & square_bb((us == WHITE) ? behind - 8 : behind + 8);
+            }
+        }
+    } else {
+        if (promotion != EMPTY)  return MOVE_NONE;
+        candidates = piece_candidates(pos, kind, to);
+    }
+
+    if (from_file >= 0)  candidates &= FILE_A_BB << from_file;
+    if (from_rank >= 0)  candidates &= RANK_1_BB << (8 * from_rank);
+    if (!candidates)  return MOVE_NONE;
+
+    Bitboard pinned = pinned_pieces(pos, us);
+    bool check = checkers(pos) != 0;
+    Move found = MOVE_NONE;
+    while (candidates) {
+        s32 from = pop_lsb(&candidates);
+        s32 flags = capture ? MOVE_CAPTURE : MOVE_QUIET;
+        if (kind == PAWN) {
+            if (square_file(from) != square_file(to) && !capture)  flags = MOVE_EP_CAPTURE;
+            if (from - to == 16 || to - from == 16)                 flags = MOVE_DOUBLE_PUSH;
+            if (promotion != EMPTY)  flags = (capture ? MOVE_PROMOTION_CAPTURE : MOVE_PROMOTION) + (KNIGHT - promotion);
+        }
+
+        Move move = new_move(from, to, flags);
+        if (!is_legal_candidate(pos, move, pinned, check))  continue;
+
+        if (found != MOVE_NONE)  return MOVE_NONE; // Ambiguous.
+        found = move;
+    }
+    return found;
+}
+
+Move parse_uci_move(const Position *pos, const char *text, s32 text_size) {
+    if (text_size < 4 || text_size > 5)  return MOVE_NONE;
+    if (text[0] < 'a' || text[0] > 'h' || text[1] < '1' || text[1] > '8')  return MOVE_NONE;
+    if (text[2] < 'a' || text[2] > 'h' || text[3] < '1' || text[3] > '8')  return MOVE_NONE;
+
+    s32 from = make_square(text[0] - 'a', text[1] - '1');
+    s32 to = make_square(text[2] - 'a', text[3] - '1');
+    s32 promotion = EMPTY;
+    if (text_size == 5) {
+        promotion = char_to_piece_kind((char)(text[4] - ('a' - 'A')));
+        if (promotion == EMPTY || promotion == KING)  return MOVE_NONE;
+    }
+
+    Move_List list;
+    generate_moves(pos, &list, GENERATE_ALL);
+    Bitboard pinned = pinned_pieces(pos, pos->side_to_move);
+    For (list.count) {
+        Move move = list.moves[it];
+        if (move_from(move) != from || move_to(move) != to)  continue;
+        if (is_promotion(move) ? promotion_kind(move) != promotion : promotion != EMPTY)  continue;
+        return is_legal(pos, move, pinned) ? move : MOVE_NONE;
+    }
+    return MOVE_NONE;
+}
+
+s32 move_to_san(const Position *pos, Move move, char *buffer) {
+    static const char PIECE_CHARS[] = " KQRBNP";
+
+    s32 from = move_from(move);
+    s32 to = move_to(move);
+    s32 kind = piece_kind(pos->board[from]);
+    s32 size = 0;
+
+    if (move_flags(move) == MOVE_KING_CASTLE) {
+        memcpy(buffer, "O-O", 3);
+        size = 3;
+    } else if (move_flags(move) == MOVE_QUEEN_CASTLE) {
+        memcpy(buffer, "O-O-O", 5);
+        size = 5;
+    } else if (kind == PAWN) {
+        if (is_capture(move)) {
+            buffer[size++] = (char)('a' + square_file(from));
+            buffer[size++] = 'x';
+        }
+        buffer[size++] = (char)('a' + square_file(to));
+        buffer[size++] = (char)('1' + square_rank(to));
+        if (is_promotion(move)) {
+            buffer[size++] = '=';
+            buffer[size++] = PIECE_CHARS[promotion_kind(move)];
+        }
+    } else {
+        buffer[size++] = PIECE_CHARS[kind];
+
+        // Other legal moves of the same kind of piece to the same square need disambiguation.
+        Bitboard others = piece_candidates(pos, kind, to) & ~square_bb(from);
+        if (others) {
+            Bitboard pinned = pinned_pieces(pos, pos->side_to_move);
+            bool check = checkers(pos) != 0;
+            Bitboard legal_others = 0;
+            while (others) {
+                s32 other = pop_lsb(&others);
+                if (is_legal_candidate(pos, new_move(other, to, move_flags(move)), pinned, check))  legal_others |= square_bb(other);
+            }
+
+            if (legal_others) {
+                Bitboard same_file = legal_others & (FILE_A_BB << square_file(from));
+                Bitboard same_rank = legal_others & (RANK_1_BB << (8 * square_rank(from)));
+                if (!same_file) {
+                    buffer[size++] = (char)('a' + square_file(from));
+                } else if (!same_rank) {
+                    buffer[size++] = (char)('1' + square_rank(from));
+                } else {
+                    buffer[size++] = (char)('a' + square_file(from));
+                    buffer[size++] = (char)('1' + square_rank(from));
+                }
+            }
+        }
+
+        if (is_capture(move))  buffer[size++] = 'x';
+        buffer[size++] = (char)('a' + square_file(to));
+        buffer[size++] = (char)('1' + square_rank(to));
+    }
+
+    Position after = *pos;
+    Undo_Info undo;
+    make_move(&after, move, &undo);
+    if (in_check(&after))  buffer[size++] = has_legal_moves(&after) ? '+' : '#';
+
+    buffer[size] = '\0';
+    return size;
+}
+
+s32 move_to_uci(Move move, char *buffer) {
+    s32 from = move_from(move);
+    s32 to = move_to(move);
+    s32 size = 0;
+    buffer[size++] = (char)('a' + square_file(from));
+    buffer[size++] = (char)('1' + square_rank(from));
+    buffer[size++] = (char)('a' + square_file(to));
+    buffer[size++] = (char)('1' + square_rank(to));
+    if (is_promotion(move)) {
+        static const char PROMOTION_CHARS[] = "  qrbn";
+        buffer[size++] = PROMOTION_CHARS[promotion_kind(move)];
+    }
+    buffer[size] = '\0';
+    return size;
+}
+
+s32 moves_to_san(const Position *pos, const Move *moves, s32 count, char *buffer) {
+    Position copy = *pos;
+    s32 size = 0;
+    buffer[0] = '\0';
+    For (count) {
+        if (size > 0)  buffer[size++] = ' ';
+        size += move_to_san(&copy, moves[it], buffer + size);
+
+        Undo_Info undo;
+        make_move(&copy, moves[it], &undo);
+    }
+    return size;
+}
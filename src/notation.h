@@ -0,0 +1,32 @@
+#ifndef PAWN_NOTATION_H
+#define PAWN_NOTATION_H
+
+#include "position.h"
+
+//
+// --- Constants ---
+//
+const int MOVE_TEXT_SIZE = 10; // Longest SAN ("Qa1xb2+", "exd8=Q#") or UCI move plus the terminator, rounded up.
+
+//
+// --- Functions ---
+//
+
+// Returns MOVE_NONE if the text is not a legal move in this position.
+// Accepts check/mate/annotation suffixes ("+", "#", "!?") and "0-0" style castling.
+Move parse_san_move(const Position *pos, const char *text, s32 text_size);
+
+// Decodes "e2e4"/"e7e8q"; castling is the king's two-square move. MOVE_NONE if not legal here.
+Move parse_uci_move(const Position *pos, const char *text, s32 text_size);
+
+// Writes the move (legal in 'pos') with minimal disambiguation and a '+'/'#' suffix.
+// 'buffer' holds at least MOVE_TEXT_SIZE bytes; returns the length.
+s32 move_to_san(const Position *pos, Move move, char *buffer);
+
+// Writes "e2e4"/"e7e8q" into 'buffer' (at least MOVE_TEXT_SIZE bytes) and returns the length.
+s32 move_to_uci(Move move, char *buffer);
+
+// Writes the line played from 'pos' as space-separated SAN, 'buffer' holding MOVE_TEXT_SIZE bytes per move.
+s32 moves_to_san(const Position *pos, const Move *moves, s32 count, char *buffer);
+
+#endif /* PAWN_NOTATION_H */
@@ -0,0 +1,50 @@
+#include "packed.h"
+
+static_assert(sizeof(Packed_Position) == 32, "Packed positions must stay 32 bytes.");
+
+const u8 PACKED_WHITE_TO_MOVE = 0;
+const u8 PACKED_BLACK_TO_MOVE = (1 << 4);
+
+//
+// --- Interface ---
+//
+void pack_position(const Position *pos, Packed_Position *out) {
+    mem_zero(out, sizeof(Packed_Position));
+
+    Bitboard b = occupied(pos);
+    out->occupancy = b;
+    s32 index = 0;
+    while (b && index < 32) {
+        s32 square = pop_lsb(&b);
+        out->pieces[index / 2] |= (u8)(pos->board[square] << (4 * (index & 1)));
+        index++;
+    }
+
+    out->state = pos->castling | ((pos->side_to_move == WHITE) ? PACKED_WHITE_TO_MOVE : PACKED_BLACK_TO_MOVE);
+    out->ep_square = pos->ep_square;
+    out->halfmove_clock = (pos->halfmove_clock > 255) ? 255 : (u8)pos->halfmove_clock;
+    out->fullmove_number = pos->fullmove_number;
+}
+
+bool unpack_position(const Packed_Position *packed, Position *out) {
+    clear_position(out);
+    if (popcount(packed->occupancy) > 32)  return false;
+
+    Bitboard b = packed->occupancy;
+    s32 index = 0;
+    while (b) {
+        s32 square = pop_lsb(&b);
+        Piece_Code piece = (packed->pieces[index / 2] >> (4 * (index & 1))) & 15;
+        if (piece_kind(piece) < KING || piece_kind(piece) > PAWN)  return false;
+        put_piece(out, piece, square);
+        index++;
+    }
+
+    out->side_to_move = (packed->state & PACKED_BLACK_TO_MOVE) ? BLACK : WHITE;
+    out->castling = packed->state & CASTLE_ALL;
+    out->ep_square = (packed->ep_square < SQUARE_COUNT) ? packed->ep_square : (u8)NO_SQUARE;
+    out->halfmove_clock = packed->halfmove_clock;
+    out->fullmove_number = packed->fullmove_number;
+    out->key = compute_key(out);
+    return true;
+}
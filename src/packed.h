@@ -0,0 +1,29 @@
+#ifndef PAWN_PACKED_H
+#define PAWN_PACKED_H
+
+#include "position.h"
+
+//
+// --- Structs ---
+//
+
+// A position in 32 bytes: the occupied squares, then the piece on each of them in 4 bits, in square order.
+struct Packed_Position {
+    Bitboard occupancy;
+    u8 pieces[16];          // Piece_Code per occupied square, two per byte, the lower square in the low nibble.
+    u8 state;               // Castling_Flag bits, side to move in bit 4.
+    u8 ep_square;           // NO_SQUARE when there is none.
+    u8 halfmove_clock;      // Capped at 255.
+    u8 padding;
+    u16 fullmove_number;
+    u8 padding2[2];
+};
+
+//
+// --- Functions ---
+//
+void pack_position(const Position *pos, Packed_Position *out);
+// Only checks that every piece code is valid, not that the position is legal. False otherwise.
+bool unpack_position(const Packed_Position *packed, Position *out);
+
+#endif /* PAWN_PACKED_H */
@@ -1,3 +1,7 @@
+// snprintf()
+#include <stdio.h>
+// strlen()
+#include <string.h>
 // time()
 #include <time.h>
 
@@ -18,20 +22,63 @@
 #include "immediate.h"
 #include "input.h"
 #include "array.h"
+#include "analysis.h"
+#include "cli.h"
+#include "engine.h"
+#include "fen.h"
 
 //
 // --- Global variables ---
 //
 u32 game_state;
-bool imgui_states[] = { true, false, false, false, true };
+bool imgui_states[] = { true, false, false, false, true, true, false };
 
 extern Renderer_Info renderer_info;
 
 static Texture g_game_image;
 
+const s64 ANALYSIS_HASH_MEGABYTES = 64;
+const char *ANALYSIS_TT_FILEPATH = "analysis.tt";  // Analysis picks up where the last session left off.
+const s32 ANALYSIS_MAX_LINES = 5;
+
+static Engine *g_engine;
+static Engine_Info g_analysis[ANALYSIS_MAX_LINES];  // Latest snapshot of every line from the engine thread.
+static s32 g_analysis_lines = 3;
+static u32 g_analysis_search_id;      // 0 while idle.
+static Engine_Opponent *g_opponent;
+static char g_analysis_fen[FEN_MAX_SIZE];
+static char g_analysis_move[MOVE_TEXT_SIZE];
+static Game_History g_analysis_history;   // Moves played from the FEN, for taking them back and forth.
+static char g_analysis_moves_text[MAX_GAME_PLY * MOVE_TEXT_SIZE];
+
+// Time-sliced analysis on the render thread, for single-core machines.
+static bool g_sliced_mode;
+static s32 g_slice_microseconds = 4000;
+static Transposition_Table g_sliced_tt;
+static Searcher *g_sliced_searcher;
+static Sliced_Search *g_sliced_search;
+static Position g_sliced_root;
+
+const char *SEARCH_STATS_FILEPATH = "search_stats.json";
+static Search_Summary g_search_summary;   // Of whichever analysis search runs, refreshed every frame.
+
+// Whole-game analysis of the moves in 'g_analysis_history', on its own threads next to the engine's.
+const char *ANALYSIS_PGN_FILEPATH = "analysis.pgn";
+static Analysis_Options g_game_analysis_options;
+static Game_Analysis *g_game_analysis;    // NULL while idle.
+static Thread g_game_analysis_thread;
+static std::atomic<bool> g_game_analysis_done;
+static bool g_game_analysis_ok;
+
 int main(int arguments_count, char **arguments) {
     ZoneScoped;
 
+    // Headless tools ("pawn book ...") run and exit before any window is created.
+    int cli_exit_code;
+    if (run_cli_command(arguments_count, arguments, &cli_exit_code)) {
+        exit(cli_exit_code);
+    }
+
     test_allocators();
     // array_test();
 
@@ -40,6 +87,14 @@ int main(int arguments_count, char **arguments) {
     init_input_system();
     init_renderer();
 
+    // The search runs on its own thread, so rendering never waits for it.
+    init_chess();
+    g_engine = start_engine(ANALYSIS_HASH_MEGABYTES, ANALYSIS_TT_FILEPATH);
+    snprintf(g_analysis_fen, FEN_MAX_SIZE, "%s", START_FEN);
+    Position start;
+    set_start_position(&start);
+    reset_history(&g_analysis_history, &start);
+
     game_state = TITLE_SCREEN;
 
     g_game_image = load_texture_from_file("resources/textures/pawn.png");
@@ -58,10 +113,22 @@ int main(int arguments_count, char **arguments) {
 
         // process_input(window);
         process_input();
+        poll_engine();
 
         renderer_draw(game_state);
     }
 
+    if (g_game_analysis) {
+        g_game_analysis->stop.store(true);
+        join_thread(&g_game_analysis_thread);
+        FREE(sys_allocator, g_game_analysis);
+    }
+    stop_engine(g_engine);
+    if (g_sliced_search) {
+        destroy_sliced_search(g_sliced_search);
+        destroy_searcher(g_sliced_searcher);
+        tt_free(&g_sliced_tt);
+    }
     game_exit();
 
     exit(EXIT_SUCCESS);
@@ -231,6 +298,112 @@ void draw_settings_screen() {
     // draw_rect(vsync_rect, text_color, GL_LINE_STRIP);
 }
 
+static void sliced_report_proc(void *data, const Search_Report *report) {
+    if (report->multi_pv > ANALYSIS_MAX_LINES)  return;
+    Engine_Info *info = &g_analysis[report->multi_pv - 1];
+    info->kind = ENGINE_INFO_ITERATION;
+    info->depth = report->depth;
+    info->seldepth = report->seldepth;
+    info->score = report->score;
+    info->bound = report->bound;
+    info->multi_pv = report->multi_pv;
+    info->nodes = report->nodes;
+    info->time = report->time;
+    info->nps = (report->time > 0) ? report->nodes * 1000000 / report->time : 0;
+    info->hashfull = tt_hashfull(&g_sliced_tt);
+    info->pv_length = report->pv_length;
+    For (report->pv_length)  info->pv[it] = report->pv[it];
+    moves_to_san(&g_sliced_root, report->pv, report->pv_length, info->pv_text);
+}
+
+static void start_sliced_analysis(const Position *pos, const Search_Limits *limits, const u64 *game_keys, s32 game_key_count) {
+    if (!g_sliced_search) {
+        if (!tt_init(&g_sliced_tt, ANALYSIS_HASH_MEGABYTES))  return;
+        g_sliced_searcher = create_searcher(&g_sliced_tt);
+        g_sliced_searcher->report_proc = sliced_report_proc;
+        g_sliced_search = create_sliced_search(g_sliced_searcher);
+    }
+    g_sliced_root = *pos;
+    clear_stop_request(g_sliced_searcher);
+    start_sliced_search(g_sliced_search, pos, limits, game_keys, game_key_count);
+}
+
+// Called by 'renderer_draw()' once per frame.
+void advance_sliced_analysis() {
+    if (!g_sliced_search || !g_sliced_search->running)  return;
+    advance_sliced_search(g_sliced_search, (u64)g_slice_microseconds);
+}
+
+static void start_analysis(const Position *pos, const Game_History *history) {
+    u64 keys[FIFTY_MOVE_PLY];
+    s32 key_count = get_history_keys(history, keys);
+
+    Search_Limits limits = { };
+    limits.infinite = true;
+    limits.multi_pv = g_analysis_lines;
+    mem_zero(g_analysis, sizeof(g_analysis));
+    if (g_sliced_mode) {
+        engine_stop(g_engine);
+        g_analysis_search_id = 0;
+        start_sliced_analysis(pos, &limits, keys, key_count);
+    } else {
+        if (g_sliced_search)  g_sliced_search->running = false;
+        engine_set_position(g_engine, pos, keys, key_count);
+        g_analysis_search_id = engine_go(g_engine, &limits);
+    }
+}
+
+static void game_analysis_proc(void *data) {
+    Game_Analysis *analysis = (Game_Analysis *)data;
+    g_game_analysis_ok = analyze_game(&g_game_analysis_options, analysis);
+    g_game_analysis_done.store(true);
+}
+
+// Every move of the history, redo moves included, from its start.
+static void start_game_analysis() {
+    const Game_History *history = &g_analysis_history;
+    if (g_game_analysis || history->ply_count == 0)  return;
+
+    g_game_analysis = ALLOC(sys_allocator, 1, Game_Analysis);
+    mem_zero(g_game_analysis, sizeof(Game_Analysis));
+    g_game_analysis->start = history->start;
+    g_game_analysis->move_count = history->ply_count;
+    For (history->ply_count)  g_game_analysis->moves[it] = history->moves[it];
+
+    g_game_analysis_options = { };
+    g_game_analysis_options.depth = ANALYSIS_DEFAULT_DEPTH;
+    g_game_analysis_options.hash_megabytes = ANALYSIS_DEFAULT_HASH;
+    g_game_analysis_done.store(false);
+    g_game_analysis_thread = create_thread(game_analysis_proc, g_game_analysis);
+}
+
+static void finish_game_analysis() {
+    join_thread(&g_game_analysis_thread);
+    Game_Analysis *analysis = g_game_analysis;
+    if (!g_game_analysis_ok) {
+        console_log("Game analysis stopped.\n");
+    } else if (save_annotated_pgn(ANALYSIS_PGN_FILEPATH, analysis)) {
+        For (2) {
+            const s32 *counts = analysis->judgement_counts[it];
+            console_log("%s: %d inaccuracies, %d mistakes, %d blunders, average loss %d cp.\n", (it == WHITE) ? "White" : "Black",
+                        counts[JUDGEMENT_INACCURACY], counts[JUDGEMENT_MISTAKE], counts[JUDGEMENT_BLUNDER], analysis->average_loss[it]);
+        }
+        console_log("Game analysis saved to '%s'.\n", ANALYSIS_PGN_FILEPATH);
+    }
+    FREE(sys_allocator, analysis);
+    g_game_analysis = NULL;
+}
+
+// After the analysis position changed by a move or by taking one back. A running analysis follows it.
+static void analysis_position_changed() {
+    const Game_History *history = &g_analysis_history;
+    position_to_fen(&history->position, g_analysis_fen);
+    moves_to_san(&history->start, history->moves, history->ply, g_analysis_moves_text);
+
+    bool running = g_analysis_search_id || (g_sliced_search && g_sliced_search->running);
+    if (running)  start_analysis(&history->position, history);
+}
+
 void make_imgui_layout() {
     ZoneScoped;
 
@@ -255,6 +428,8 @@ void make_imgui_layout() {
         ImGui::Checkbox("Demo Window", &imgui_states[DRAW_DEMO_WINDOW]);
         ImGui::Checkbox("Constants Window", &imgui_states[DRAW_CONSTANTS_WINDOW]);
         ImGui::Checkbox("Globals Window", &imgui_states[DRAW_GLOBALS_WINDOW]);
+        ImGui::Checkbox("Analysis Window", &imgui_states[DRAW_ANALYSIS_WINDOW]);
+        ImGui::Checkbox("Search Window", &imgui_states[DRAW_SEARCH_WINDOW]);
         ImGui::ColorEdit3("Clear color", &io->clear_color.r);
         ImGui::NewLine();
         ImGui::Text("GPU Vendor: %s", renderer_info.gpu_vendor);
@@ -281,6 +456,159 @@ void make_imgui_layout() {
 
         ImGui::End();
     }
+
+    if (imgui_states[DRAW_ANALYSIS_WINDOW] && g_engine) {
+        ImGui::Begin("Analysis");
+        ImGui::InputText("FEN", g_analysis_fen, FEN_MAX_SIZE);
+
+        ImGui::SliderInt("Lines", &g_analysis_lines, 1, ANALYSIS_MAX_LINES);
+        ImGui::Checkbox("Time-sliced", &g_sliced_mode);
+        if (g_sliced_mode) {
+            ImGui::SameLine();
+            ImGui::SliderInt("us/frame", &g_slice_microseconds, 250, 16000);
+        }
+
+        if (ImGui::Button("Analyze")) {
+            Position pos;
+            if (parse_fen(&pos, g_analysis_fen)) {
+                // Keep the moves played when the FEN is still the one they lead to.
+                if (pos.key != g_analysis_history.position.key) {
+                    reset_history(&g_analysis_history, &pos);
+                    g_analysis_moves_text[0] = '\0';
+                }
+                start_analysis(&pos, &g_analysis_history);
+            } else {
+                console_log("Invalid FEN '%s'.\n", g_analysis_fen);
+            }
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Stop")) {
+            engine_stop(g_engine);
+            if (g_sliced_searcher)  stop_search(g_sliced_searcher);
+        }
+
+        ImGui::InputText("Move", g_analysis_move, MOVE_TEXT_SIZE);
+        ImGui::SameLine();
+        if (ImGui::Button("Play")) {
+            Game_History *history = &g_analysis_history;
+            Move move = parse_san_move(&history->position, g_analysis_move, (s32)strlen(g_analysis_move));
+            if (move == MOVE_NONE)  move = parse_uci_move(&history->position, g_analysis_move, (s32)strlen(g_analysis_move));
+            if (move == MOVE_NONE) {
+                console_log("Illegal move '%s'.\n", g_analysis_move);
+            } else if (!history_make_move(history, move)) {
+                console_log("Game history is full.\n");
+            } else {
+                g_analysis_move[0] = '\0';
+                analysis_position_changed();
+            }
+        }
+        if (ImGui::Button("Undo") && history_undo(&g_analysis_history))  analysis_position_changed();
+        ImGui::SameLine();
+        if (ImGui::Button("Redo") && history_redo(&g_analysis_history))  analysis_position_changed();
+        ImGui::SameLine();
+        ImGui::Text("Ply %d/%d", g_analysis_history.ply, g_analysis_history.ply_count);
+        if (g_analysis_history.ply > 0)  ImGui::TextWrapped("%s", g_analysis_moves_text);
+
+        if (!g_game_analysis) {
+            if (ImGui::Button("Analyze game"))  start_game_analysis();
+        } else {
+            if (ImGui::Button("Stop game analysis"))  g_game_analysis->stop.store(true);
+            ImGui::SameLine();
+            ImGui::Text("%d/%d positions", g_game_analysis->finished.load(), g_game_analysis->move_count + 1);
+        }
+
+        const Engine_Info *best = &g_analysis[0];
+        bool running = g_analysis_search_id || (g_sliced_search && g_sliced_search->running);
+        ImGui::Text("%s", running ? "Running" : "Idle");
+        ImGui::Text("Depth %d/%d  Nodes %llu  %llu kN/s  Hash %.1f%%", best->depth, best->seldepth, (unsigned long long)best->nodes,
+                    (unsigned long long)(best->nps / 1000), (float)best->hashfull / 10.0f);
+        For (ANALYSIS_MAX_LINES) {
+            const Engine_Info *info = &g_analysis[it];
+            if (info->depth == 0)  continue;
+
+            char score[32];
+            if (is_mate_score(info->score)) {
+                snprintf(score, sizeof(score), "#%d", mate_in_moves(info->score));
+            } else {
+                snprintf(score, sizeof(score), "%+.2f", (float)info->score / 100.0f);
+            }
+            const char *bound = (info->bound == BOUND_LOWER) ? ">=" : (info->bound == BOUND_UPPER) ? "<=" : "";
+            ImGui::Separator();
+            ImGui::TextWrapped("%d. %s%s  d%d  %s", it + 1, bound, score, info->depth, info->pv_text);
+        }
+        ImGui::End();
+    }
+
+    if (imgui_states[DRAW_SEARCH_WINDOW]) {
+        const Search_Summary *summary = &g_search_summary;
+        const Search_Stats *totals = &summary->totals;
+
+        ImGui::Begin("Search");
+        ImGui::Text("Nodes %llu  (%.1f%% quiescence)  %llu kN/s", (unsigned long long)totals->nodes, summary->qnode_rate * 100.0,
+                    (unsigned long long)(summary->nps / 1000));
+        ImGui::Text("TT hits %.1f%%  cutoffs %llu", summary->tt_hit_rate * 100.0, (unsigned long long)totals->tt_cutoffs);
+        ImGui::Text("First move cutoffs %.1f%%", summary->first_move_cutoff_rate * 100.0);
+        ImGui::Text("Null move cutoffs %.1f%% of %llu", summary->null_move_cutoff_rate * 100.0, (unsigned long long)totals->null_move_tries);
+        ImGui::Text("LMR kept %.1f%% of %llu", summary->lmr_success_rate * 100.0, (unsigned long long)totals->lmr_tries);
+        ImGui::Text("Branching factor %.2f", summary->branching_factor);
+        if (ImGui::Button("Save JSON"))  save_search_summary(SEARCH_STATS_FILEPATH, summary);
+
+        ImGui::Separator();
+        For (summary->iteration_count) {
+            const Search_Iteration *iteration = &summary->iterations[it];
+            u64 nodes = iteration->nodes - ((it > 0) ? summary->iterations[it - 1].nodes : 0);
+            u64 time = iteration->time - ((it > 0) ? summary->iterations[it - 1].time : 0);
+            ImGui::Text("d%-3d %12llu nodes %9.1f ms", iteration->depth, (unsigned long long)nodes, (double)time / 1000.0);
+        }
+        ImGui::End();
+    }
+}
+
+static void engine_opponent_info(Engine_Opponent *opponent, const Engine_Info *info) {
+    if (info->kind != ENGINE_INFO_BEST_MOVE || opponent->pondering)  return;
+
+    float seconds = (float)(get_time_microseconds() - opponent->turn_start) / 1000000.0f;
+    update_player_clock(&opponent->board->players[opponent->player], seconds);
+    opponent->search_id = 0;
+    opponent->decided_move = info->best_move;
+    opponent->ponder_move = info->ponder_move;
+}
+
+static void engine_opponent_think(Engine_Opponent *opponent) {
+    Search_Limits limits = get_clock_limits(&opponent->board->players[opponent->player]);
+    u64 keys[FIFTY_MOVE_PLY];
+    s32 key_count = get_history_keys(&opponent->history, keys);
+    engine_set_position(opponent->engine, &opponent->history.position, keys, key_count);
+    opponent->search_id = engine_go(opponent->engine, &limits);
+    opponent->pondering = false;
+    opponent->turn_start = get_time_microseconds();
+}
+
+// Drains the engine's info queue once per frame; only the newest snapshot of each line is shown.
+void poll_engine() {
+    ZoneScoped;
+
+    if (!g_engine)  return;
+
+    if (g_game_analysis && g_game_analysis_done.load())  finish_game_analysis();
+
+    Engine_Info info;
+    while (engine_poll(g_engine, &info)) {
+        if (g_opponent && g_opponent->search_id != 0 && info.search_id == g_opponent->search_id) {
+            engine_opponent_info(g_opponent, &info);
+            continue;
+        }
+        if (info.search_id != g_analysis_search_id)  continue;
+        if (info.kind == ENGINE_INFO_BEST_MOVE) {
+            g_analysis_search_id = 0;
+            continue;
+        }
+        if (info.multi_pv <= ANALYSIS_MAX_LINES)  g_analysis[info.multi_pv - 1] = info;
+    }
+
+    if (g_sliced_mode && g_sliced_searcher)  summarize_search(&g_sliced_searcher, 1, &g_search_summary);
+    else                                      engine_search_summary(g_engine, &g_search_summary);
+    if (g_analysis_search_id || (g_sliced_search && g_sliced_search->running))  plot_search_summary(&g_search_summary);
 }
 
 void print_game_state(u32 game_state) {
@@ -312,3 +640,84 @@ Board create_board(Allocator *allocator, s32 rows, s32 columns, s32 player_count
 
     return board;
 }
+
+Search_Limits get_clock_limits(const Board_Player *player) {
+    Search_Limits limits = { };
+    if (player->total_time_left > 0.0f) {
+        limits.time_left = (s64)(player->total_time_left * 1000.0f);
+        limits.increment = (s64)(player->increment * 1000.0f);
+        limits.moves_to_go = player->moves_to_go;
+    }
+    // A per-move limit tighter than the clock is a clock of its own that runs out after this move.
+    if (player->move_time_left > 0.0f && (player->total_time_left <= 0.0f || player->move_time_left < player->total_time_left)) {
+        limits.time_left = (s64)(player->move_time_left * 1000.0f);
+        limits.increment = 0;
+        limits.moves_to_go = 1;
+    }
+    return limits;
+}
+
+void update_player_clock(Board_Player *player, float seconds_spent) {
+    player->total_time_left += player->increment - seconds_spent;
+    if (player->moves_to_go > 0)  player->moves_to_go--;
+    player->moves_made++;
+    player->average_time_per_move += (seconds_spent - player->average_time_per_move) / (float)player->moves_made;
+}
+
+void start_engine_opponent(Engine_Opponent *opponent, Engine *engine, Board *board, s32 player, const Position *pos) {
+    mem_zero(opponent, sizeof(Engine_Opponent));
+    opponent->engine = engine;
+    opponent->board = board;
+    opponent->player = player;
+    reset_history(&opponent->history, pos);
+    g_opponent = opponent;
+
+    if (board->player_turn == player)  engine_opponent_think(opponent);
+}
+
+void stop_engine_opponent(Engine_Opponent *opponent) {
+    if (opponent->search_id != 0)  engine_stop(opponent->engine);
+    opponent->search_id = 0;
+    if (g_opponent == opponent)  g_opponent = NULL;
+}
+
+void engine_opponent_move_made(Engine_Opponent *opponent, Move move) {
+    ZoneScoped;
+
+    history_make_move(&opponent->history, move);
+    opponent->decided_move = MOVE_NONE;
+
+    if (opponent->board->player_turn == opponent->player) {
+        // The opponent replied. On a hit the ponder search just keeps going, now on the engine's clock.
+        if (opponent->pondering && opponent->search_id != 0 && move == opponent->ponder_move) {
+            engine_ponder_hit(opponent->engine, opponent->search_id);
+            opponent->pondering = false;
+            opponent->turn_start = get_time_microseconds();
+        } else {
+            engine_opponent_think(opponent);
+        }
+        return;
+    }
+
+    // The engine moved: think on the opponent's time, assuming the reply from its principal variation.
+    opponent->search_id = 0;
+    opponent->pondering = false;
+    Move_List legal;
+    generate_legal_moves(&opponent->history.position, &legal);
+    bool expected = false;
+    For (legal.count) {
+        if (legal.moves[it] == opponent->ponder_move)  expected = true;
+    }
+    if (!expected)  return;
+
+    // Searched as if the reply was already in the history, then taken back.
+    if (!history_make_move(&opponent->history, opponent->ponder_move))  return;
+    Position ponder_position = opponent->history.position;
+    u64 keys[FIFTY_MOVE_PLY];
+    s32 key_count = get_history_keys(&opponent->history, keys);
+    history_undo(&opponent->history);
+    Search_Limits limits = get_clock_limits(&opponent->board->players[opponent->player]);
+    engine_set_position(opponent->engine, &ponder_position, keys, key_count);
+    opponent->search_id = engine_go_ponder(opponent->engine, &limits);
+    opponent->pondering = (opponent->search_id != 0);
+}
@@ -2,6 +2,9 @@
 #define PAWN_PAWN_H
 
 #include "common.h"
+#include "engine.h"
+#include "history.h"
+#include "position.h"
 
 //
 // --- Constants ---
@@ -39,16 +42,6 @@ struct Frametime {
     float delta = 0.0f;
 };
 
-enum Piece_Kind {
-    EMPTY = 0,
-    KING = 1,
-    QUEEN = 2,
-    ROOK = 3,
-    BISHOP = 4,
-    KNIGHT = 5,
-    PAWN = 6
-};
-
 struct Piece {
     int player_id;
     Piece_Kind kind;
@@ -71,6 +64,7 @@ struct Player {
     float average_time_per_move;
 };
 
+// Times in seconds. 'move_time_left' > 0 caps the current move, 'total_time_left' is the game clock.
 struct Board_Player {
     Player player;
     
@@ -79,6 +73,8 @@ struct Board_Player {
     float average_time_per_move;
     float move_time_left;
     float total_time_left;
+    float increment;
+    s32 moves_to_go;       // Until the next time control, 0 for sudden death.
 };
 
 const int BOARD_WIDTH = 8;
@@ -96,6 +92,20 @@ struct Board {
     s32 player_turn;
 };
 
+// The engine moving for one player of a board game. Searches on its own turn and ponders the
+// expected reply while 'Board.player_turn' belongs to the other player.
+struct Engine_Opponent {
+    Engine *engine;
+    Board *board;
+    s32 player;            // Index into 'board->players'.
+    Game_History history;  // The game so far, kept in step by 'engine_opponent_move_made()'.
+    u32 search_id;         // 0 when not searching.
+    bool pondering;        // 'search_id' assumes 'ponder_move' as the reply.
+    Move ponder_move;
+    Move decided_move;     // Set once the engine's move is ready; play it and pass it on as any other move.
+    u64 turn_start;        // Microseconds, when the engine's clock started running.
+};
+
 struct Button {
     float x;
     float y;
@@ -142,7 +152,9 @@ enum Imgui_State {
     DRAW_DEMO_WINDOW = 1,
     DRAW_CONSTANTS_WINDOW = 2,
     DRAW_GLOBALS_WINDOW = 3,
-    DRAW_INPUT_WINDOW = 4
+    DRAW_INPUT_WINDOW = 4,
+    DRAW_ANALYSIS_WINDOW = 5,
+    DRAW_SEARCH_WINDOW = 6
 };
 
 enum Game_State {
@@ -161,9 +173,22 @@ void draw_settings_screen();
 void draw_pause_screen();
 
 void make_imgui_layout();
+void poll_engine();
+void advance_sliced_analysis();
 void print_game_state(u32 game_state);
 void game_exit();
 
 Board create_board(Allocator *allocator, s32 rows, s32 columns, s32 player_count);
 
+// Search limits for the engine moving for 'player', taken from its clock.
+Search_Limits get_clock_limits(const Board_Player *player);
+// Takes a finished move off the clock and adds the increment.
+void update_player_clock(Board_Player *player, float seconds_spent);
+
+// Infos of the opponent's searches are picked up by 'poll_engine()'. One opponent at a time.
+void start_engine_opponent(Engine_Opponent *opponent, Engine *engine, Board *board, s32 player, const Position *pos);
+void stop_engine_opponent(Engine_Opponent *opponent);
+// Call after every move of the game, by either side, once 'board->player_turn' has passed on.
+void engine_opponent_move_made(Engine_Opponent *opponent, Move move);
+
 #endif /* PAWN_PAWN_H */
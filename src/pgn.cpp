@@ -0,0 +1,374 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PGN_SSE2 1
+#endif
+
+#include "pgn.h"
+#include "notation.h"
+#include "platform.h"
+
+//
+// --- Structs ---
+//
+struct Pgn_Job {
+    const char *text;
+    s64 size;
+    const Pgn_Parse_Options *options;
+    std::atomic<s64> next_chunk;
+};
+
+struct Pgn_Worker {
+    Pgn_Job *job;
+    s32 index;
+    Pgn_Parse_Stats stats;
+};
+
+const s64 PGN_CHUNK_SIZE = 1 << 20;
+
+//
+// --- Scanning ---
+//
+
+// Offset of the first '[' at or after 'offset' that starts a line, or 'size'.
+static s64 find_line_start_bracket(const char *text, s64 size, s64 offset) {
+    s64 i = offset;
+    if (i == 0) {
+        if (size > 0 && text[0] == '[')  return 0;
+        i = 1;
+    }
+
+#if defined(__AVX2__)
+    const __m256i newline = _mm256_set1_epi8('\n');
+    const __m256i bracket = _mm256_set1_epi8('[');
+    for (; i + 32 <= size; i += 32) {
+        __m256i current = _mm256_loadu_si256((const __m256i *)(text + i));
+        __m256i previous = _mm256_loadu_si256((const __m256i *)(text + i - 1));
+        __m256i hits = _mm256_and_si256(_mm256_cmpeq_epi8(current, bracket), _mm256_cmpeq_epi8(previous, newline));
+        u32 mask = (u32)_mm256_movemask_epi8(hits);
+        if (mask)  return i + lsb(mask);
+    }
+#elif defined(PGN_SSE2)
+    const __m128i newline = _mm_set1_epi8('\n');
+    const __m128i bracket = _mm_set1_epi8('[');
+    for (; i + 16 <= size; i += 16) {
+        __m128i current = _mm_loadu_si128((const __m128i *)(text + i));
+        __m128i previous = _mm_loadu_si128((const __m128i *)(text + i - 1));
+        __m128i hits = _mm_and_si128(_mm_cmpeq_epi8(current, bracket), _mm_cmpeq_epi8(previous, newline));
+        u32 mask = (u32)_mm_movemask_epi8(hits);
+        if (mask)  return i + lsb(mask);
+    }
+#endif
+
+    for (; i < size; i++) {
+        if (text[i] == '[' && text[i - 1] == '\n')  return i;
+    }
+    return size;
+}
+
+// True for "[Name "" at 'i', so a movetext line that happens to start with a bracket isn't taken for a tag.
+static bool is_tag_start(const char *text, s64 size, s64 i) {
+    if (text[i] != '[')  return false;
+    s64 j = i + 1;
+    while (j < size) {
+        char c = text[j];
+        if (!((c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '_'))  break;
+        j++;
+    }
+    if (j == i + 1)  return false;
+    while (j < size && (text[j] == ' ' || text[j] == '\t'))  j++;
+    return j < size && text[j] == '"';
+}
+
+// True if the line before the one starting at 'i' is a tag, i.e. 'i' continues a tag section. Blank
+// lines, movetext and the start of the file aren't.
+static bool follows_tag_line(const char *text, s64 size, s64 i) {
+    s64 end = i - 1;   // 'text[i - 1]' ends the line before.
+    if (end <= 0)  return false;
+    s64 start = end;
+    while (start > 0 && text[start - 1] != '\n')  start--;
+    while (start < end && (text[start] == ' ' || text[start] == '\t'))  start++;
+    return start < end && is_tag_start(text, size, start);
+}
+
+s64 pgn_next_game_start(const char *text, s64 size, s64 offset) {
+    // Only tags at the start of a line are looked at. Import format requires neither the Event tag to
+    // come first nor a blank line before the tags, so a game starts at the first tag after anything but
+    // another tag.
+    s64 i = find_line_start_bracket(text, size, offset);
+    while (i < size) {
+        if (is_tag_start(text, size, i) && !follows_tag_line(text, size, i))  return i;
+        i = find_line_start_bracket(text, size, i + 1);
+    }
+    return size;
+}
+
+static inline bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool is_token_end(char c) {
+    return is_space(c) || c == '{' || c == '(' || c == ')' || c == ';' || c == '[';
+}
+
+static s32 parse_int(const char *text, const char *end) {
+    s32 value = 0;
+    while (text < end && *text >= '0' && *text <= '9') {
+        value = value * 10 + (*text - '0');
+        text++;
+    }
+    return value;
+}
+
+static s32 parse_result(const char *text, s64 size) {
+    if (size == 3 && memcmp(text, "1-0", 3) == 0)      return RESULT_WHITE_WIN;
+    if (size == 3 && memcmp(text, "0-1", 3) == 0)      return RESULT_BLACK_WIN;
+    if (size == 7 && memcmp(text, "1/2-1/2", 7) == 0)  return RESULT_DRAW;
+    return RESULT_UNKNOWN;
+}
+
+// Skips "{...}" comments, ";" line comments, "$n" glyphs and nested "(...)" variations.
+static const char *skip_annotation(const char *p, const char *end) {
+    if (*p == '{') {
+        while (p < end && *p != '}')  p++;
+        return (p < end) ? p + 1 : p;
+    }
+    if (*p == ';') {
+        while (p < end && *p != '\n')  p++;
+        return p;
+    }
+    if (*p == '$') {
+        p++;
+        while (p < end && *p >= '0' && *p <= '9')  p++;
+        return p;
+    }
+    if (*p == '(') {
+        s32 depth = 0;
+        while (p < end) {
+            if (*p == '{') {
+                p = skip_annotation(p, end);
+                continue;
+            }
+            if (*p == '(')  depth++;
+            if (*p == ')' && --depth == 0)  return p + 1;
+            p++;
+        }
+        return p;
+    }
+    return p + 1;
+}
+
+const char *pgn_parse_game(const char *text, const char *end, Pgn_Game *game, s32 max_plies) {
+    game->text = text;
+    game->text_size = 0;
+    game->tag_count = 0;
+    game->result = RESULT_UNKNOWN;
+    game->white_elo = 0;
+    game->black_elo = 0;
+    game->move_count = 0;
+    game->parse_error = false;
+    game->truncated = false;
+
+    if (max_plies > PGN_MAX_GAME_PLIES)  max_plies = PGN_MAX_GAME_PLIES;
+
+    const char *p = text;
+
+    // Tag pairs.
+    for (;;) {
+        while (p < end && is_space(*p))  p++;
+        if (p >= end || *p != '[')  break;
+
+        p++;
+        const char *name = p;
+        while (p < end && !is_space(*p) && *p != ']')  p++;
+        s64 name_size = p - name;
+
+        while (p < end && *p != '"' && *p != ']')  p++;
+        const char *value = p;
+        const char *value_end = p;
+        if (p < end && *p == '"') {
+            value = ++p;
+            while (p < end && *p != '"') {
+                if (*p == '\\' && p + 1 < end)  p++;
+                p++;
+            }
+            value_end = p;
+        }
+        while (p < end && *p != ']')  p++;
+        if (p < end)  p++;
+
+        if (game->tag_count < PGN_MAX_TAGS) {
+            Pgn_Tag *tag = &game->tags[game->tag_count++];
+            tag->name = name;
+            tag->value = value;
+            tag->name_size = (s32)name_size;
+            tag->value_size = (s32)(value_end - value);
+        }
+
+        if (name_size == 8 && memcmp(name, "WhiteElo", 8) == 0) {
+            game->white_elo = parse_int(value, value_end);
+        } else if (name_size == 8 && memcmp(name, "BlackElo", 8) == 0) {
+            game->black_elo = parse_int(value, value_end);
+        } else if (name_size == 6 && memcmp(name, "Result", 6) == 0) {
+            game->result = parse_result(value, value_end - value);
+        } else if (name_size == 3 && memcmp(name, "FEN", 3) == 0) {
+            // Games from custom start positions are not replayed.
+            game->parse_error = true;
+        }
+    }
+
+    Position pos;
+    set_start_position(&pos);
+
+    // Movetext.
+    while (p < end) {
+        char c = *p;
+        if (is_space(c)) {
+            p++;
+            continue;
+        }
+        if (c == '[') {
+            if (p > text && p[-1] == '\n')  break; // Next game without a termination marker.
+            p++;
+            continue;
+        }
+        if (c == '{' || c == ';' || c == '$' || c == '(' || c == ')') {
+            p = skip_annotation(p, end);
+            continue;
+        }
+
+        const char *token = p;
+        while (p < end && !is_token_end(*p))  p++;
+        s64 token_size = p - token;
+
+        if (c == '*') {
+            break;
+        }
+
+        if (c >= '0' && c <= '9') {
+            s32 result = parse_result(token, token_size);
+            if (result != RESULT_UNKNOWN) {
+                if (game->result == RESULT_UNKNOWN)  game->result = result;
+                break;
+            }
+            // Move number, possibly glued to the move: "12.", "12...", "12.e4".
+            while (token < p && *token >= '0' && *token <= '9')  token++;
+            while (token < p && *token == '.')  token++;
+            token_size = p - token;
+            if (token_size == 0)  continue;
+        }
+
+        if (game->parse_error)  continue;
+        if (game->move_count >= max_plies) {
+            game->truncated = true;
+            continue;
+        }
+
+        Move move = parse_san_move(&pos, token, (s32)token_size);
+        if (move == MOVE_NONE) {
+            game->parse_error = true;
+            continue;
+        }
+
+        Undo_Info undo;
+        make_move(&pos, move, &undo);
+        game->moves[game->move_count++] = move;
+    }
+
+    game->text_size = p - text;
+    return p;
+}
+
+const Pgn_Tag *pgn_find_tag(const Pgn_Game *game, const char *name) {
+    s64 name_size = (s64)strlen(name);
+    For (game->tag_count) {
+        const Pgn_Tag *tag = &game->tags[it];
+        if (tag->name_size == name_size && memcmp(tag->name, name, (size_t)name_size) == 0)  return tag;
+    }
+    return NULL;
+}
+
+//
+// --- Threaded parsing ---
+//
+static void pgn_worker_proc(void *data) {
+    ZoneScoped;
+
+    Pgn_Worker *worker = (Pgn_Worker *)data;
+    Pgn_Job *job = worker->job;
+    const Pgn_Parse_Options *options = job->options;
+
+    Pgn_Game *game = ALLOC(sys_allocator, 1, Pgn_Game);
+    defer { FREE(sys_allocator, game); };
+
+    for (;;) {
+        s64 chunk_start = job->next_chunk.fetch_add(PGN_CHUNK_SIZE);
+        if (chunk_start >= job->size)  break;
+        s64 chunk_end = chunk_start + PGN_CHUNK_SIZE;
+
+        s64 offset = pgn_next_game_start(job->text, job->size, chunk_start);
+        while (offset < chunk_end && offset < job->size) {
+            const char *next = pgn_parse_game(job->text + offset, job->text + job->size, game, options->max_plies);
+
+            worker->stats.games++;
+            worker->stats.plies += (u64)game->move_count;
+            if (game->parse_error)  worker->stats.errors++;
+            options->proc(options->data, worker->index, game);
+
+            offset = pgn_next_game_start(job->text, job->size, next - job->text);
+        }
+    }
+}
+
+bool parse_pgn_file(const char *filepath, const Pgn_Parse_Options *options, Pgn_Parse_Stats *out_stats) {
+    ZoneScoped;
+
+    *out_stats = { };
+
+    Mapped_File file;
+    if (!map_file(filepath, &file))  return false;
+    defer { unmap_file(&file); };
+
+    s32 worker_count = (options->threads > 0) ? options->threads : get_cpu_count();
+
+    Pgn_Job job;
+    job.text = file.data;
+    job.size = file.size;
+    job.options = options;
+    job.next_chunk.store(0);
+
+    Pgn_Worker *workers = ALLOC(sys_allocator, worker_count, Pgn_Worker);
+    Thread *threads = ALLOC(sys_allocator, worker_count, Thread);
+    defer { FREE(sys_allocator, workers); FREE(sys_allocator, threads); };
+
+    For (worker_count) {
+        workers[it].job = &job;
+        workers[it].index = it;
+        workers[it].stats = { };
+    }
+
+    // A single worker runs on the calling thread.
+    if (worker_count == 1) {
+        pgn_worker_proc(&workers[0]);
+    } else {
+        For (worker_count)  threads[it] = create_thread(pgn_worker_proc, &workers[it]);
+        For (worker_count)  join_thread(&threads[it]);
+    }
+
+    For (worker_count) {
+        out_stats->games += workers[it].stats.games;
+        out_stats->plies += workers[it].stats.plies;
+        out_stats->errors += workers[it].stats.errors;
+    }
+    out_stats->bytes = file.size;
+    if (out_stats->games == 0 && file.size > 0) {
+        fprintf(stderr, "WARNING: No games found in '%s', they have to start with a tag line!\n", filepath);
+    }
+    return true;
+}
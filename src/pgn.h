@@ -0,0 +1,85 @@
+#ifndef PAWN_PGN_H
+#define PAWN_PGN_H
+
+#include "position.h"
+
+//
+// --- Constants ---
+//
+const int PGN_MAX_GAME_PLIES = 1024;
+const int PGN_MAX_TAGS = 32;
+
+//
+// --- Enums ---
+//
+enum Game_Result {
+    RESULT_UNKNOWN = 0,
+    RESULT_WHITE_WIN = 1,
+    RESULT_BLACK_WIN = 2,
+    RESULT_DRAW = 3
+};
+
+//
+// --- Structs ---
+//
+// Points into the parsed text, nothing is copied. Values keep their backslash escapes.
+struct Pgn_Tag {
+    const char *name;
+    const char *value;
+    s32 name_size;
+    s32 value_size;
+};
+
+struct Pgn_Game {
+    const char *text;         // Whole game, tags included.
+    s64 text_size;
+    Pgn_Tag tags[PGN_MAX_TAGS];
+    s32 tag_count;            // Tags past PGN_MAX_TAGS are parsed but not kept.
+
+    s32 result;
+    s32 white_elo;            // 0 if the tag is missing.
+    s32 black_elo;
+    s32 move_count;
+    bool parse_error;         // Movetext had an illegal or unreadable move; 'moves' holds everything before it.
+    bool truncated;           // Movetext had more than 'max_plies' moves; 'moves' holds the first ones.
+    Move moves[PGN_MAX_GAME_PLIES];
+};
+
+// Called from worker threads; 'worker_index' is in [0, threads) and can index per-thread state.
+// 'game' and the text it points into are only valid during the call.
+typedef void (*Pgn_Game_Proc)(void *data, s32 worker_index, const Pgn_Game *game);
+
+struct Pgn_Parse_Options {
+    s32 threads;              // 0 uses every core.
+    s32 max_plies;
+    Pgn_Game_Proc proc;
+    void *data;
+};
+
+struct Pgn_Parse_Stats {
+    u64 games;
+    u64 plies;
+    u64 errors;               // Games with 'parse_error' set.
+    s64 bytes;
+};
+
+//
+// --- Functions ---
+//
+
+// Returns the offset of the first tag at or after 'offset' that starts a game, or 'size': a tag at the
+// start of a line that doesn't follow another tag line.
+s64 pgn_next_game_start(const char *text, s64 size, s64 offset);
+
+// Parses a single game starting at 'text' and returns a pointer right after it.
+// Stops replaying moves after 'max_plies'; the rest of the movetext is skipped and 'truncated' set.
+const char *pgn_parse_game(const char *text, const char *end, Pgn_Game *game, s32 max_plies = PGN_MAX_GAME_PLIES);
+
+// Returns NULL if the game has no such tag.
+const Pgn_Tag *pgn_find_tag(const Pgn_Game *game, const char *name);
+
+// Memory-maps the file and parses it in 1 MB chunks on 'options->threads' workers.
+// A chunk owns every game that starts inside it, so games are reported out of file order.
+bool parse_pgn_file(const char *filepath, const Pgn_Parse_Options *options, Pgn_Parse_Stats *out_stats);
+
+#endif /* PAWN_PGN_H */
@@ -0,0 +1,308 @@
+#include <stdio.h>
+
+#if defined(_WIN32)
+#define VC_EXTRALEAN
+#define WIN32_LEAN_AND_MEAN
+#define NOGDI
+#include <Windows.h>
+#undef max
+#undef min
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include "platform.h"
+
+struct Thread_Start_Info {
+    Thread_Proc proc;
+    void *data;
+};
+
+#if defined(_WIN32)
+
+static DWORD WINAPI thread_entry(LPVOID parameter) {
+    Thread_Start_Info *info = (Thread_Start_Info *)parameter;
+    info->proc(info->data);
+    return 0;
+}
+
+Thread create_thread(Thread_Proc proc, void *data) {
+    Thread thread = { };
+    Thread_Start_Info *info = ALLOC(sys_allocator, 1, Thread_Start_Info);
+    info->proc = proc;
+    info->data = data;
+    thread.start_info = info;
+    thread.handle = CreateThread(NULL, 0, thread_entry, info, 0, NULL);
+    assert(thread.handle != NULL && "Failed to create thread.");
+    return thread;
+}
+
+void join_thread(Thread *thread) {
+    if (!thread->handle)  return;
+    WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+    CloseHandle((HANDLE)thread->handle);
+    FREE(sys_allocator, thread->start_info);
+    thread->handle = NULL;
+    thread->start_info = NULL;
+}
+
+s32 get_cpu_count() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (s32)info.dwNumberOfProcessors;
+}
+
+u64 get_time_microseconds() {
+    static LARGE_INTEGER frequency = { };
+    if (frequency.QuadPart == 0)  QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (u64)(counter.QuadPart / frequency.QuadPart) * 1000000ULL
+         + (u64)(counter.QuadPart % frequency.QuadPart) * 1000000ULL / (u64)frequency.QuadPart;
+}
+
+void sleep_milliseconds(u32 milliseconds) {
+    Sleep(milliseconds);
+}
+
+bool get_file_size(const char *filepath, s64 *out_size) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(filepath, GetFileExInfoStandard, &data))  return false;
+    *out_size = ((s64)data.nFileSizeHigh << 32) | (s64)data.nFileSizeLow;
+    return true;
+}
+
+bool delete_file(const char *filepath) {
+    return DeleteFileA(filepath) != 0;
+}
+
+bool replace_file(const char *from, const char *to) {
+    return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+}
+
+bool get_executable_path(char *buffer, s32 buffer_size) {
+    DWORD size = GetModuleFileNameA(NULL, buffer, (DWORD)buffer_size);
+    return size > 0 && size < (DWORD)buffer_size;
+}
+
+bool map_file(const char *filepath, Mapped_File *out_file, bool copy_on_write) {
+    *out_file = { };
+
+    // Files written in place are tables probed at random, the rest are read front to back.
+    DWORD access_hint = copy_on_write ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE file = CreateFileA(filepath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, access_hint, NULL);
+    if (file == INVALID_HANDLE_VALUE) {
+        fprintf(stderr, "ERROR: Couldn't open '%s' file!\n", filepath);
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size)) {
+        fprintf(stderr, "ERROR: Couldn't get size of '%s' file!\n", filepath);
+        CloseHandle(file);
+        return false;
+    }
+
+    out_file->file_handle = file;
+    out_file->size = (s64)size.QuadPart;
+    if (out_file->size == 0)  return true; // Empty files can't be mapped.
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, NULL);
+    void *data = mapping ? MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!data) {
+        fprintf(stderr, "ERROR: Couldn't map '%s' file!\n", filepath);
+        if (mapping)  CloseHandle(mapping);
+        CloseHandle(file);
+        *out_file = { };
+        return false;
+    }
+
+    out_file->mapping_handle = mapping;
+    out_file->data = (const char *)data;
+    return true;
+}
+
+void unmap_file(Mapped_File *file) {
+    if (file->data)            UnmapViewOfFile(file->data);
+    if (file->mapping_handle)  CloseHandle((HANDLE)file->mapping_handle);
+    if (file->file_handle)     CloseHandle((HANDLE)file->file_handle);
+    *file = { };
+}
+
+#else
+
+static void *thread_entry(void *parameter) {
+    Thread_Start_Info *info = (Thread_Start_Info *)parameter;
+    info->proc(info->data);
+    return NULL;
+}
+
+Thread create_thread(Thread_Proc proc, void *data) {
+    Thread thread = { };
+    Thread_Start_Info *info = ALLOC(sys_allocator, 1, Thread_Start_Info);
+    info->proc = proc;
+    info->data = data;
+    thread.start_info = info;
+
+    pthread_t *handle = ALLOC(sys_allocator, 1, pthread_t);
+    int error = pthread_create(handle, NULL, thread_entry, info);
+    assert(error == 0 && "Failed to create thread.");
+    thread.handle = handle;
+    return thread;
+}
+
+void join_thread(Thread *thread) {
+    if (!thread->handle)  return;
+    pthread_join(*(pthread_t *)thread->handle, NULL);
+    FREE(sys_allocator, thread->handle);
+    FREE(sys_allocator, thread->start_info);
+    thread->handle = NULL;
+    thread->start_info = NULL;
+}
+
+s32 get_cpu_count() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return (count > 0) ? (s32)count : 1;
+}
+
+u64 get_time_microseconds() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (u64)now.tv_sec * 1000000ULL + (u64)now.tv_nsec / 1000ULL;
+}
+
+void sleep_milliseconds(u32 milliseconds) {
+    usleep(milliseconds * 1000);
+}
+
+bool get_file_size(const char *filepath, s64 *out_size) {
+    struct stat info;
+    if (stat(filepath, &info) != 0)  return false;
+    *out_size = (s64)info.st_size;
+    return true;
+}
+
+bool delete_file(const char *filepath) {
+    return unlink(filepath) == 0;
+}
+
+bool replace_file(const char *from, const char *to) {
+    return rename(from, to) == 0;
+}
+
+bool get_executable_path(char *buffer, s32 buffer_size) {
+    ssize_t size = readlink("/proc/self/exe", buffer, (size_t)buffer_size - 1);
+    if (size <= 0)  return false;
+    buffer[size] = '\0';
+    return true;
+}
+
+bool map_file(const char *filepath, Mapped_File *out_file, bool copy_on_write) {
+    *out_file = { };
+
+    int file = open(filepath, O_RDONLY);
+    if (file < 0) {
+        fprintf(stderr, "ERROR: Couldn't open '%s' file!\n", filepath);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(file, &info) != 0) {
+        fprintf(stderr, "ERROR: Couldn't get size of '%s' file!\n", filepath);
+        close(file);
+        return false;
+    }
+
+    out_file->size = (s64)info.st_size;
+    if (out_file->size > 0) {
+        void *data = mmap(NULL, (size_t)out_file->size, copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, file, 0);
+        if (data == MAP_FAILED) {
+            fprintf(stderr, "ERROR: Couldn't map '%s' file!\n", filepath);
+            close(file);
+            *out_file = { };
+            return false;
+        }
+        madvise(data, (size_t)out_file->size, copy_on_write ? MADV_RANDOM : MADV_SEQUENTIAL);
+        out_file->data = (const char *)data;
+    }
+
+    // The mapping stays valid after the descriptor is closed.
+    close(file);
+    return true;
+}
+
+void unmap_file(Mapped_File *file) {
+    if (file->data)  munmap((void *)file->data, (size_t)file->size);
+    *file = { };
+}
+
+#endif
+
+//
+// --- Worker pool ---
+//
+bool create_worker_pool(Worker_Pool *pool, s32 count, s64 worker_size, Worker_Setup_Proc setup_proc, Worker_Cleanup_Proc cleanup_proc, void *data) {
+    *pool = { };
+    pool->workers = ALLOC(sys_allocator, count * worker_size, u8);
+    pool->worker_size = worker_size;
+    pool->count = count;
+    pool->threads = ALLOC(sys_allocator, count, Thread);
+    pool->cleanup_proc = cleanup_proc;
+    mem_zero(pool->workers, count * worker_size);
+    mem_zero(pool->threads, count * sizeof(Thread));
+
+    For (count) {
+        // Counted before the setup, so a half set up worker is cleaned up too.
+        pool->setup_count++;
+        if (!setup_proc(get_worker(pool, it), it, data)) {
+            destroy_worker_pool(pool);
+            return false;
+        }
+    }
+    return true;
+}
+
+void destroy_worker_pool(Worker_Pool *pool) {
+    join_worker_threads(pool);
+    if (pool->cleanup_proc) {
+        For (pool->setup_count)  pool->cleanup_proc(get_worker(pool, it));
+    }
+    FREE(sys_allocator, pool->workers);
+    FREE(sys_allocator, pool->threads);
+    *pool = { };
+}
+
+void start_worker_threads(Worker_Pool *pool, Thread_Proc proc, s32 first, s32 count) {
+    assert(first >= 0 && first + count <= pool->count);
+    ForFrom (first + count, first)  pool->threads[it] = create_thread(proc, get_worker(pool, it));
+}
+
+void join_worker_threads(Worker_Pool *pool) {
+    // join_thread skips threads that never started.
+    For (pool->count)  join_thread(&pool->threads[it]);
+}
+
+void run_worker_pool(Worker_Pool *pool, Thread_Proc proc) {
+    start_worker_threads(pool, proc, 0, pool->count);
+    join_worker_threads(pool);
+}
+
+//
+// --- Files ---
+//
+FILE *open_output_file(const char *filepath, const char *kind) {
+    if (!filepath)  return stdout;
+    FILE *file = fopen(filepath, "wb");
+    if (!file)  fprintf(stderr, "ERROR: Couldn't create '%s' %s file!\n", filepath, kind);
+    return file;
+}
+
+void close_output_file(FILE *file) {
+    if (file && file != stdout)  fclose(file);
+}
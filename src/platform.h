@@ -0,0 +1,75 @@
+#ifndef PAWN_PLATFORM_H
+#define PAWN_PLATFORM_H
+
+#include <stdio.h>
+
+#include "common.h"
+
+//
+// --- Types ---
+//
+typedef void (*Thread_Proc)(void *data);
+// Sets up the zeroed 'worker' before any thread starts. On failure it may leave the worker half set up.
+typedef bool (*Worker_Setup_Proc)(void *worker, s32 index, void *data);
+// Frees what a setup allocated, so it has to take the fields a failed setup left zeroed.
+typedef void (*Worker_Cleanup_Proc)(void *worker);
+
+//
+// --- Structs ---
+//
+struct Thread {
+    void *handle;
+    void *start_info; // Heap copy of proc + data, freed on join.
+};
+
+// Workers of one parallel job, each with its own thread, set up and cleaned up in one place.
+struct Worker_Pool {
+    u8 *workers;                        // 'count' items of 'worker_size' bytes.
+    s64 worker_size;
+    s32 count;
+    s32 setup_count;                    // Workers the setup got to, the only ones cleaned up.
+    Thread *threads;
+    Worker_Cleanup_Proc cleanup_proc;
+};
+
+// View of a whole file, read-only unless mapped copy-on-write. 'data' is not NUL-terminated.
+struct Mapped_File {
+    const char *data;
+    s64 size;
+    void *file_handle;
+    void *mapping_handle;
+};
+
+//
+// --- Functions ---
+//
+Thread create_thread(Thread_Proc proc, void *data);
+void join_thread(Thread *thread);
+// Allocates 'count' zeroed workers and sets them up in order. If one fails the pool is destroyed and false returned.
+bool create_worker_pool(Worker_Pool *pool, s32 count, s64 worker_size, Worker_Setup_Proc setup_proc, Worker_Cleanup_Proc cleanup_proc, void *data = NULL);
+void destroy_worker_pool(Worker_Pool *pool);
+// Runs 'proc' on workers 'first' to 'first + count - 1', one thread each, without waiting for them.
+void start_worker_threads(Worker_Pool *pool, Thread_Proc proc, s32 first, s32 count);
+void join_worker_threads(Worker_Pool *pool);
+// Runs 'proc' on every worker and waits for all of them.
+void run_worker_pool(Worker_Pool *pool, Thread_Proc proc);
+inline void *get_worker(Worker_Pool *pool, s32 index) { return pool->workers + index * pool->worker_size; }
+s32 get_cpu_count();
+
+u64 get_time_microseconds(); // Monotonic, high resolution.
+void sleep_milliseconds(u32 milliseconds);
+
+bool get_file_size(const char *filepath, s64 *out_size);
+bool delete_file(const char *filepath);
+// Renames 'from' to 'to' in one step, replacing 'to' if it exists. Fails while 'to' is mapped on Windows.
+bool replace_file(const char *from, const char *to);
+bool get_executable_path(char *buffer, s32 buffer_size);
+// Opens a file to write a report to, or stdout without a path. 'kind' names the file in the error message.
+FILE *open_output_file(const char *filepath, const char *kind);
+void close_output_file(FILE *file);
+
+// With 'copy_on_write' the view can be written to; changed pages become private copies and the file stays as it is.
+bool map_file(const char *filepath, Mapped_File *out_file, bool copy_on_write = false);
+void unmap_file(Mapped_File *file);
+
+#endif /* PAWN_PLATFORM_H */
@@ -0,0 +1,155 @@
+#ifndef PAWN_POSITION_H
+#define PAWN_POSITION_H
+
+#include "common.h"
+#include "bitboard.h"
+
+//
+// --- Enums ---
+//
+enum Piece_Kind {
+    EMPTY = 0,
+    KING = 1,
+    QUEEN = 2,
+    ROOK = 3,
+    BISHOP = 4,
+    KNIGHT = 5,
+    PAWN = 6
+};
+
+enum Castling_Flag {
+    CASTLE_WHITE_KING = (1 << 0),
+    CASTLE_WHITE_QUEEN = (1 << 1),
+    CASTLE_BLACK_KING = (1 << 2),
+    CASTLE_BLACK_QUEEN = (1 << 3),
+    CASTLE_ALL = CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN | CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN
+};
+
+// Upper 4 bits of a 'Move'.
+enum Move_Flag {
+    MOVE_QUIET = 0,
+    MOVE_DOUBLE_PUSH = 1,
+    MOVE_KING_CASTLE = 2,
+    MOVE_QUEEN_CASTLE = 3,
+    MOVE_CAPTURE = 4,
+    MOVE_EP_CAPTURE = 5,
+    MOVE_PROMOTION = 8,                 // + 0..3 for knight, bishop, rook, queen.
+    MOVE_PROMOTION_CAPTURE = 12         // + 0..3 for knight, bishop, rook, queen.
+};
+
+//
+// --- Types ---
+//
+
+// A move packed into 16 bits: from (bits 0-5), to (bits 6-11), Move_Flag (bits 12-15).
+// Castling is encoded as the king's two-square move (e1g1).
+typedef u16 Move;
+
+// Colored piece: (color << 3) | Piece_Kind. Zero means no piece.
+typedef u8 Piece_Code;
+
+//
+// --- Constants ---
+//
+const Move MOVE_NONE = 0;
+const Piece_Code NO_PIECE = 0;
+const int ZOBRIST_RANDOM_COUNT = 781;
+const int FIFTY_MOVE_PLY = 100;     // Also as far back as a repetition can be.
+
+//
+// --- Structs ---
+//
+struct Position {
+    Bitboard pieces[7];       // Indexed by Piece_Kind, [EMPTY] is unused.
+    Bitboard colors[2];
+    Piece_Code board[SQUARE_COUNT];
+    s32 side_to_move;
+    u8 castling;              // Castling_Flag bits.
+    u8 ep_square;             // Only set when a pawn of the side to move can capture there, NO_SQUARE otherwise.
+    u16 halfmove_clock;
+    u16 fullmove_number;
+    u64 key;                  // Zobrist key, laid out the same way as Polyglot keys.
+};
+
+// Everything 'make_move()' destroys and 'unmake_move()' needs back.
+struct Undo_Info {
+    u64 key;
+    Piece_Code captured;
+    u8 castling;
+    u8 ep_square;
+    u16 halfmove_clock;
+};
+
+//
+// --- Globals ---
+//
+extern u64 zobrist_random[ZOBRIST_RANDOM_COUNT];
+extern u64 zobrist_piece[16][SQUARE_COUNT];
+extern u64 zobrist_castling[16];
+extern u64 zobrist_ep_file[8];
+extern u64 zobrist_white_to_move;
+
+//
+// --- Functions ---
+//
+void init_chess();
+bool load_zobrist_keys(const char *filepath);
+
+inline Piece_Code make_piece(s32 color, s32 kind) { return (Piece_Code)((color << 3) | kind); }
+inline s32 piece_color(Piece_Code piece)          { return piece >> 3; }
+inline s32 piece_kind(Piece_Code piece)           { return piece & 7; }
+
+inline Move new_move(s32 from, s32 to, s32 flags = MOVE_QUIET) { return (Move)(from | (to << 6) | (flags << 12)); }
+inline s32 move_from(Move move)            { return move & 63; }
+inline s32 move_to(Move move)              { return (move >> 6) & 63; }
+inline s32 move_flags(Move move)           { return move >> 12; }
+inline bool is_capture(Move move)          { return (move_flags(move) & MOVE_CAPTURE) != 0; }
+inline bool is_promotion(Move move)        { return (move_flags(move) & MOVE_PROMOTION) != 0; }
+inline bool is_castling(Move move)         { return move_flags(move) == MOVE_KING_CASTLE || move_flags(move) == MOVE_QUEEN_CASTLE; }
+inline s32 promotion_kind(Move move)       { return KNIGHT - (move_flags(move) & 3); } // KNIGHT, BISHOP, ROOK, QUEEN
+
+inline Bitboard occupied(const Position *pos)                        { return pos->colors[WHITE] | pos->colors[BLACK]; }
+inline Bitboard pieces_of(const Position *pos, s32 color, s32 kind)  { return pos->pieces[kind] & pos->colors[color]; }
+inline s32 king_square(const Position *pos, s32 color)              { return lsb(pieces_of(pos, color, KING)); }
+
+void clear_position(Position *pos);
+void set_start_position(Position *pos);
+void put_piece(Position *pos, Piece_Code piece, s32 square);
+u64 compute_key(const Position *pos);
+void update_ep_square(Position *pos, s32 ep_square);
+
+// One king per side, at most 16 pieces and 8 pawns per side, no pawns on the back ranks,
+// the side that just moved not in check and no more than two checkers.
+bool is_valid_position(const Position *pos);
+
+Bitboard attackers_to(const Position *pos, s32 square, Bitboard occupancy);
+bool is_square_attacked(const Position *pos, s32 square, s32 by_color);
+Bitboard checkers(const Position *pos);
+inline bool in_check(const Position *pos) { return is_square_attacked(pos, king_square(pos, pos->side_to_move), pos->side_to_move ^ 1); }
+
+void make_move(Position *pos, Move move, Undo_Info *undo);
+// The key 'make_move()' would give the position, without making the move, so the search can start
+// loading the child's table entry early.
+u64 key_after(const Position *pos, Move move);
+void unmake_move(Position *pos, Move move, const Undo_Info *undo);
+void make_null_move(Position *pos, Undo_Info *undo);
+void unmake_null_move(Position *pos, const Undo_Info *undo);
+
+// Plies back to the last time 'key' occurred in 'keys', the keys of the positions that led to it, oldest
+// first. Looks at every second position only, and not further back than 'max_distance', the plies since
+// the last capture or pawn move. 0 if it didn't occur.
+s32 find_repetition(u64 key, const u64 *keys, s32 key_count, s32 max_distance);
+
+// Whether the side to move has a move back to one of the positions in 'keys', looked up in cuckoo tables
+// of the reversible moves instead of generated. Positions among the last 'search_ply' keys only need to
+// have occurred once, older ones twice, as for a draw by repetition.
+bool has_upcoming_repetition(const Position *pos, const u64 *keys, s32 key_count, s32 search_ply);
+
+// Keys as for 'find_repetition()'. The position occurred twice before.
+bool is_threefold_repetition(const Position *pos, const u64 *keys, s32 key_count);
+// Only the material that can never mate: bare kings and a single minor piece.
+bool is_insufficient_material(const Position *pos);
+
+void print_position(const Position *pos);
+
+#endif /* PAWN_POSITION_H */
@@ -0,0 +1,443 @@
+// fopen()
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include <stdio.h>
+#include <string.h>
+
+#include <atomic>
+
+#include "puzzle.h"
+#include "fen.h"
+#include "mate.h"
+#include "movegen.h"
+#include "mpmc.h"
+#include "notation.h"
+#include "pgn.h"
+#include "platform.h"
+#include "search.h"
+
+//
+// --- Constants ---
+//
+
+// The best move has to reach the first score and the second best stay under the other one. The filter
+// searches shallower and lets through what comes within its margin of both.
+const s32 PUZZLE_WIN_SCORE = 300;
+const s32 PUZZLE_UNCLEAR_SCORE = 100;
+const s32 PUZZLE_FILTER_MARGIN = 50;
+
+const int PUZZLE_MAX_THREADS = 256;
+const int PUZZLE_SEARCH_LINE_PLIES = 7;   // Of the search line written for a puzzle that isn't a mate.
+const int PUZZLE_MAX_LINE_PLIES = 63;     // Of a mate line.
+const s64 PUZZLE_KEY_SET_MIN_CAPACITY = 1 << 16;
+
+// The parse queue is the deepest, so a game's positions fit while the filter works on the last one.
+const u32 PUZZLE_POSITION_QUEUE_SIZE = 1024;
+const u32 PUZZLE_CANDIDATE_QUEUE_SIZE = 64;
+const u32 PUZZLE_RECORD_QUEUE_SIZE = 64;
+
+const u32 PUZZLE_IDLE_SLEEP = 1;          // Milliseconds a stage waits on a full or empty queue.
+const u64 PUZZLE_PROGRESS_INTERVAL = 250000;
+
+//
+// --- Structs ---
+//
+
+// Between the parser and the filter, and the filter and the verification.
+struct Puzzle_Position {
+    Position pos;
+    Move previous;                // Move that led here, MOVE_NONE at the start.
+    s32 game;                     // 1-based, in file order.
+    s32 ply;
+};
+
+struct Puzzle_Record {
+    Position pos;
+    s32 game;
+    s32 ply;
+    s32 score;                    // Of the best move, for the side to move.
+    s32 mate;                     // Moves, 0 unless the solver proved it.
+    s32 line_length;
+    Move line[PUZZLE_MAX_LINE_PLIES];
+};
+
+// Zobrist keys seen so far, open addressing with 0 for a free slot. Only the parser touches it.
+struct Key_Set {
+    u64 *keys;
+    s64 capacity;                 // Power of two.
+    s64 count;
+};
+
+struct Puzzle_Pipeline {
+    const Puzzle_Options *options;
+    Mapped_File pgn;
+    s32 filter_count;             // Workers before it filter, the ones after it verify.
+
+    Mpmc_Queue<Puzzle_Position, PUZZLE_POSITION_QUEUE_SIZE> positions;
+    Mpmc_Queue<Puzzle_Position, PUZZLE_CANDIDATE_QUEUE_SIZE> candidates;
+    Mpmc_Queue<Puzzle_Record, PUZZLE_RECORD_QUEUE_SIZE> records;
+
+    // Threads of each stage still running. A stage is done once the one before it has stopped and its
+    // queue is empty.
+    std::atomic<s32> parsers_running;
+    std::atomic<s32> filters_running;
+    std::atomic<s32> verifiers_running;
+
+    std::atomic<u64> games;
+    std::atomic<u64> positions_seen;
+    std::atomic<u64> duplicates;
+    std::atomic<u64> filtered;
+    std::atomic<u64> verified;
+};
+
+struct Puzzle_Worker {
+    Puzzle_Pipeline *pipeline;
+    Transposition_Table tt;
+    Searcher *searcher;
+    Mate_Solver *solver;          // Verify workers only.
+};
+
+//
+// --- Helpers ---
+//
+static void init_key_set(Key_Set *set, s64 capacity) {
+    set->keys = ALLOC(sys_allocator, capacity, u64);
+    mem_zero(set->keys, capacity * sizeof(u64));
+    set->capacity = capacity;
+    set->count = 0;
+}
+
+static u64 *key_set_find_slot(Key_Set *set, u64 key) {
+    u64 mask = (u64)set->capacity - 1;
+    u64 index = (key * 0xFF51AFD7ED558CCDULL >> 16) & mask;
+    for (;;) {
+        u64 *slot = &set->keys[index];
+        if (*slot == 0 || *slot == key)  return slot;
+        index = (index + 1) & mask;
+    }
+}
+
+// False if the key was in the set already.
+static bool key_set_insert(Key_Set *set, u64 key) {
+    if (key == 0)  return true;
+    if ((set->count + 1) * 10 > set->capacity * 7) {
+        Key_Set grown;
+        init_key_set(&grown, set->capacity * 2);
+        for (s64 i = 0; i < set->capacity; i++) {
+            if (set->keys[i] != 0)  *key_set_find_slot(&grown, set->keys[i]) = set->keys[i];
+        }
+        grown.count = set->count;
+        FREE(sys_allocator, set->keys);
+        *set = grown;
+    }
+
+    u64 *slot = key_set_find_slot(set, key);
+    if (*slot == key)  return false;
+    *slot = key;
+    set->count++;
+    return true;
+}
+
+// Waits for room, so a slow stage holds back the one before it.
+template <typename T, u32 N>
+static void push_waiting(Mpmc_Queue<T, N> *queue, const T &item) {
+    while (!mpmc_push(queue, item))  sleep_milliseconds(PUZZLE_IDLE_SLEEP);
+}
+
+// False once the stage before has stopped and the queue is empty. The count is read before popping, so
+// nothing can be pushed after an empty queue is taken as the end.
+template <typename T, u32 N>
+static bool pop_waiting(Mpmc_Queue<T, N> *queue, T *out_item, const std::atomic<s32> *upstream_running) {
+    for (;;) {
+        bool done = upstream_running->load(std::memory_order_acquire) == 0;
+        if (mpmc_pop(queue, out_item))  return true;
+        if (done)  return false;
+        sleep_milliseconds(PUZZLE_IDLE_SLEEP);
+    }
+}
+
+static void parser_proc(void *data) {
+    ZoneScoped;
+
+    Puzzle_Pipeline *pipeline = (Puzzle_Pipeline *)data;
+    const Puzzle_Options *options = pipeline->options;
+
+    Pgn_Game *game = ALLOC(sys_allocator, 1, Pgn_Game);
+    Key_Set seen;
+    init_key_set(&seen, PUZZLE_KEY_SET_MIN_CAPACITY);
+    defer {
+        FREE(sys_allocator, game);
+        FREE(sys_allocator, seen.keys);
+    };
+
+    const char *text = pipeline->pgn.data;
+    s64 size = pipeline->pgn.size;
+    s64 offset = pgn_next_game_start(text, size, 0);
+    s32 game_index = 0;
+    while (offset < size) {
+        const char *next = pgn_parse_game(text + offset, text + size, game);
+        offset = pgn_next_game_start(text, size, next - text);
+        game_index++;
+        pipeline->games.fetch_add(1, std::memory_order_relaxed);
+
+        // After a broken move the moves before it still make a game.
+        Puzzle_Position item;
+        set_start_position(&item.pos);
+        item.previous = MOVE_NONE;
+        item.game = game_index;
+        For (game->move_count) {
+            item.ply = it;
+            if (it >= options->min_ply) {
+                Move_List legal;
+                generate_legal_moves(&item.pos, &legal);
+                if (legal.count < 2) {
+                    // A forced move is no puzzle.
+                } else if (!key_set_insert(&seen, item.pos.key)) {
+                    pipeline->duplicates.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    push_waiting(&pipeline->positions, item);
+                }
+            }
+
+            Undo_Info undo;
+            make_move(&item.pos, game->moves[it], &undo);
+            item.previous = game->moves[it];
+        }
+    }
+
+    pipeline->parsers_running.fetch_sub(1, std::memory_order_release);
+}
+
+// Two best root lines of the position, false if it has fewer.
+static bool search_two_lines(Puzzle_Worker *worker, const Position *pos, const Search_Limits *limits, s32 *out_best, s32 *out_second) {
+    // Without the game's earlier keys: the puzzle is the position alone, whatever repeated before it.
+    search_position(worker->searcher, pos, limits);
+    if (worker->searcher->line_count < 2)  return false;
+    *out_best = worker->searcher->lines[0].score;
+    *out_second = worker->searcher->lines[1].score;
+    return true;
+}
+
+static bool setup_puzzle_worker(void *data, s32 index, void *pipeline_data) {
+    Puzzle_Worker *worker = (Puzzle_Worker *)data;
+    Puzzle_Pipeline *pipeline = (Puzzle_Pipeline *)pipeline_data;
+    worker->pipeline = pipeline;
+    if (!tt_init(&worker->tt, pipeline->options->hash_megabytes))  return false;
+    worker->searcher = create_searcher(&worker->tt);
+    if (index >= pipeline->filter_count) {
+        worker->solver = create_mate_solver(pipeline->options->hash_megabytes);
+        if (!worker->solver)  return false;
+    }
+    return true;
+}
+
+static void cleanup_puzzle_worker(void *data) {
+    Puzzle_Worker *worker = (Puzzle_Worker *)data;
+    if (worker->solver)  destroy_mate_solver(worker->solver);
+    destroy_searcher(worker->searcher);
+    tt_free(&worker->tt);
+}
+
+static void filter_proc(void *data) {
+    ZoneScoped;
+
+    Puzzle_Worker *worker = (Puzzle_Worker *)data;
+    Puzzle_Pipeline *pipeline = worker->pipeline;
+
+    Search_Limits limits = { };
+    limits.depth = pipeline->options->filter_depth;
+    limits.multi_pv = 2;
+
+    Puzzle_Position item;
+    while (pop_waiting(&pipeline->positions, &item, &pipeline->parsers_running)) {
+        pipeline->positions_seen.fetch_add(1, std::memory_order_relaxed);
+        s32 best, second;
+        if (!search_two_lines(worker, &item.pos, &limits, &best, &second))  continue;
+        if (best < PUZZLE_WIN_SCORE - PUZZLE_FILTER_MARGIN || second > PUZZLE_UNCLEAR_SCORE + PUZZLE_FILTER_MARGIN)  continue;
+
+        // Taking back the piece just captured is too easy to be a puzzle.
+        Move move = worker->searcher->lines[0].pv[0];
+        if (item.previous != MOVE_NONE && is_capture(item.previous) && is_capture(move) && move_to(move) == move_to(item.previous))  continue;
+
+        pipeline->filtered.fetch_add(1, std::memory_order_relaxed);
+        push_waiting(&pipeline->candidates, item);
+    }
+
+    pipeline->filters_running.fetch_sub(1, std::memory_order_release);
+}
+
+static void verify_proc(void *data) {
+    ZoneScoped;
+
+    Puzzle_Worker *worker = (Puzzle_Worker *)data;
+    Puzzle_Pipeline *pipeline = worker->pipeline;
+    const Puzzle_Options *options = pipeline->options;
+
+    Search_Limits limits = { };
+    limits.depth = options->depth;
+    limits.movetime = options->movetime;
+    limits.multi_pv = 2;
+
+    Puzzle_Position item;
+    while (pop_waiting(&pipeline->candidates, &item, &pipeline->filters_running)) {
+        pipeline->verified.fetch_add(1, std::memory_order_relaxed);
+        s32 best, second;
+        if (!search_two_lines(worker, &item.pos, &limits, &best, &second))  continue;
+        if (best < PUZZLE_WIN_SCORE || second > PUZZLE_UNCLEAR_SCORE)  continue;
+
+        const Search_Line *line = &worker->searcher->lines[0];
+        Puzzle_Record record;
+        record.pos = item.pos;
+        record.game = item.game;
+        record.ply = item.ply;
+        record.score = best;
+        record.mate = 0;
+
+        if (is_mate_score(best)) {
+            // The search only says it mates; a puzzle needs the mate proven and the solver's first move
+            // to be the one the search found, or there would be two.
+            Mate_Limits mate_limits = { };
+            mate_limits.moves = (mate_in_moves(best) < MATE_MAX_MOVES) ? mate_in_moves(best) : MATE_MAX_MOVES;
+            mate_limits.nodes = options->mate_nodes;
+            Mate_Result mate;
+            clear_mate_solver(worker->solver);
+            solve_mate(worker->solver, &item.pos, &mate_limits, &mate);
+            if (!mate.proven || mate.pv_length == 0 || mate.pv[0] != line->pv[0])  continue;
+
+            record.mate = mate.moves;
+            record.line_length = (mate.pv_length < PUZZLE_MAX_LINE_PLIES) ? mate.pv_length : PUZZLE_MAX_LINE_PLIES;
+            For (record.line_length)  record.line[it] = mate.pv[it];
+        } else {
+            // Ending on a move of the side solving it.
+            s32 length = (line->pv_length < PUZZLE_SEARCH_LINE_PLIES) ? line->pv_length : PUZZLE_SEARCH_LINE_PLIES;
+            if (length % 2 == 0)  length--;
+            record.line_length = length;
+            For (length)  record.line[it] = line->pv[it];
+        }
+        push_waiting(&pipeline->records, record);
+    }
+
+    pipeline->verifiers_running.fetch_sub(1, std::memory_order_release);
+}
+
+static bool write_puzzle(FILE *file, const Puzzle_Record *record) {
+    char id[32];
+    char comment[32];
+    s32 id_size = snprintf(id, sizeof(id), "%d:%d", record->game, record->ply);
+    s32 comment_size;
+    if (record->mate > 0)  comment_size = snprintf(comment, sizeof(comment), "mate in %d", record->mate);
+    else                   comment_size = snprintf(comment, sizeof(comment), "%+.2f", (double)record->score / 100.0);
+
+    Epd_Record epd = { };
+    epd.position = record->pos;
+    epd.best_moves[0] = record->line[0];
+    epd.best_move_count = 1;
+    epd.id = id;
+    epd.id_size = id_size;
+    epd.comment = comment;
+    epd.comment_size = comment_size;
+
+    char text[FEN_MAX_SIZE + 256];
+    if (epd_record_to_string(&epd, text, sizeof(text)) < 0)  return false;
+    char line[PUZZLE_MAX_LINE_PLIES * MOVE_TEXT_SIZE];
+    moves_to_san(&record->pos, record->line, record->line_length, line);
+
+    if (record->mate > 0)  fprintf(file, "%s dm %d; pv %s;\n", text, record->mate, line);
+    else                   fprintf(file, "%s pv %s;\n", text, line);
+    return true;
+}
+
+static void print_progress(const Puzzle_Pipeline *pipeline, u64 puzzles) {
+    fprintf(stderr, "\r%llu games, %llu positions, %llu candidates, %llu verified, %llu puzzles",
+            (unsigned long long)pipeline->games.load(), (unsigned long long)pipeline->positions_seen.load(),
+            (unsigned long long)pipeline->filtered.load(), (unsigned long long)pipeline->verified.load(), (unsigned long long)puzzles);
+}
+
+//
+// --- Interface ---
+//
+bool extract_puzzles(const Puzzle_Options *options, Puzzle_Stats *out_stats) {
+    ZoneScoped;
+
+    s32 thread_count = (options->threads > 0) ? options->threads : get_cpu_count();
+    if (thread_count > PUZZLE_MAX_THREADS)  thread_count = PUZZLE_MAX_THREADS;
+    // The filter is a fraction of the work of the verification, but it must never starve it.
+    s32 filter_count = (thread_count >= 4) ? thread_count / 4 : 1;
+    s32 verify_count = (thread_count - filter_count > 0) ? thread_count - filter_count : 1;
+
+    Puzzle_Pipeline *pipeline = ALLOC(sys_allocator, 1, Puzzle_Pipeline);
+    defer { FREE(sys_allocator, pipeline); };
+
+    if (!map_file(options->pgn_filepath, &pipeline->pgn))  return false;
+    defer { unmap_file(&pipeline->pgn); };
+
+    FILE *file = open_output_file(options->output_filepath, "puzzle");
+    if (!file)  return false;
+    defer { close_output_file(file); };
+
+    pipeline->options = options;
+    pipeline->filter_count = filter_count;
+    mpmc_init(&pipeline->positions);
+    mpmc_init(&pipeline->candidates);
+    mpmc_init(&pipeline->records);
+    pipeline->parsers_running.store(1);
+    pipeline->filters_running.store(filter_count);
+    pipeline->verifiers_running.store(verify_count);
+    pipeline->games.store(0);
+    pipeline->positions_seen.store(0);
+    pipeline->duplicates.store(0);
+    pipeline->filtered.store(0);
+    pipeline->verified.store(0);
+
+    Worker_Pool pool;
+    if (!create_worker_pool(&pool, filter_count + verify_count, sizeof(Puzzle_Worker), setup_puzzle_worker, cleanup_puzzle_worker, pipeline))  return false;
+    defer { destroy_worker_pool(&pool); };
+
+    u64 start_time = get_time_microseconds();
+    Thread parser = create_thread(parser_proc, pipeline);
+    start_worker_threads(&pool, filter_proc, 0, filter_count);
+    start_worker_threads(&pool, verify_proc, filter_count, verify_count);
+
+    // The writer runs here, so the file is only touched by one thread.
+    Puzzle_Stats stats = { };
+    u64 last_progress = 0;
+    for (;;) {
+        bool done = pipeline->verifiers_running.load(std::memory_order_acquire) == 0;
+        Puzzle_Record record;
+        if (mpmc_pop(&pipeline->records, &record)) {
+            if (!write_puzzle(file, &record))  continue;
+            stats.puzzles++;
+            if (record.mate > 0)  stats.mates++;
+            fflush(file);
+            continue;
+        }
+        if (done)  break;
+
+        u64 now = get_time_microseconds();
+        if (now - last_progress >= PUZZLE_PROGRESS_INTERVAL) {
+            print_progress(pipeline, stats.puzzles);
+            last_progress = now;
+        }
+        sleep_milliseconds(PUZZLE_IDLE_SLEEP);
+    }
+
+    join_thread(&parser);
+    join_worker_threads(&pool);
+    print_progress(pipeline, stats.puzzles);
+    fprintf(stderr, "\n");
+
+    stats.games = pipeline->games.load();
+    stats.positions = pipeline->positions_seen.load();
+    stats.duplicates = pipeline->duplicates.load();
+    stats.candidates = pipeline->filtered.load();
+    stats.time = get_time_microseconds() - start_time;
+    if (stats.games == 0 && pipeline->pgn.size > 0) {
+        fprintf(stderr, "WARNING: No games found in '%s', they have to start with a tag line!\n", options->pgn_filepath);
+    }
+    fprintf(stderr, "%llu puzzles (%llu mates) from %llu games, %llu duplicate positions skipped, %.3f s\n",
+            (unsigned long long)stats.puzzles, (unsigned long long)stats.mates, (unsigned long long)stats.games,
+            (unsigned long long)stats.duplicates, (double)stats.time / 1000000.0);
+
+    if (out_stats)  *out_stats = stats;
+    return true;
+}
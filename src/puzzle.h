@@ -0,0 +1,53 @@
+#ifndef PAWN_PUZZLE_H
+#define PAWN_PUZZLE_H
+
+#include "common.h"
+
+//
+// --- Constants ---
+//
+const s32 PUZZLE_DEFAULT_FILTER_DEPTH = 8;
+const s32 PUZZLE_DEFAULT_DEPTH = 14;
+const s32 PUZZLE_DEFAULT_MIN_PLY = 10;
+const u64 PUZZLE_DEFAULT_MATE_NODES = 2000000;
+const s64 PUZZLE_DEFAULT_HASH = 32;
+
+//
+// --- Structs ---
+//
+struct Puzzle_Options {
+    const char *pgn_filepath;
+    const char *output_filepath;  // NULL writes the puzzles to stdout.
+    s32 filter_depth;             // Of the quick search every new position gets.
+    s32 depth;                    // Of the search that verifies a candidate, or 0.
+    s64 movetime;                 // Milliseconds for verifying a candidate, or 0.
+    s32 min_ply;                  // Positions before this ply of a game aren't looked at.
+    u64 mate_nodes;               // Mate solver limit per candidate with a mate score.
+    s32 threads;                  // Filter and verify workers together. 0 uses every core.
+    s64 hash_megabytes;           // Per searcher and per mate solver.
+};
+
+struct Puzzle_Stats {
+    u64 games;
+    u64 positions;                // Looked at by the filter.
+    u64 duplicates;               // Skipped, the same position came up before.
+    u64 candidates;               // Passed the filter.
+    u64 puzzles;                  // Passed the verification and were written.
+    u64 mates;                    // Puzzles whose mate the solver proved.
+    u64 time;                     // Microseconds.
+};
+
+//
+// --- Functions ---
+//
+
+// Streams the games of the PGN file through three stages joined by bounded queues: a parser thread
+// replays them and drops the early and the repeated positions, filter workers run a quick two-line
+// search on each and keep those where only the best move is decisive, and verify workers search the
+// candidates again deeper and have the mate solver prove the mates. A puzzle is a position where the
+// best move wins by at least three pawns or mates and the second best keeps at most a one pawn edge.
+// Puzzles are written as EPD lines with "bm", the solution line as "pv", "dm" for mates and the game and
+// ply as "id", so 'pawn epd' and 'pawn mate' read them back.
+bool extract_puzzles(const Puzzle_Options *options, Puzzle_Stats *out_stats = NULL);
+
+#endif /* PAWN_PUZZLE_H */
@@ -561,6 +561,9 @@ void renderer_draw(u32 game_state) {
     io->frametime_delta = 1000.0f * (io->frametime - io->frametime_last);
     io->frametime_last = io->frametime;
 
+    // Single-core mode: the search gets a fixed slice of every frame, the rest is ours.
+    advance_sliced_analysis();
+
     // Don't draw if window is minimized;
     if (io->window_size == new_vec2f(0)) {
         // glfwSwapBuffers(io->window);
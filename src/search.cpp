@@ -0,0 +1,1432 @@
+#include <math.h>   // log()
+#include <stdlib.h> // abs()
+#include <string.h> // strlen()
+
+#include "search.h"
+#include "eval.h"
+#include "movegen.h"
+#include "platform.h"
+
+//
+// --- Constants ---
+//
+const u64 LIMIT_CHECK_INTERVAL = 256; // Nodes between looks at the clock and the stop flag, well under a millisecond.
+const s32 ASPIRATION_WINDOW = 25;
+const s32 HISTORY_MAX = 1 << 14;
+
+const s32 ORDER_TT_MOVE = 1 << 30;
+const s32 ORDER_CAPTURE = 1 << 24;
+const s32 ORDER_KILLER = 1 << 22;
+
+// Selective search. Depths in plies, margins in centipawns.
+const s32 NULL_MOVE_MIN_DEPTH = 3;
+const s32 NULL_MOVE_VERIFICATION_DEPTH = 12;  // Null move cutoffs from here up need a reduced search without one to agree.
+const s32 REVERSE_FUTILITY_MAX_DEPTH = 6;
+const s32 REVERSE_FUTILITY_MARGIN = 80;       // Per ply.
+const s32 FUTILITY_MAX_DEPTH = 6;
+const s32 FUTILITY_BASE_MARGIN = 100;
+const s32 FUTILITY_MARGIN = 100;              // Per ply.
+const s32 LATE_MOVE_PRUNING_MAX_DEPTH = 6;
+const s32 LMR_MIN_DEPTH = 3;
+const double LMR_BASE = 0.75;
+const double LMR_DIVISOR = 2.25;
+const s32 SINGULAR_MIN_DEPTH = 8;
+const s32 SINGULAR_MARGIN = 2;                // Per ply, below the table score.
+const s32 PROBCUT_MIN_DEPTH = 5;
+const s32 PROBCUT_MARGIN = 200;
+const s32 PROBCUT_REDUCTION = 4;
+
+static const char *SEARCH_FEATURE_NAMES[SEARCH_FEATURE_COUNT] = {
+    "NullMove", "LMR", "ReverseFutility", "Futility", "LMP", "Singular", "ProbCut"
+};
+
+//
+// --- Helpers ---
+//
+
+// Mate scores are stored relative to the node, so they stay right when reached through another path.
+static inline s32 score_to_tt(s32 score, s32 ply) {
+    if (score >= SCORE_MATE_IN_MAX_PLY)   return score + ply;
+    if (score <= -SCORE_MATE_IN_MAX_PLY)  return score - ply;
+    return score;
+}
+
+static inline s32 score_from_tt(s32 score, s32 ply) {
+    if (score >= SCORE_MATE_IN_MAX_PLY)   return score - ply;
+    if (score <= -SCORE_MATE_IN_MAX_PLY)  return score + ply;
+    return score;
+}
+
+static inline char to_lower(char c) {
+    return (c >= 'A' && c <= 'Z') ? (char)(c + 'a' - 'A') : c;
+}
+
+// True while still pondering. On the ponder hit the clock restarts, so the limits count from there.
+static bool update_pondering(Searcher *searcher) {
+    if (!searcher->pondering)  return false;
+    if (searcher->ponder.load(std::memory_order_relaxed))  return true;
+    searcher->pondering = false;
+    searcher->start_time = get_time_microseconds();
+    return false;
+}
+
+// Relaxed stores of the owner's counters; a reader can see one counter a little ahead of another.
+static void publish_stats(Searcher *searcher) {
+    const u64 *counters = (const u64 *)&searcher->stats;
+    For (SEARCH_STATS_COUNTERS)  searcher->shared_stats[it].store(counters[it], std::memory_order_relaxed);
+    searcher->shared_time.store(get_time_microseconds() - searcher->start_time, std::memory_order_relaxed);
+}
+
+static void check_limits(Searcher *searcher) {
+    publish_stats(searcher);
+    if (searcher->stop.load(std::memory_order_relaxed)) {
+        searcher->stopped = true;
+        return;
+    }
+    if (update_pondering(searcher))  return;
+    if (searcher->limits.infinite)  return;
+
+    const Search_Limits *limits = &searcher->limits;
+    if (limits->nodes > 0 && searcher->stats.nodes >= limits->nodes) {
+        searcher->stopped = true;
+        return;
+    }
+    if (time_manager_out_of_time(&searcher->tm, get_time_microseconds() - searcher->start_time)) {
+        searcher->stopped = true;
+    }
+}
+
+// MultiPV: the root moves of the lines already searched in this iteration.
+static inline bool is_root_excluded(const Searcher *searcher, Move move) {
+    For (searcher->root_line) {
+        if (searcher->lines[it].pv[0] == move)  return true;
+    }
+    return false;
+}
+
+static inline bool is_move_legal(const Position *pos, Move move, Bitboard pinned, s32 king) {
+    s32 from = move_from(move);
+    bool needs_check = (pinned & square_bb(from)) || from == king || move_flags(move) == MOVE_EP_CAPTURE;
+    return !needs_check || is_legal(pos, move, pinned);
+}
+
+//
+// --- Move ordering ---
+//
+static void score_moves(const Searcher *searcher, const Move_List *list, s32 *scores, Move tt_move, s32 ply) {
+    const Position *pos = &searcher->pos;
+    For (list->count) {
+        Move move = list->moves[it];
+        if (move == tt_move) {
+            scores[it] = ORDER_TT_MOVE;
+        } else if (is_capture(move) || is_promotion(move)) {
+            // Most valuable victim, least valuable attacker.
+            s32 victim = (move_flags(move) == MOVE_EP_CAPTURE) ? PAWN : piece_kind(pos->board[move_to(move)]);
+            s32 attacker = piece_kind(pos->board[move_from(move)]);
+            scores[it] = ORDER_CAPTURE + PIECE_VALUES[victim] * 8 - PIECE_VALUES[attacker] / 8;
+            if (is_promotion(move))  scores[it] += PIECE_VALUES[promotion_kind(move)] * 8;
+        } else if (move == searcher->killers[ply][0]) {
+            scores[it] = ORDER_KILLER + 1;
+        } else if (move == searcher->killers[ply][1]) {
+            scores[it] = ORDER_KILLER;
+        } else {
+            scores[it] = searcher->history[pos->side_to_move][move_from(move)][move_to(move)];
+        }
+    }
+}
+
+// Selection sort step: moves the best remaining move to 'index'.
+static Move pick_move(Move_List *list, s32 *scores, s32 index) {
+    s32 best = index;
+    for (s32 i = index + 1; i < list->count; i++) {
+        if (scores[i] > scores[best])  best = i;
+    }
+    Move move = list->moves[best];
+    s32 score = scores[best];
+    list->moves[best] = list->moves[index];
+    scores[best] = scores[index];
+    list->moves[index] = move;
+    scores[index] = score;
+    return move;
+}
+
+static void update_quiet_stats(Searcher *searcher, Move move, s32 depth, s32 ply) {
+    if (searcher->killers[ply][0] != move) {
+        searcher->killers[ply][1] = searcher->killers[ply][0];
+        searcher->killers[ply][0] = move;
+    }
+
+    s32 *history = &searcher->history[searcher->pos.side_to_move][move_from(move)][move_to(move)];
+    s32 bonus = (depth * depth < HISTORY_MAX) ? depth * depth : HISTORY_MAX;
+    *history += bonus - *history * bonus / HISTORY_MAX;
+}
+
+static void update_pv(Searcher *searcher, Move move, s32 ply) {
+    Move *pv = searcher->pv[ply];
+    const Move *child_pv = searcher->pv[ply + 1];
+    pv[ply] = move;
+    for (s32 i = ply + 1; i < searcher->pv_length[ply + 1]; i++)  pv[i] = child_pv[i];
+    searcher->pv_length[ply] = (searcher->pv_length[ply + 1] > ply + 1) ? searcher->pv_length[ply + 1] : ply + 1;
+}
+
+// Nothing before the last null move on the path can repeat: the halfmove clock runs on through the
+// pass, but no game could have reached the positions before it this way.
+static inline s32 first_repetition_key(const Searcher *searcher) {
+    return (searcher->null_ply >= 0) ? searcher->game_key_count + searcher->null_ply : 0;
+}
+
+// Fifty moves without a capture or pawn move, unless they end in mate, or a repetition. A position that
+// already occurred in the search tree is taken as a draw right away, one from before the root only once
+// it occurred twice.
+static bool is_draw(Searcher *searcher, s32 ply) {
+    const Position *pos = &searcher->pos;
+    if (pos->halfmove_clock >= FIFTY_MOVE_PLY) {
+        if (!checkers(pos))  return true;
+        Move_List legal;
+        generate_legal_moves(pos, &legal);
+        return legal.count > 0;
+    }
+
+    const u64 *keys = searcher->keys + first_repetition_key(searcher);
+    s32 index = searcher->game_key_count + ply - first_repetition_key(searcher);
+    s32 distance = find_repetition(pos->key, keys, index, pos->halfmove_clock);
+    if (distance == 0)  return false;
+    if (distance < ply)  return true;
+    return find_repetition(pos->key, keys, index - distance, pos->halfmove_clock - distance) != 0;
+}
+
+// A move back to an earlier position is available, so the node is worth at least a draw.
+static bool has_draw_move(Searcher *searcher, s32 ply) {
+    s32 first = first_repetition_key(searcher);
+    return has_upcoming_repetition(&searcher->pos, searcher->keys + first, searcher->game_key_count + ply - first, ply);
+}
+
+//
+// --- Selective search ---
+//
+static inline bool has_pieces(const Position *pos, s32 color) {
+    return (pos->colors[color] & ~(pos->pieces[PAWN] | pos->pieces[KING])) != 0;
+}
+
+static inline bool is_quiet(Move move) {
+    return !is_capture(move) && !is_promotion(move);
+}
+
+// Keeps the node's static eval for the nodes below. True when it went up since the side to move's
+// previous node, which makes the pruning below a little more willing.
+static bool record_static_eval(Searcher *searcher, s32 ply, bool check, s32 static_eval) {
+    searcher->static_evals[ply] = check ? -SCORE_INFINITE : static_eval;
+    if (check || ply < 2 || searcher->static_evals[ply - 2] == -SCORE_INFINITE)  return false;
+    return static_eval > searcher->static_evals[ply - 2];
+}
+
+static bool reverse_futility_cutoff(const Searcher *searcher, s32 depth, s32 static_eval, s32 beta, bool improving) {
+    if (!(searcher->features & SEARCH_REVERSE_FUTILITY) || depth > REVERSE_FUTILITY_MAX_DEPTH || is_mate_score(beta))  return false;
+    return static_eval - REVERSE_FUTILITY_MARGIN * (depth - (improving ? 1 : 0)) >= beta;
+}
+
+// Not twice in a row, and not with only pawns left, where passing can be the best move there is.
+static bool should_try_null_move(const Searcher *searcher, s32 depth, s32 static_eval, s32 beta, s32 ply) {
+    if (!(searcher->features & SEARCH_NULL_MOVE) || searcher->null_move_disabled > 0)  return false;
+    if (depth < NULL_MOVE_MIN_DEPTH || static_eval < beta || is_mate_score(beta))  return false;
+    if (searcher->null_ply == ply)  return false;
+    return has_pieces(&searcher->pos, searcher->pos.side_to_move);
+}
+
+static s32 null_move_reduction(s32 depth, s32 static_eval, s32 beta) {
+    s32 margin = (static_eval - beta) / 200;
+    return 3 + depth / 4 + ((margin < 3) ? margin : 3);
+}
+
+// Skipped when the table already says a shallower search doesn't reach the ProbCut beta.
+static bool should_try_probcut(const Searcher *searcher, s32 depth, s32 beta, bool tt_hit, const Tt_Data *tt_data, s32 ply) {
+    if (!(searcher->features & SEARCH_PROBCUT) || depth < PROBCUT_MIN_DEPTH || is_mate_score(beta))  return false;
+    return !(tt_hit && tt_data->depth >= depth - PROBCUT_REDUCTION + 1 && score_from_tt(tt_data->score, ply) < beta + PROBCUT_MARGIN);
+}
+
+// Captures that could win enough material to matter, going by what they take.
+static bool is_probcut_move(const Position *pos, Move move, s32 static_eval, s32 probcut_beta) {
+    if (is_promotion(move) || move_flags(move) == MOVE_EP_CAPTURE)  return true;
+    return static_eval + PIECE_VALUES[piece_kind(pos->board[move_to(move)])] >= probcut_beta;
+}
+
+// The table move looks like the only good one when, without it, a shallower search stays below its score.
+static bool is_singular_candidate(const Searcher *searcher, s32 depth, s32 ply, Move move, Move tt_move, bool tt_hit, const Tt_Data *tt_data) {
+    if (!(searcher->features & SEARCH_SINGULAR_EXTENSIONS) || ply == 0 || depth < SINGULAR_MIN_DEPTH)  return false;
+    if (move != tt_move || !tt_hit || searcher->excluded[ply] != MOVE_NONE)  return false;
+    return tt_data->bound != BOUND_UPPER && tt_data->depth >= depth - 3 && !is_mate_score(tt_data->score);
+}
+
+static inline s32 singular_beta(s32 depth, const Tt_Data *tt_data, s32 ply) {
+    return score_from_tt(tt_data->score, ply) - SINGULAR_MARGIN * depth;
+}
+
+// Quiet moves near the leaves that aren't worth a search: late in the list, or too far below alpha.
+// 'quiet_count' includes the move.
+static bool prune_quiet_move(const Searcher *searcher, s32 depth, s32 quiet_count, bool improving, s32 static_eval, s32 alpha) {
+    if ((searcher->features & SEARCH_LATE_MOVE_PRUNING) && depth <= LATE_MOVE_PRUNING_MAX_DEPTH
+        && quiet_count > (3 + depth * depth) / (improving ? 1 : 2)) {
+        return true;
+    }
+    return (searcher->features & SEARCH_FUTILITY) && depth <= FUTILITY_MAX_DEPTH
+        && static_eval + FUTILITY_BASE_MARGIN + FUTILITY_MARGIN * depth <= alpha;
+}
+
+// Plies to take off a quiet move's null window search, which has to beat alpha to be searched at full depth.
+static s32 late_move_reduction(const Searcher *searcher, s32 depth, s32 new_depth, s32 move_number, bool pv_node, bool improving, Move move, s32 ply) {
+    if (!(searcher->features & SEARCH_LATE_MOVE_REDUCTIONS) || depth < LMR_MIN_DEPTH)  return 0;
+    s32 reduction = searcher->reductions[(depth < LMR_TABLE_SIZE) ? depth : LMR_TABLE_SIZE - 1]
+                                        [(move_number < LMR_TABLE_SIZE) ? move_number : LMR_TABLE_SIZE - 1];
+    if (pv_node)  reduction--;
+    if (!improving)  reduction++;
+    if (move == searcher->killers[ply][0] || move == searcher->killers[ply][1])  reduction--;
+    if (reduction > new_depth - 1)  reduction = new_depth - 1;
+    return (reduction > 0) ? reduction : 0;
+}
+
+//
+// --- Search ---
+//
+static s32 quiescence(Searcher *searcher, s32 alpha, s32 beta, s32 ply) {
+    Position *pos = &searcher->pos;
+
+    searcher->stats.nodes++;
+    searcher->stats.qnodes++;
+    if ((searcher->stats.nodes & (LIMIT_CHECK_INTERVAL - 1)) == 0)  check_limits(searcher);
+    if (searcher->stopped)  return 0;
+    if (ply > searcher->seldepth)  searcher->seldepth = ply;
+
+    bool check = checkers(pos) != 0;
+    if (ply >= MAX_PLY - 1)  return check ? SCORE_DRAW : evaluate(pos);
+
+    Tt_Data tt_data;
+    searcher->stats.tt_probes++;
+    bool tt_hit = tt_probe(searcher->tt, pos->key, &tt_data);
+    if (tt_hit) {
+        searcher->stats.tt_hits++;
+        s32 score = score_from_tt(tt_data.score, ply);
+        if ((tt_data.bound == BOUND_EXACT)
+            || (tt_data.bound == BOUND_LOWER && score >= beta)
+            || (tt_data.bound == BOUND_UPPER && score <= alpha)) {
+            searcher->stats.tt_cutoffs++;
+            return score;
+        }
+    }
+
+    s32 best_score = -SCORE_INFINITE;
+    s32 static_eval = 0;
+    if (!check) {
+        static_eval = (tt_hit) ? tt_data.eval : evaluate(pos);
+        if (static_eval >= beta)  return static_eval;
+        if (static_eval > alpha)  alpha = static_eval;
+        best_score = static_eval;
+    }
+
+    // In check every evasion is searched, otherwise only captures and promotions.
+    Move_List list;
+    generate_moves(pos, &list, check ? GENERATE_ALL : GENERATE_CAPTURES);
+    s32 scores[MAX_MOVES];
+    score_moves(searcher, &list, scores, tt_hit ? tt_data.move : MOVE_NONE, ply);
+
+    Bitboard pinned = pinned_pieces(pos, pos->side_to_move);
+    s32 king = king_square(pos, pos->side_to_move);
+    s32 legal_count = 0;
+    For (list.count) {
+        Move move = pick_move(&list, scores, it);
+        if (!is_move_legal(pos, move, pinned, king))  continue;
+        legal_count++;
+
+        // Delta pruning: even winning the captured piece doesn't get near alpha.
+        if (!check && !is_promotion(move) && move_flags(move) != MOVE_EP_CAPTURE) {
+            if (static_eval + PIECE_VALUES[piece_kind(pos->board[move_to(move)])] + 200 <= alpha)  continue;
+        }
+
+        Undo_Info undo;
+        tt_prefetch(searcher->tt, key_after(pos, move));
+        make_move(pos, move, &undo);
+        s32 score = -quiescence(searcher, -beta, -alpha, ply + 1);
+        unmake_move(pos, move, &undo);
+        if (searcher->stopped)  return 0;
+
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) {
+                alpha = score;
+                if (score >= beta)  break;
+            }
+        }
+    }
+
+    if (check && legal_count == 0)  return -SCORE_MATE + ply;
+    return best_score;
+}
+
+static s32 negamax(Searcher *searcher, s32 alpha, s32 beta, s32 depth, s32 ply);
+
+// Searches the captures against a raised beta, in quiescence first and then at reduced depth. One that
+// beats it there is taken to beat beta at full depth too.
+static bool probcut(Searcher *searcher, s32 beta, s32 depth, s32 static_eval, s32 ply, s32 *out_score) {
+    Position *pos = &searcher->pos;
+    s32 probcut_beta = beta + PROBCUT_MARGIN;
+
+    Move_List list;
+    generate_moves(pos, &list, GENERATE_CAPTURES);
+    s32 scores[MAX_MOVES];
+    score_moves(searcher, &list, scores, MOVE_NONE, ply);
+
+    Bitboard pinned = pinned_pieces(pos, pos->side_to_move);
+    s32 king = king_square(pos, pos->side_to_move);
+    For (list.count) {
+        Move move = pick_move(&list, scores, it);
+        if (!is_probcut_move(pos, move, static_eval, probcut_beta))  continue;
+        if (!is_move_legal(pos, move, pinned, king))  continue;
+
+        Undo_Info undo;
+        tt_prefetch(searcher->tt, key_after(pos, move));
+        make_move(pos, move, &undo);
+        s32 score = -quiescence(searcher, -probcut_beta, -probcut_beta + 1, ply + 1);
+        if (score >= probcut_beta && !searcher->stopped)  score = -negamax(searcher, -probcut_beta, -probcut_beta + 1, depth - PROBCUT_REDUCTION, ply + 1);
+        unmake_move(pos, move, &undo);
+        if (searcher->stopped) {
+            *out_score = 0;
+            return true;
+        }
+
+        if (score >= probcut_beta) {
+            tt_store(searcher->tt, pos->key, move, score_to_tt(score, ply), static_eval, depth - PROBCUT_REDUCTION + 1, BOUND_LOWER);
+            *out_score = score;
+            return true;
+        }
+    }
+    return false;
+}
+
+static s32 negamax(Searcher *searcher, s32 alpha, s32 beta, s32 depth, s32 ply) {
+    Position *pos = &searcher->pos;
+    bool pv_node = beta - alpha > 1;
+    searcher->pv_length[ply] = ply;
+
+    if (depth <= 0)  return quiescence(searcher, alpha, beta, ply);
+
+    searcher->stats.nodes++;
+    if ((searcher->stats.nodes & (LIMIT_CHECK_INTERVAL - 1)) == 0)  check_limits(searcher);
+    if (searcher->stopped)  return 0;
+    if (ply > searcher->seldepth)  searcher->seldepth = ply;
+
+    searcher->keys[searcher->game_key_count + ply] = pos->key;
+    if (ply > 0) {
+        if (is_draw(searcher, ply))  return SCORE_DRAW;
+
+        if (alpha < SCORE_DRAW && has_draw_move(searcher, ply)) {
+            alpha = SCORE_DRAW;
+            if (alpha >= beta)  return alpha;
+        }
+
+        // Mate distance pruning.
+        if (alpha < -SCORE_MATE + ply)     alpha = -SCORE_MATE + ply;
+        if (beta > SCORE_MATE - ply - 1)   beta = SCORE_MATE - ply - 1;
+        if (alpha >= beta)  return alpha;
+    }
+    if (ply >= MAX_PLY - 1)  return evaluate(pos);
+
+    bool check = checkers(pos) != 0;
+    if (check)  depth++;
+
+    // The singular extension search of this node leaves out one move, so the table can't stand in for it.
+    Move excluded = searcher->excluded[ply];
+
+    Tt_Data tt_data;
+    searcher->stats.tt_probes++;
+    bool tt_hit = tt_probe(searcher->tt, pos->key, &tt_data);
+    Move tt_move = MOVE_NONE;
+    if (tt_hit) {
+        searcher->stats.tt_hits++;
+        tt_move = tt_data.move;
+        if (!pv_node && excluded == MOVE_NONE && tt_data.depth >= depth) {
+            s32 score = score_from_tt(tt_data.score, ply);
+            if ((tt_data.bound == BOUND_EXACT)
+                || (tt_data.bound == BOUND_LOWER && score >= beta)
+                || (tt_data.bound == BOUND_UPPER && score <= alpha)) {
+                searcher->stats.tt_cutoffs++;
+                return score;
+            }
+        }
+    }
+    s32 static_eval = check ? 0 : (tt_hit ? tt_data.eval : evaluate(pos));
+    bool improving = record_static_eval(searcher, ply, check, static_eval);
+
+    if (!pv_node && !check && excluded == MOVE_NONE) {
+        if (reverse_futility_cutoff(searcher, depth, static_eval, beta, improving))  return static_eval;
+
+        // Even passing keeps the score above beta, so a real move will too.
+        if (should_try_null_move(searcher, depth, static_eval, beta, ply)) {
+            s32 reduction = null_move_reduction(depth, static_eval, beta);
+            searcher->stats.null_move_tries++;
+
+            Undo_Info undo;
+            s32 null_ply = searcher->null_ply;
+            make_null_move(pos, &undo);
+            searcher->null_ply = ply + 1;
+            s32 score = -negamax(searcher, -beta, -beta + 1, depth - 1 - reduction, ply + 1);
+            searcher->null_ply = null_ply;
+            unmake_null_move(pos, &undo);
+            if (searcher->stopped)  return 0;
+
+            if (score >= beta) {
+                // A mate after a pass isn't proven.
+                if (is_mate_score(score))  score = beta;
+                if (depth < NULL_MOVE_VERIFICATION_DEPTH) {
+                    searcher->stats.null_move_cutoffs++;
+                    return score;
+                }
+
+                // Deep enough that zugzwang would cost a lot: agree with a reduced search without passing.
+                searcher->null_move_disabled++;
+                s32 verified = negamax(searcher, beta - 1, beta, depth - reduction, ply);
+                searcher->null_move_disabled--;
+                if (searcher->stopped)  return 0;
+                if (verified >= beta) {
+                    searcher->stats.null_move_cutoffs++;
+                    return score;
+                }
+            }
+        }
+
+        s32 score;
+        if (should_try_probcut(searcher, depth, beta, tt_hit, &tt_data, ply) && probcut(searcher, beta, depth, static_eval, ply, &score))  return score;
+    }
+
+    Move_List list;
+    generate_moves(pos, &list, GENERATE_ALL);
+    s32 scores[MAX_MOVES];
+    score_moves(searcher, &list, scores, tt_move, ply);
+
+    Bitboard pinned = pinned_pieces(pos, pos->side_to_move);
+    s32 king = king_square(pos, pos->side_to_move);
+    s32 original_alpha = alpha;
+    s32 best_score = -SCORE_INFINITE;
+    Move best_move = MOVE_NONE;
+    s32 legal_count = 0;
+    s32 quiet_count = 0;
+
+    For (list.count) {
+        Move move = pick_move(&list, scores, it);
+        if (move == excluded)  continue;
+        if (ply == 0 && is_root_excluded(searcher, move))  continue;
+        if (!is_move_legal(pos, move, pinned, king))  continue;
+        legal_count++;
+        bool quiet = is_quiet(move);
+        if (quiet)  quiet_count++;
+
+        s32 new_depth = depth - 1;
+        if (is_singular_candidate(searcher, depth, ply, move, tt_move, tt_hit, &tt_data)) {
+            s32 singular = singular_beta(depth, &tt_data, ply);
+            searcher->excluded[ply] = move;
+            s32 score = negamax(searcher, singular - 1, singular, (depth - 1) / 2, ply);
+            searcher->excluded[ply] = MOVE_NONE;
+            searcher->pv_length[ply] = ply;
+            if (searcher->stopped)  return 0;
+
+            if (score < singular)  new_depth++;
+            // Multi-cut: another move beats beta on its own.
+            else if (singular >= beta)  return singular;
+        }
+
+        // Pruned unless it gives check, which only shows once the move is made. The child's bucket is
+        // only worth loading for a move that gets searched.
+        bool prunable = ply > 0 && quiet && !check && best_score > -SCORE_MATE_IN_MAX_PLY
+            && prune_quiet_move(searcher, depth, quiet_count, improving, static_eval, alpha);
+        if (!prunable)  tt_prefetch(searcher->tt, key_after(pos, move));
+
+        Undo_Info undo;
+        make_move(pos, move, &undo);
+        bool gives_check = checkers(pos) != 0;
+        if (prunable && !gives_check) {
+            unmake_move(pos, move, &undo);
+            continue;
+        }
+
+        s32 score;
+        if (legal_count == 1) {
+            score = -negamax(searcher, -beta, -alpha, new_depth, ply + 1);
+        } else {
+            s32 reduction = (quiet && !check && !gives_check) ? late_move_reduction(searcher, depth, new_depth, legal_count, pv_node, improving, move, ply) : 0;
+            bool full_depth = true;
+            if (reduction > 0) {
+                searcher->stats.lmr_tries++;
+                score = -negamax(searcher, -alpha - 1, -alpha, new_depth - reduction, ply + 1);
+                full_depth = score > alpha;
+                if (full_depth)  searcher->stats.lmr_researches++;
+            }
+            // Principal variation search: prove the move is worse with a null window first.
+            if (full_depth)  score = -negamax(searcher, -alpha - 1, -alpha, new_depth, ply + 1);
+            if (score > alpha && score < beta)  score = -negamax(searcher, -beta, -alpha, new_depth, ply + 1);
+        }
+        unmake_move(pos, move, &undo);
+        if (searcher->stopped)  return 0;
+
+        if (score <= best_score)  continue;
+        best_score = score;
+        if (score <= alpha)  continue;
+
+        alpha = score;
+        best_move = move;
+
+        update_pv(searcher, move, ply);
+
+        if (score >= beta) {
+            searcher->stats.beta_cutoffs++;
+            if (legal_count == 1)  searcher->stats.first_move_cutoffs++;
+            if (quiet)  update_quiet_stats(searcher, move, depth, ply);
+            break;
+        }
+    }
+
+    if (legal_count == 0) {
+        if (excluded != MOVE_NONE)  return alpha;
+        return check ? -SCORE_MATE + ply : SCORE_DRAW;
+    }
+
+    // Without its best moves the root's score isn't the position's score.
+    if (ply == 0 && searcher->root_line > 0)  return best_score;
+    if (excluded != MOVE_NONE)  return best_score;
+
+    s32 bound = (best_score >= beta) ? BOUND_LOWER : (alpha > original_alpha) ? BOUND_EXACT : BOUND_UPPER;
+    tt_store(searcher->tt, pos->key, best_move, score_to_tt(best_score, ply), static_eval, depth, bound);
+    return best_score;
+}
+
+//
+// --- Iterative deepening ---
+//
+
+// Shared by 'search_position()' and the time-sliced search. False when the root has no legal moves
+// and 'result' is already final.
+static bool begin_search(Searcher *searcher, const Position *root, const Search_Limits *limits, const u64 *game_keys, s32 game_key_count,
+                         Search_Result *result, s32 *out_max_depth, s32 *out_legal_count) {
+    searcher->pos = *root;
+    // Nothing further back can repeat.
+    if (game_key_count > FIFTY_MOVE_PLY) {
+        game_keys += game_key_count - FIFTY_MOVE_PLY;
+        game_key_count = FIFTY_MOVE_PLY;
+    }
+    For (game_key_count)  searcher->keys[it] = game_keys[it];
+    searcher->game_key_count = game_key_count;
+    searcher->limits = *limits;
+    searcher->start_time = get_time_microseconds();
+    searcher->stopped = false;
+    searcher->pondering = is_pondering(searcher);
+    searcher->seldepth = 0;
+    searcher->line_count = 0;
+    searcher->root_line = 0;
+    mem_zero(&searcher->stats, sizeof(searcher->stats));
+    searcher->iteration_count = 0;
+    searcher->shared_iteration_count.store(0, std::memory_order_relaxed);
+    publish_stats(searcher);
+    mem_zero(searcher->killers, sizeof(searcher->killers));
+    mem_zero(searcher->excluded, sizeof(searcher->excluded));
+    searcher->null_ply = -1;
+    searcher->null_move_disabled = 0;
+    if (searcher->thread_index == 0)  tt_new_search(searcher->tt);
+
+    *result = { };
+    Move_List legal;
+    generate_legal_moves(root, &legal);
+    *out_legal_count = legal.count;
+    if (legal.count == 0) {
+        result->score = in_check(root) ? -SCORE_MATE : SCORE_DRAW;
+        return false;
+    }
+    // Something to play even if stopped before the first iteration completes.
+    result->best_move = legal.moves[0];
+
+    start_time_manager(&searcher->tm, limits->time_left, limits->increment, limits->moves_to_go, limits->movetime);
+
+    s32 max_depth = (limits->depth > 0 && !limits->infinite) ? limits->depth : MAX_PLY - 1;
+    if (max_depth > MAX_PLY - 1)  max_depth = MAX_PLY - 1;
+    *out_max_depth = max_depth;
+    return true;
+}
+
+static void aspiration_window(s32 depth, s32 previous_score, s32 delta, s32 *alpha, s32 *beta) {
+    *alpha = -SCORE_INFINITE;
+    *beta = SCORE_INFINITE;
+    if (depth >= 5) {
+        *alpha = (previous_score - delta > -SCORE_INFINITE) ? previous_score - delta : -SCORE_INFINITE;
+        *beta = (previous_score + delta < SCORE_INFINITE) ? previous_score + delta : SCORE_INFINITE;
+    }
+}
+
+// True if the score fell outside the window and the root has to be searched again with the wider one.
+static bool widen_window(s32 score, s32 *alpha, s32 *beta, s32 *delta) {
+    if (score <= *alpha) {
+        *beta = (*alpha + *beta) / 2;
+        *alpha = (score - *delta > -SCORE_INFINITE) ? score - *delta : -SCORE_INFINITE;
+    } else if (score >= *beta) {
+        *beta = (score + *delta < SCORE_INFINITE) ? score + *delta : SCORE_INFINITE;
+    } else {
+        return false;
+    }
+    *delta *= 2;
+    return true;
+}
+
+static void send_report(Searcher *searcher, s32 depth, s32 multi_pv, s32 score, s32 bound, u64 line_nodes, const Move *pv, s32 pv_length) {
+    if (!searcher->report_proc)  return;
+
+    Search_Report report;
+    report.depth = depth;
+    report.seldepth = searcher->seldepth;
+    report.score = score;
+    report.bound = bound;
+    report.multi_pv = multi_pv;
+    report.nodes = searcher->stats.nodes;
+    report.line_nodes = line_nodes;
+    report.time = get_time_microseconds() - searcher->start_time;
+    report.pv = pv;
+    report.pv_length = pv_length;
+    searcher->report_proc(searcher->report_data, &report);
+}
+
+// Before the re-search of a line that fell outside its window. A fail high already has its new
+// best move, a fail low can only show the line's previous one.
+static void report_bound(Searcher *searcher, s32 depth, s32 score, s32 bound, u64 line_nodes) {
+    s32 index = searcher->root_line;
+    if (bound == BOUND_LOWER) {
+        send_report(searcher, depth, index + 1, score, bound, line_nodes, searcher->pv[0], searcher->pv_length[0]);
+    } else {
+        const Search_Line *line = &searcher->lines[index];
+        send_report(searcher, depth, index + 1, score, bound, line_nodes, line->pv, (index < searcher->line_count) ? line->pv_length : 0);
+    }
+}
+
+// Keeps the root's principal variation of a searched line.
+static void store_line(Searcher *searcher, s32 index, s32 depth, s32 score, u64 line_nodes) {
+    Search_Line *line = &searcher->lines[index];
+    line->depth = depth;
+    line->score = score;
+    line->nodes = line_nodes;
+    line->pv_length = searcher->pv_length[0];
+    For (line->pv_length)  line->pv[it] = searcher->pv[0][it];
+    if (index >= searcher->line_count)  searcher->line_count = index + 1;
+}
+
+// Takes over a completed iteration and reports its lines. True when the next one isn't worth starting.
+static bool finish_iteration(Searcher *searcher, s32 depth, s32 legal_count, Search_Result *result) {
+    // Later lines searched without the earlier root moves can still come out better, when the search is unstable.
+    for (s32 i = 1; i < searcher->line_count; i++) {
+        Search_Line line = searcher->lines[i];
+        s32 j = i;
+        for (; j > 0 && searcher->lines[j - 1].score < line.score; j--)  searcher->lines[j] = searcher->lines[j - 1];
+        searcher->lines[j] = line;
+    }
+
+    const Search_Line *best = &searcher->lines[0];
+    s32 score = best->score;
+    result->best_move = best->pv[0];
+    result->ponder_move = (best->pv_length > 1) ? best->pv[1] : MOVE_NONE;
+    result->score = score;
+    result->depth = depth;
+    result->seldepth = searcher->seldepth;
+
+    u64 elapsed = get_time_microseconds() - searcher->start_time;
+    if (searcher->iteration_count < MAX_PLY) {
+        s32 index = searcher->iteration_count++;
+        searcher->shared_iteration_nodes[index].store(searcher->stats.nodes, std::memory_order_relaxed);
+        searcher->shared_iteration_time[index].store(elapsed, std::memory_order_relaxed);
+        searcher->shared_iteration_count.store(searcher->iteration_count, std::memory_order_release);
+    }
+    publish_stats(searcher);
+
+    For (searcher->line_count) {
+        const Search_Line *line = &searcher->lines[it];
+        send_report(searcher, depth, it + 1, line->score, BOUND_EXACT, line->nodes, line->pv, line->pv_length);
+    }
+
+    bool out_of_time = time_manager_done(&searcher->tm, depth, result->best_move, score, elapsed);
+    if (update_pondering(searcher) || searcher->limits.infinite)  return false;
+    if (out_of_time)  return true;
+
+    // Nothing to think about with a single legal move, when playing on the clock.
+    if (legal_count == 1 && searcher->tm.active && !searcher->tm.fixed)  return true;
+
+    // A mate found with plenty of depth to spare won't change anymore.
+    if (is_mate_score(score) && depth >= 2 * (SCORE_MATE - abs(score)) + 4)  return true;
+    return false;
+}
+
+static void end_search(Searcher *searcher, Search_Result *result) {
+    result->nodes = searcher->stats.nodes;
+    result->time = get_time_microseconds() - searcher->start_time;
+    publish_stats(searcher);
+}
+
+//
+// --- Time-sliced search ---
+//
+
+// Mirrors 'negamax()' and 'quiescence()' step by step: every place where those recurse pushes a frame
+// and returns to the driver loop, which can then stop between any two steps.
+enum Sliced_Stage {
+    STAGE_ENTER = 0,
+    STAGE_NEXT_MOVE = 1,
+    STAGE_CHILD_DONE = 2,
+    STAGE_NULL_DONE = 3,
+    STAGE_VERIFY_DONE = 4,
+    STAGE_PROBCUT_NEXT = 5,
+    STAGE_PROBCUT_QS_DONE = 6,
+    STAGE_PROBCUT_DONE = 7,
+    STAGE_SINGULAR_DONE = 8
+};
+
+enum Sliced_Window {
+    WINDOW_FULL = 0,
+    WINDOW_NULL = 1,
+    WINDOW_RESEARCH = 2,
+    WINDOW_REDUCED = 3
+};
+
+const u32 SLICE_CHECK_INTERVAL = 64; // Steps between looks at the slice deadline.
+
+static void push_frame(Sliced_Search *search, s32 alpha, s32 beta, s32 depth, s32 ply) {
+    assert(search->frame_count < SLICED_MAX_FRAMES && "Sliced search stack overflow.");
+    Sliced_Frame *frame = &search->frames[search->frame_count++];
+    frame->alpha = alpha;
+    frame->beta = beta;
+    frame->depth = depth;
+    frame->ply = ply;
+    frame->stage = STAGE_ENTER;
+    frame->quiescence = false;
+}
+
+static void prepare_moves(Searcher *searcher, Sliced_Frame *frame, s32 generate_type, Move tt_move) {
+    const Position *pos = &searcher->pos;
+    generate_moves(pos, &frame->list, generate_type);
+    score_moves(searcher, &frame->list, frame->scores, tt_move, frame->ply);
+    frame->pinned = pinned_pieces(pos, pos->side_to_move);
+    frame->king = king_square(pos, pos->side_to_move);
+    frame->legal_count = 0;
+    frame->quiet_count = 0;
+    frame->move_index = 0;
+    frame->stage = STAGE_NEXT_MOVE;
+}
+
+// Each step returns true when the frame is done, with its value in 'out_score'.
+static bool quiescence_step(Sliced_Search *search, Sliced_Frame *frame, s32 *out_score) {
+    Searcher *searcher = search->searcher;
+    Position *pos = &searcher->pos;
+    s32 ply = frame->ply;
+
+    switch (frame->stage) {
+        case STAGE_ENTER: {
+            searcher->stats.nodes++;
+            searcher->stats.qnodes++;
+            if ((searcher->stats.nodes & (LIMIT_CHECK_INTERVAL - 1)) == 0)  check_limits(searcher);
+            if (searcher->stopped) { *out_score = 0; return true; }
+            if (ply > searcher->seldepth)  searcher->seldepth = ply;
+
+            frame->check = checkers(pos) != 0;
+            if (ply >= MAX_PLY - 1) { *out_score = frame->check ? SCORE_DRAW : evaluate(pos); return true; }
+
+            searcher->stats.tt_probes++;
+            frame->tt_hit = tt_probe(searcher->tt, pos->key, &frame->tt_data);
+            if (frame->tt_hit) {
+                searcher->stats.tt_hits++;
+                s32 score = score_from_tt(frame->tt_data.score, ply);
+                if ((frame->tt_data.bound == BOUND_EXACT)
+                    || (frame->tt_data.bound == BOUND_LOWER && score >= frame->beta)
+                    || (frame->tt_data.bound == BOUND_UPPER && score <= frame->alpha)) {
+                    searcher->stats.tt_cutoffs++;
+                    *out_score = score;
+                    return true;
+                }
+            }
+
+            frame->best_score = -SCORE_INFINITE;
+            frame->static_eval = 0;
+            if (!frame->check) {
+                frame->static_eval = (frame->tt_hit) ? frame->tt_data.eval : evaluate(pos);
+                if (frame->static_eval >= frame->beta) { *out_score = frame->static_eval; return true; }
+                if (frame->static_eval > frame->alpha)  frame->alpha = frame->static_eval;
+                frame->best_score = frame->static_eval;
+            }
+            prepare_moves(searcher, frame, frame->check ? GENERATE_ALL : GENERATE_CAPTURES, frame->tt_hit ? frame->tt_data.move : MOVE_NONE);
+            return false;
+        }
+
+        case STAGE_CHILD_DONE: {
+            s32 score = -search->child_score;
+            unmake_move(pos, frame->move, &frame->undo);
+            if (searcher->stopped) { *out_score = 0; return true; }
+
+            frame->stage = STAGE_NEXT_MOVE;
+            if (score > frame->best_score) {
+                frame->best_score = score;
+                if (score > frame->alpha) {
+                    frame->alpha = score;
+                    if (score >= frame->beta) { *out_score = frame->best_score; return true; }
+                }
+            }
+            return false;
+        }
+
+        case STAGE_NEXT_MOVE: {
+            while (frame->move_index < frame->list.count) {
+                Move move = pick_move(&frame->list, frame->scores, frame->move_index++);
+                if (!is_move_legal(pos, move, frame->pinned, frame->king))  continue;
+                frame->legal_count++;
+
+                if (!frame->check && !is_promotion(move) && move_flags(move) != MOVE_EP_CAPTURE) {
+                    if (frame->static_eval + PIECE_VALUES[piece_kind(pos->board[move_to(move)])] + 200 <= frame->alpha)  continue;
+                }
+
+                frame->move = move;
+                frame->stage = STAGE_CHILD_DONE;
+                tt_prefetch(searcher->tt, key_after(pos, move));
+                make_move(pos, move, &frame->undo);
+                push_frame(search, -frame->beta, -frame->alpha, 0, ply + 1);
+                search->frames[search->frame_count - 1].quiescence = true;
+                return false;
+            }
+
+            *out_score = (frame->check && frame->legal_count == 0) ? -SCORE_MATE + ply : frame->best_score;
+            return true;
+        }
+    }
+    return false;
+}
+
+static s32 finish_node(Searcher *searcher, Sliced_Frame *frame) {
+    bool excluded = searcher->excluded[frame->ply] != MOVE_NONE;
+    if (frame->legal_count == 0) {
+        if (excluded)  return frame->alpha;
+        return frame->check ? -SCORE_MATE + frame->ply : SCORE_DRAW;
+    }
+    if (excluded)  return frame->best_score;
+
+    s32 bound = (frame->best_score >= frame->beta) ? BOUND_LOWER : (frame->alpha > frame->original_alpha) ? BOUND_EXACT : BOUND_UPPER;
+    tt_store(searcher->tt, searcher->pos.key, frame->best_move, score_to_tt(frame->best_score, frame->ply), frame->static_eval, frame->depth, bound);
+    return frame->best_score;
+}
+
+static void start_moves(Searcher *searcher, Sliced_Frame *frame) {
+    prepare_moves(searcher, frame, GENERATE_ALL, frame->tt_hit ? frame->tt_data.move : MOVE_NONE);
+}
+
+// ProbCut goes through the captures in the frame's list before the moves replace them.
+static void start_probcut_or_moves(Searcher *searcher, Sliced_Frame *frame) {
+    if (should_try_probcut(searcher, frame->depth, frame->beta, frame->tt_hit, &frame->tt_data, frame->ply)) {
+        prepare_moves(searcher, frame, GENERATE_CAPTURES, MOVE_NONE);
+        frame->stage = STAGE_PROBCUT_NEXT;
+    } else {
+        start_moves(searcher, frame);
+    }
+}
+
+// Makes 'frame->move' and pushes its child, or takes it back and returns false when pruned.
+static bool push_move(Sliced_Search *search, Sliced_Frame *frame) {
+    Searcher *searcher = search->searcher;
+    Position *pos = &searcher->pos;
+    s32 ply = frame->ply;
+    Move move = frame->move;
+
+    bool quiet = is_quiet(move);
+    bool prunable = ply > 0 && quiet && !frame->check && frame->best_score > -SCORE_MATE_IN_MAX_PLY
+        && prune_quiet_move(searcher, frame->depth, frame->quiet_count, frame->improving, frame->static_eval, frame->alpha);
+    if (!prunable)  tt_prefetch(searcher->tt, key_after(pos, move));
+
+    make_move(pos, move, &frame->undo);
+    bool gives_check = checkers(pos) != 0;
+    if (prunable && !gives_check) {
+        unmake_move(pos, move, &frame->undo);
+        return false;
+    }
+
+    frame->stage = STAGE_CHILD_DONE;
+    if (frame->legal_count == 1) {
+        frame->window = WINDOW_FULL;
+        push_frame(search, -frame->beta, -frame->alpha, frame->new_depth, ply + 1);
+        return true;
+    }
+
+    s32 reduction = (quiet && !frame->check && !gives_check)
+        ? late_move_reduction(searcher, frame->depth, frame->new_depth, frame->legal_count, frame->pv_node, frame->improving, move, ply) : 0;
+    if (reduction > 0) {
+        searcher->stats.lmr_tries++;
+        frame->window = WINDOW_REDUCED;
+        push_frame(search, -frame->alpha - 1, -frame->alpha, frame->new_depth - reduction, ply + 1);
+    } else {
+        frame->window = WINDOW_NULL;
+        push_frame(search, -frame->alpha - 1, -frame->alpha, frame->new_depth, ply + 1);
+    }
+    return true;
+}
+
+static bool finish_probcut_move(Sliced_Search *search, Sliced_Frame *frame, s32 score, s32 *out_score) {
+    Searcher *searcher = search->searcher;
+    Position *pos = &searcher->pos;
+    unmake_move(pos, frame->move, &frame->undo);
+    if (searcher->stopped) { *out_score = 0; return true; }
+
+    if (score >= frame->beta + PROBCUT_MARGIN) {
+        tt_store(searcher->tt, pos->key, frame->move, score_to_tt(score, frame->ply), frame->static_eval, frame->depth - PROBCUT_REDUCTION + 1, BOUND_LOWER);
+        *out_score = score;
+        return true;
+    }
+    frame->stage = STAGE_PROBCUT_NEXT;
+    return false;
+}
+
+static bool negamax_step(Sliced_Search *search, Sliced_Frame *frame, s32 *out_score) {
+    Searcher *searcher = search->searcher;
+    Position *pos = &searcher->pos;
+    s32 ply = frame->ply;
+
+    switch (frame->stage) {
+        case STAGE_ENTER: {
+            frame->pv_node = frame->beta - frame->alpha > 1;
+            searcher->pv_length[ply] = ply;
+            if (frame->depth <= 0) {
+                frame->quiescence = true;
+                return quiescence_step(search, frame, out_score);
+            }
+
+            searcher->stats.nodes++;
+            if ((searcher->stats.nodes & (LIMIT_CHECK_INTERVAL - 1)) == 0)  check_limits(searcher);
+            if (searcher->stopped) { *out_score = 0; return true; }
+            if (ply > searcher->seldepth)  searcher->seldepth = ply;
+
+            searcher->keys[searcher->game_key_count + ply] = pos->key;
+            if (ply > 0) {
+                if (is_draw(searcher, ply)) { *out_score = SCORE_DRAW; return true; }
+
+                if (frame->alpha < SCORE_DRAW && has_draw_move(searcher, ply)) {
+                    frame->alpha = SCORE_DRAW;
+                    if (frame->alpha >= frame->beta) { *out_score = frame->alpha; return true; }
+                }
+
+                if (frame->alpha < -SCORE_MATE + ply)    frame->alpha = -SCORE_MATE + ply;
+                if (frame->beta > SCORE_MATE - ply - 1)  frame->beta = SCORE_MATE - ply - 1;
+                if (frame->alpha >= frame->beta) { *out_score = frame->alpha; return true; }
+            }
+            if (ply >= MAX_PLY - 1) { *out_score = evaluate(pos); return true; }
+
+            frame->check = checkers(pos) != 0;
+            if (frame->check)  frame->depth++;
+            bool excluded = searcher->excluded[ply] != MOVE_NONE;
+
+            searcher->stats.tt_probes++;
+            frame->tt_hit = tt_probe(searcher->tt, pos->key, &frame->tt_data);
+            if (frame->tt_hit) {
+                searcher->stats.tt_hits++;
+                if (!frame->pv_node && !excluded && frame->tt_data.depth >= frame->depth) {
+                    s32 score = score_from_tt(frame->tt_data.score, ply);
+                    if ((frame->tt_data.bound == BOUND_EXACT)
+                        || (frame->tt_data.bound == BOUND_LOWER && score >= frame->beta)
+                        || (frame->tt_data.bound == BOUND_UPPER && score <= frame->alpha)) {
+                        searcher->stats.tt_cutoffs++;
+                        *out_score = score;
+                        return true;
+                    }
+                }
+            }
+            frame->static_eval = frame->check ? 0 : (frame->tt_hit ? frame->tt_data.eval : evaluate(pos));
+            frame->improving = record_static_eval(searcher, ply, frame->check, frame->static_eval);
+
+            frame->original_alpha = frame->alpha;
+            frame->best_score = -SCORE_INFINITE;
+            frame->best_move = MOVE_NONE;
+            if (frame->pv_node || frame->check || excluded) {
+                start_moves(searcher, frame);
+                return false;
+            }
+
+            if (reverse_futility_cutoff(searcher, frame->depth, frame->static_eval, frame->beta, frame->improving)) {
+                *out_score = frame->static_eval;
+                return true;
+            }
+
+            if (should_try_null_move(searcher, frame->depth, frame->static_eval, frame->beta, ply)) {
+                frame->reduction = null_move_reduction(frame->depth, frame->static_eval, frame->beta);
+                searcher->stats.null_move_tries++;
+
+                frame->saved_null_ply = searcher->null_ply;
+                make_null_move(pos, &frame->undo);
+                searcher->null_ply = ply + 1;
+                frame->stage = STAGE_NULL_DONE;
+                push_frame(search, -frame->beta, -frame->beta + 1, frame->depth - 1 - frame->reduction, ply + 1);
+                return false;
+            }
+
+            start_probcut_or_moves(searcher, frame);
+            return false;
+        }
+
+        case STAGE_NULL_DONE: {
+            s32 score = -search->child_score;
+            searcher->null_ply = frame->saved_null_ply;
+            unmake_null_move(pos, &frame->undo);
+            if (searcher->stopped) { *out_score = 0; return true; }
+
+            if (score >= frame->beta) {
+                if (is_mate_score(score))  score = frame->beta;
+                if (frame->depth < NULL_MOVE_VERIFICATION_DEPTH) {
+                    searcher->stats.null_move_cutoffs++;
+                    *out_score = score;
+                    return true;
+                }
+
+                frame->null_score = score;
+                searcher->null_move_disabled++;
+                frame->stage = STAGE_VERIFY_DONE;
+                push_frame(search, frame->beta - 1, frame->beta, frame->depth - frame->reduction, ply);
+                return false;
+            }
+
+            start_probcut_or_moves(searcher, frame);
+            return false;
+        }
+
+        case STAGE_VERIFY_DONE: {
+            searcher->null_move_disabled--;
+            if (searcher->stopped) { *out_score = 0; return true; }
+            if (search->child_score >= frame->beta) {
+                searcher->stats.null_move_cutoffs++;
+                *out_score = frame->null_score;
+                return true;
+            }
+
+            start_probcut_or_moves(searcher, frame);
+            return false;
+        }
+
+        case STAGE_PROBCUT_NEXT: {
+            s32 probcut_beta = frame->beta + PROBCUT_MARGIN;
+            while (frame->move_index < frame->list.count) {
+                Move move = pick_move(&frame->list, frame->scores, frame->move_index++);
+                if (!is_probcut_move(pos, move, frame->static_eval, probcut_beta))  continue;
+                if (!is_move_legal(pos, move, frame->pinned, frame->king))  continue;
+
+                frame->move = move;
+                frame->stage = STAGE_PROBCUT_QS_DONE;
+                tt_prefetch(searcher->tt, key_after(pos, move));
+                make_move(pos, move, &frame->undo);
+                push_frame(search, -probcut_beta, -probcut_beta + 1, 0, ply + 1);
+                search->frames[search->frame_count - 1].quiescence = true;
+                return false;
+            }
+
+            start_moves(searcher, frame);
+            return false;
+        }
+
+        case STAGE_PROBCUT_QS_DONE: {
+            s32 score = -search->child_score;
+            s32 probcut_beta = frame->beta + PROBCUT_MARGIN;
+            if (score >= probcut_beta && !searcher->stopped) {
+                frame->stage = STAGE_PROBCUT_DONE;
+                push_frame(search, -probcut_beta, -probcut_beta + 1, frame->depth - PROBCUT_REDUCTION, ply + 1);
+                return false;
+            }
+            return finish_probcut_move(search, frame, score, out_score);
+        }
+
+        case STAGE_PROBCUT_DONE: {
+            return finish_probcut_move(search, frame, -search->child_score, out_score);
+        }
+
+        case STAGE_SINGULAR_DONE: {
+            s32 score = search->child_score;
+            searcher->excluded[ply] = MOVE_NONE;
+            searcher->pv_length[ply] = ply;
+            if (searcher->stopped) { *out_score = 0; return true; }
+
+            s32 singular = singular_beta(frame->depth, &frame->tt_data, ply);
+            if (score < singular) {
+                frame->new_depth++;
+            } else if (singular >= frame->beta) {
+                *out_score = singular;
+                return true;
+            }
+
+            if (!push_move(search, frame))  frame->stage = STAGE_NEXT_MOVE;
+            return false;
+        }
+
+        case STAGE_CHILD_DONE: {
+            s32 score = -search->child_score;
+            if (frame->window == WINDOW_REDUCED && score > frame->alpha && !searcher->stopped) {
+                searcher->stats.lmr_researches++;
+                frame->window = WINDOW_NULL;
+                push_frame(search, -frame->alpha - 1, -frame->alpha, frame->new_depth, ply + 1);
+                return false;
+            }
+            if (frame->window == WINDOW_NULL && score > frame->alpha && score < frame->beta && !searcher->stopped) {
+                frame->window = WINDOW_RESEARCH;
+                push_frame(search, -frame->beta, -frame->alpha, frame->new_depth, ply + 1);
+                return false;
+            }
+            unmake_move(pos, frame->move, &frame->undo);
+            if (searcher->stopped) { *out_score = 0; return true; }
+
+            frame->stage = STAGE_NEXT_MOVE;
+            if (score <= frame->best_score)  return false;
+            frame->best_score = score;
+            if (score <= frame->alpha)  return false;
+
+            Move move = frame->move;
+            frame->alpha = score;
+            frame->best_move = move;
+            update_pv(searcher, move, ply);
+
+            if (score >= frame->beta) {
+                searcher->stats.beta_cutoffs++;
+                if (frame->legal_count == 1)  searcher->stats.first_move_cutoffs++;
+                if (is_quiet(move))  update_quiet_stats(searcher, move, frame->depth, ply);
+                *out_score = finish_node(searcher, frame);
+                return true;
+            }
+            return false;
+        }
+
+        case STAGE_NEXT_MOVE: {
+            while (frame->move_index < frame->list.count) {
+                Move move = pick_move(&frame->list, frame->scores, frame->move_index++);
+                if (move == searcher->excluded[ply])  continue;
+                if (!is_move_legal(pos, move, frame->pinned, frame->king))  continue;
+                frame->legal_count++;
+                if (is_quiet(move))  frame->quiet_count++;
+
+                frame->move = move;
+                frame->new_depth = frame->depth - 1;
+                Move tt_move = frame->tt_hit ? frame->tt_data.move : MOVE_NONE;
+                if (is_singular_candidate(searcher, frame->depth, ply, move, tt_move, frame->tt_hit, &frame->tt_data)) {
+                    s32 singular = singular_beta(frame->depth, &frame->tt_data, ply);
+                    searcher->excluded[ply] = move;
+                    frame->stage = STAGE_SINGULAR_DONE;
+                    push_frame(search, singular - 1, singular, (frame->depth - 1) / 2, ply);
+                    return false;
+                }
+
+                if (push_move(search, frame))  return false;
+            }
+
+            *out_score = finish_node(searcher, frame);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Runs frames until the root returns (true, value in 'child_score') or the deadline passes (false).
+static bool run_frames(Sliced_Search *search, u64 deadline) {
+    u32 steps = 0;
+    while (search->frame_count > 0) {
+        if ((++steps & (SLICE_CHECK_INTERVAL - 1)) == 0 && get_time_microseconds() >= deadline)  return false;
+
+        Sliced_Frame *frame = &search->frames[search->frame_count - 1];
+        s32 score;
+        bool done = frame->quiescence ? quiescence_step(search, frame, &score) : negamax_step(search, frame, &score);
+        if (done) {
+            search->frame_count--;
+            search->child_score = score;
+        }
+    }
+    return true;
+}
+
+static void start_iteration(Sliced_Search *search) {
+    search->iteration_nodes = search->searcher->stats.nodes;
+    search->delta = ASPIRATION_WINDOW;
+    aspiration_window(search->depth, search->previous_score, search->delta, &search->alpha, &search->beta);
+    push_frame(search, search->alpha, search->beta, search->depth, 0);
+}
+
+//
+// --- Interface ---
+//
+Searcher *create_searcher(Transposition_Table *tt) {
+    Searcher *searcher = ALLOC(sys_allocator, 1, Searcher);
+    mem_zero(searcher, sizeof(Searcher));
+    searcher->tt = tt;
+    searcher->features = SEARCH_ALL_FEATURES;
+    searcher->stop.store(false);
+    searcher->ponder.store(false);
+
+    // Grows with both the depth and the number of moves tried before.
+    for (s32 depth = 1; depth < LMR_TABLE_SIZE; depth++) {
+        for (s32 move = 1; move < LMR_TABLE_SIZE; move++) {
+            searcher->reductions[depth][move] = (s8)(LMR_BASE + log((double)depth) * log((double)move) / LMR_DIVISOR);
+        }
+    }
+    return searcher;
+}
+
+void destroy_searcher(Searcher *searcher) {
+    FREE(sys_allocator, searcher);
+}
+
+void clear_searcher(Searcher *searcher) {
+    mem_zero(searcher->killers, sizeof(searcher->killers));
+    mem_zero(searcher->history, sizeof(searcher->history));
+}
+
+u32 search_feature_from_name(const char *name, s32 size) {
+    For (SEARCH_FEATURE_COUNT) {
+        const char *feature = SEARCH_FEATURE_NAMES[it];
+        if ((s32)strlen(feature) != size)  continue;
+
+        s32 i = 0;
+        while (i < size && to_lower(name[i]) == to_lower(feature[i]))  i++;
+        if (i == size)  return 1u << it;
+    }
+    return 0;
+}
+
+const char *search_feature_name(u32 feature) {
+    For (SEARCH_FEATURE_COUNT) {
+        if (feature == (1u << it))  return SEARCH_FEATURE_NAMES[it];
+    }
+    return "";
+}
+
+void stop_search(Searcher *searcher) {
+    searcher->stop.store(true, std::memory_order_relaxed);
+}
+
+void clear_stop_request(Searcher *searcher) {
+    searcher->stop.store(false, std::memory_order_relaxed);
+}
+
+void start_pondering(Searcher *searcher) {
+    searcher->ponder.store(true, std::memory_order_relaxed);
+}
+
+void ponder_hit(Searcher *searcher) {
+    searcher->ponder.store(false, std::memory_order_relaxed);
+}
+
+void collect_search_stats(Searcher *const *searchers, s32 searcher_count, Search_Stats *out_stats, u64 *out_time) {
+    u64 *totals = (u64 *)out_stats;
+    mem_zero(out_stats, sizeof(Search_Stats));
+    u64 time = 0;
+    For (searcher_count) {
+        const Searcher *searcher = searchers[it];
+        for (s32 i = 0; i < SEARCH_STATS_COUNTERS; i++)  totals[i] += searcher->shared_stats[i].load(std::memory_order_relaxed);
+        u64 searcher_time = searcher->shared_time.load(std::memory_order_relaxed);
+        if (searcher_time > time)  time = searcher_time;
+    }
+    if (out_time)  *out_time = time;
+}
+
+s32 collect_search_iterations(const Searcher *searcher, Search_Iteration *out_iterations) {
+    s32 count = searcher->shared_iteration_count.load(std::memory_order_acquire);
+    For (count) {
+        out_iterations[it].depth = it + 1;
+        out_iterations[it].nodes = searcher->shared_iteration_nodes[it].load(std::memory_order_relaxed);
+        out_iterations[it].time = searcher->shared_iteration_time[it].load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+Search_Result search_position(Searcher *searcher, const Position *root, const Search_Limits *limits, const u64 *game_keys, s32 game_key_count) {
+    ZoneScoped;
+
+    Search_Result result;
+    s32 max_depth, legal_count;
+    if (!begin_search(searcher, root, limits, game_keys, game_key_count, &result, &max_depth, &legal_count))  return result;
+
+    s32 line_count = (limits->multi_pv > 1) ? limits->multi_pv : 1;
+    if (line_count > MAX_MULTI_PV)  line_count = MAX_MULTI_PV;
+    if (line_count > legal_count)   line_count = legal_count;
+
+    for (s32 depth = 1; depth <= max_depth; depth++) {
+        // One aspiration search per line, each around that line's previous score.
+        for (s32 line = 0; line < line_count; line++) {
+            searcher->root_line = line;
+            u64 line_start = searcher->stats.nodes;
+            s32 previous_score = (line < searcher->line_count) ? searcher->lines[line].score : 0;
+
+            s32 alpha, beta;
+            s32 delta = ASPIRATION_WINDOW;
+            aspiration_window(depth, previous_score, delta, &alpha, &beta);
+
+            s32 score;
+            for (;;) {
+                score = negamax(searcher, alpha, beta, depth, 0);
+                if (searcher->stopped)  break;
+                s32 window_alpha = alpha;
+                if (!widen_window(score, &alpha, &beta, &delta))  break;
+                report_bound(searcher, depth, score, (score <= window_alpha) ? BOUND_UPPER : BOUND_LOWER, searcher->stats.nodes - line_start);
+            }
+            if (searcher->stopped)  break;
+            store_line(searcher, line, depth, score, searcher->stats.nodes - line_start);
+        }
+        searcher->root_line = 0;
+        if (searcher->stopped)  break;
+
+        if (finish_iteration(searcher, depth, legal_count, &result))  break;
+    }
+
+    end_search(searcher, &result);
+    return result;
+}
+
+Sliced_Search *create_sliced_search(Searcher *searcher) {
+    Sliced_Search *search = ALLOC(sys_allocator, 1, Sliced_Search);
+    mem_zero(search, sizeof(Sliced_Search));
+    search->searcher = searcher;
+    return search;
+}
+
+void destroy_sliced_search(Sliced_Search *search) {
+    FREE(sys_allocator, search);
+}
+
+void start_sliced_search(Sliced_Search *search, const Position *root, const Search_Limits *limits, const u64 *game_keys, s32 game_key_count) {
+    ZoneScoped;
+
+    search->frame_count = 0;
+    search->running = begin_search(search->searcher, root, limits, game_keys, game_key_count, &search->result, &search->max_depth, &search->legal_count);
+    if (!search->running)  return;
+
+    search->depth = 1;
+    search->previous_score = 0;
+    start_iteration(search);
+}
+
+bool advance_sliced_search(Sliced_Search *search, u64 budget) {
+    ZoneScoped;
+
+    if (!search->running)  return true;
+
+    Searcher *searcher = search->searcher;
+    u64 deadline = get_time_microseconds() + budget;
+    for (;;) {
+        if (!run_frames(search, deadline))  return false;
+
+        s32 score = search->child_score;
+        if (!searcher->stopped) {
+            u64 line_nodes = searcher->stats.nodes - search->iteration_nodes;
+            s32 window_alpha = search->alpha;
+            if (widen_window(score, &search->alpha, &search->beta, &search->delta)) {
+                report_bound(searcher, search->depth, score, (score <= window_alpha) ? BOUND_UPPER : BOUND_LOWER, line_nodes);
+                push_frame(search, search->alpha, search->beta, search->depth, 0);
+                continue;
+            }
+
+            search->previous_score = score;
+            store_line(searcher, 0, search->depth, score, line_nodes);
+            bool done = finish_iteration(searcher, search->depth, search->legal_count, &search->result);
+            if (!done && search->depth < search->max_depth) {
+                search->depth++;
+                start_iteration(search);
+                continue;
+            }
+        }
+
+        end_search(searcher, &search->result);
+        search->running = false;
+        return true;
+    }
+}
@@ -0,0 +1,272 @@
+#ifndef PAWN_SEARCH_H
+#define PAWN_SEARCH_H
+
+#include <atomic>
+
+#include "movegen.h"
+#include "position.h"
+#include "timeman.h"
+#include "tt.h"
+
+//
+// --- Constants ---
+//
+const int MAX_PLY = 128;
+
+const s32 SCORE_DRAW = 0;
+const s32 SCORE_MATE = 32000;
+const s32 SCORE_MATE_IN_MAX_PLY = SCORE_MATE - MAX_PLY;
+const s32 SCORE_INFINITE = 32001;
+
+const s32 MAX_MULTI_PV = 16;
+const int LMR_TABLE_SIZE = 64;
+const int SLICED_MAX_FRAMES = 3 * (MAX_PLY + 1);  // A null move verification and a singular search can sit on a ply's node.
+
+//
+// --- Enums ---
+//
+
+// Selective search, each part switched on and off on its own so it can be measured against the rest.
+enum Search_Feature {
+    SEARCH_NULL_MOVE = (1 << 0),           // Null move pruning, verified at high depth.
+    SEARCH_LATE_MOVE_REDUCTIONS = (1 << 1),
+    SEARCH_REVERSE_FUTILITY = (1 << 2),    // Static eval far above beta near the leaves.
+    SEARCH_FUTILITY = (1 << 3),            // Quiet moves that can't bring the static eval up to alpha.
+    SEARCH_LATE_MOVE_PRUNING = (1 << 4),   // Quiet moves late in the list near the leaves.
+    SEARCH_SINGULAR_EXTENSIONS = (1 << 5),
+    SEARCH_PROBCUT = (1 << 6),             // Captures that beat beta by a margin in a shallow search.
+    SEARCH_FEATURE_COUNT = 7,
+    SEARCH_ALL_FEATURES = (1 << SEARCH_FEATURE_COUNT) - 1
+};
+
+//
+// --- Structs ---
+//
+
+// Zero fields mean "no limit". With no limit at all the search runs until stopped.
+struct Search_Limits {
+    s32 depth;
+    u64 nodes;
+    s64 movetime;         // Milliseconds.
+    s64 time_left;        // Milliseconds on the clock of the side to move, shared out by the time manager.
+    s64 increment;
+    s32 moves_to_go;      // Until the next time control, 0 for sudden death.
+    s32 multi_pv;         // Best root moves to find a line for, 0 and 1 both mean just the best one.
+    bool infinite;        // Ignore everything above, only 'stop_search()' ends the search.
+};
+
+// Counters of one search thread. Only u64 fields, so they can be published word by word.
+struct Search_Stats {
+    u64 nodes;            // Main search and quiescence together.
+    u64 qnodes;
+    u64 tt_probes;
+    u64 tt_hits;
+    u64 tt_cutoffs;
+    u64 beta_cutoffs;
+    u64 first_move_cutoffs;
+    u64 null_move_tries;
+    u64 null_move_cutoffs;
+    u64 lmr_tries;        // Reduced searches of late moves...
+    u64 lmr_researches;   // ...that beat alpha and had to be searched again at full depth.
+};
+
+const int SEARCH_STATS_COUNTERS = sizeof(Search_Stats) / sizeof(u64);
+
+// State at the end of a completed iteration.
+struct Search_Iteration {
+    s32 depth;
+    u64 nodes;            // Since the search started.
+    u64 time;             // Microseconds since the search started.
+};
+
+// Sent for every line after each completed iteration, and when a line fails outside its aspiration
+// window ('bound' is then BOUND_LOWER or BOUND_UPPER and the line is searched again).
+struct Search_Report {
+    s32 depth;
+    s32 seldepth;
+    s32 score;
+    s32 bound;
+    s32 multi_pv;         // 1 for the best line.
+    u64 nodes;
+    u64 line_nodes;       // Spent on this line in this iteration.
+    u64 time;             // Microseconds since the search started.
+    const Move *pv;
+    s32 pv_length;
+};
+
+typedef void (*Search_Report_Proc)(void *data, const Search_Report *report);
+
+struct Search_Result {
+    Move best_move;       // MOVE_NONE when the root has no legal moves.
+    Move ponder_move;
+    s32 score;
+    s32 depth;            // Last completed iteration.
+    s32 seldepth;
+    u64 nodes;
+    u64 time;             // Microseconds.
+};
+
+struct Search_Line {
+    s32 depth;
+    s32 score;
+    u64 nodes;            // Spent on the line in its last iteration.
+    s32 pv_length;
+    Move pv[MAX_PLY];
+};
+
+// One per search thread. Large; create with 'create_searcher()'.
+struct Searcher {
+    Transposition_Table *tt;
+    s32 thread_index;             // 0 for the main thread; helpers sharing its table leave the table generation alone.
+    u32 features;                 // Search_Feature bits, all of them unless changed.
+    Position pos;
+    Search_Limits limits;
+    u64 start_time;               // Reset on ponder hit, so the limits count from there.
+    Time_Manager tm;
+    std::atomic<bool> stop;
+    std::atomic<bool> ponder;
+    bool stopped;
+    bool pondering;
+
+    Search_Stats stats;
+    s32 seldepth;
+    s32 iteration_count;
+
+    // Copies other threads can read during the search: 'stats' as of the last few hundred nodes, and
+    // every completed iteration.
+    std::atomic<u64> shared_stats[SEARCH_STATS_COUNTERS];
+    std::atomic<u64> shared_time;
+    std::atomic<s32> shared_iteration_count;
+    std::atomic<u64> shared_iteration_nodes[MAX_PLY];
+    std::atomic<u64> shared_iteration_time[MAX_PLY];
+    Search_Report_Proc report_proc;
+    void *report_data;
+
+    // Keys of the game positions before the root, then of the positions on the way to the current node.
+    s32 game_key_count;
+    u64 keys[FIFTY_MOVE_PLY + MAX_PLY + 1];
+
+    // MultiPV: line 'root_line' is searched without the root moves of the lines before it.
+    s32 line_count;
+    s32 root_line;
+    Search_Line lines[MAX_MULTI_PV];
+
+    Move killers[MAX_PLY][2];
+    s32 history[2][SQUARE_COUNT][SQUARE_COUNT];
+    Move pv[MAX_PLY + 1][MAX_PLY + 1];
+    s32 pv_length[MAX_PLY + 1];
+
+    // Selective search state of the current path.
+    s32 static_evals[MAX_PLY + 1];    // -SCORE_INFINITE in check.
+    Move excluded[MAX_PLY + 1];       // Left out by the singular extension search of the node.
+    s32 null_ply;                     // Of the position after the last null move, -1 for none.
+    s32 null_move_disabled;           // Inside a null move verification search.
+    s8 reductions[LMR_TABLE_SIZE][LMR_TABLE_SIZE];  // By depth and move number.
+};
+
+// One level of the time-sliced search's explicit stack: what a recursive call keeps in its locals.
+struct Sliced_Frame {
+    s32 alpha;
+    s32 beta;
+    s32 depth;
+    s32 ply;
+    u8 stage;
+    u8 window;                    // How the child being searched was called, for the PVS re-search.
+    bool quiescence;
+    bool check;
+    bool pv_node;
+    bool improving;
+    bool tt_hit;
+    Tt_Data tt_data;
+    s32 static_eval;
+    s32 original_alpha;
+    s32 best_score;
+    Move best_move;
+    Move move;                    // Being searched by the child frame.
+    Undo_Info undo;
+    s32 legal_count;
+    s32 quiet_count;
+    s32 move_index;
+    s32 new_depth;                // Of the move being searched, before any reduction.
+    s32 reduction;                // Of the null move.
+    s32 null_score;               // Returned once the verification search agrees.
+    s32 saved_null_ply;
+    Bitboard pinned;
+    s32 king;
+    Move_List list;
+    s32 scores[MAX_MOVES];
+};
+
+// Iterative deepening that can be suspended between any two steps and resumed later, for targets where
+// the search shares one core with the render loop. Searches the same tree as 'search_position()', with
+// an explicit stack instead of recursion. Large; create with 'create_sliced_search()'.
+struct Sliced_Search {
+    Searcher *searcher;
+    Search_Result result;
+    bool running;
+
+    s32 max_depth;
+    s32 legal_count;
+    s32 depth;
+    s32 alpha;
+    s32 beta;
+    s32 delta;
+    s32 previous_score;
+    u64 iteration_nodes;          // Node count when the iteration started.
+
+    s32 frame_count;
+    s32 child_score;              // Value returned by the frame that was popped last.
+    Sliced_Frame frames[SLICED_MAX_FRAMES];
+};
+
+//
+// --- Functions ---
+//
+inline bool is_mate_score(s32 score) { return score >= SCORE_MATE_IN_MAX_PLY || score <= -SCORE_MATE_IN_MAX_PLY; }
+
+// Full moves to the mate of a mate score for the side to move, negative when it gets mated: 3 for "mate
+// in 3", -1 for getting mated by the reply. Only from the side to move, a score negated to the other side
+// counts its plies wrong.
+inline s32 mate_in_moves(s32 score) { return (score > 0) ? (SCORE_MATE - score + 1) / 2 : -(SCORE_MATE + score) / 2; }
+
+Searcher *create_searcher(Transposition_Table *tt);
+void destroy_searcher(Searcher *searcher);
+
+// Forgets killers and history, for a new game.
+void clear_searcher(Searcher *searcher);
+
+// Runs iterative deepening on 'root' until a limit is hit or 'stop_search()' is called. With
+// 'limits->multi_pv' the best lines are left in 'searcher->lines', best first. 'game_keys' are the keys
+// of the positions the game went through before 'root', oldest first, for draws by repetition.
+Search_Result search_position(Searcher *searcher, const Position *root, const Search_Limits *limits, const u64 *game_keys = NULL, s32 game_key_count = 0);
+
+// Search_Feature bit of a name ("NullMove", "LMR", "ReverseFutility", "Futility", "LMP", "Singular",
+// "ProbCut"), case-insensitive; 0 for an unknown one.
+u32 search_feature_from_name(const char *name, s32 size);
+const char *search_feature_name(u32 feature);
+
+// Can be called from any thread. The request stays until 'clear_stop_request()', so a stop that
+// arrives before a search thread gets going isn't lost.
+void stop_search(Searcher *searcher);
+void clear_stop_request(Searcher *searcher);
+
+// Any thread, also while the searchers run. Sums what each of them published last, and copies the
+// iterations completed by one of them; returns their count.
+void collect_search_stats(Searcher *const *searchers, s32 searcher_count, Search_Stats *out_stats, u64 *out_time = NULL);
+s32 collect_search_iterations(const Searcher *searcher, Search_Iteration *out_iterations);
+
+// The sliced search uses the searcher's tables, limits and report callback like 'search_position()',
+// but always searches a single line.
+Sliced_Search *create_sliced_search(Searcher *searcher);
+void destroy_sliced_search(Sliced_Search *search);
+void start_sliced_search(Sliced_Search *search, const Position *root, const Search_Limits *limits, const u64 *game_keys = NULL, s32 game_key_count = 0);
+// Searches for about 'budget' microseconds. True once the search is over, 'search->result' then holds the move.
+bool advance_sliced_search(Sliced_Search *search, u64 budget);
+
+// While pondering the limits are ignored. 'ponder_hit()' (any thread) turns the search into a normal
+// one whose limits start counting at that moment. Set before 'search_position()'.
+void start_pondering(Searcher *searcher);
+void ponder_hit(Searcher *searcher);
+inline bool is_pondering(const Searcher *searcher) { return searcher->ponder.load(std::memory_order_relaxed); }
+
+#endif /* PAWN_SEARCH_H */
@@ -0,0 +1,65 @@
+#ifndef PAWN_SPSC_H
+#define PAWN_SPSC_H
+
+#include <atomic>
+
+#include "common.h"
+
+//
+// --- Constants ---
+//
+const int CACHE_LINE_SIZE = 64;
+
+//
+// --- Structs ---
+//
+
+// Lock-free ring buffer for exactly one producer thread and one consumer thread.
+// 'N' is a power of two; the indices run freely and wrap, so all N slots are usable.
+// Each index lives on its own cache line, the two threads only share a line when handing over an item.
+template <typename T, u32 N>
+struct Spsc_Queue {
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> head;  // Next item to pop, written by the consumer only.
+    alignas(CACHE_LINE_SIZE) std::atomic<u32> tail;  // Next slot to push, written by the producer only.
+    alignas(CACHE_LINE_SIZE) T items[N];
+};
+
+//
+// --- Functions ---
+//
+template <typename T, u32 N>
+void spsc_init(Spsc_Queue<T, N> *queue) {
+    static_assert((N & (N - 1)) == 0, "Spsc_Queue size must be a power of two.");
+    queue->head.store(0);
+    queue->tail.store(0);
+}
+
+// Producer side. False when the queue is full; nothing waits.
+template <typename T, u32 N>
+bool spsc_push(Spsc_Queue<T, N> *queue, const T &item) {
+    u32 tail = queue->tail.load(std::memory_order_relaxed);
+    if (tail - queue->head.load(std::memory_order_acquire) == N)  return false;
+
+    queue->items[tail & (N - 1)] = item;
+    queue->tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// Consumer side. False when the queue is empty.
+template <typename T, u32 N>
+bool spsc_pop(Spsc_Queue<T, N> *queue, T *out_item) {
+    u32 head = queue->head.load(std::memory_order_relaxed);
+    if (head == queue->tail.load(std::memory_order_acquire))  return false;
+
+    *out_item = queue->items[head & (N - 1)];
+    queue->head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+// Consumer side.
+template <typename T, u32 N>
+bool spsc_empty(const Spsc_Queue<T, N> *queue) {
+    return queue->head.load(std::memory_order_relaxed) == queue->tail.load(std::memory_order_acquire);
+}
+
+#endif /* PAWN_SPSC_H */
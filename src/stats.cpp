@@ -0,0 +1,102 @@
+// fopen()
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include <stdio.h>
+
+#include "stats.h"
+
+//
+// --- Helpers ---
+//
+static double rate(u64 part, u64 whole) {
+    return (whole > 0) ? (double)part / (double)whole : 0.0;
+}
+
+// Nodes spent on iteration 'index' alone.
+static u64 iteration_nodes(const Search_Summary *summary, s32 index) {
+    u64 before = (index > 0) ? summary->iterations[index - 1].nodes : 0;
+    return summary->iterations[index].nodes - before;
+}
+
+//
+// --- Interface ---
+//
+void summarize_search(Searcher *const *searchers, s32 searcher_count, Search_Summary *out_summary) {
+    Search_Summary *summary = out_summary;
+    summary->thread_count = searcher_count;
+    collect_search_stats(searchers, searcher_count, &summary->totals, &summary->time);
+    summary->iteration_count = (searcher_count > 0) ? collect_search_iterations(searchers[0], summary->iterations) : 0;
+
+    const Search_Stats *totals = &summary->totals;
+    summary->nps = (summary->time > 0) ? totals->nodes * 1000000 / summary->time : 0;
+    summary->qnode_rate = rate(totals->qnodes, totals->nodes);
+    summary->tt_hit_rate = rate(totals->tt_hits, totals->tt_probes);
+    summary->first_move_cutoff_rate = rate(totals->first_move_cutoffs, totals->beta_cutoffs);
+    summary->null_move_cutoff_rate = rate(totals->null_move_cutoffs, totals->null_move_tries);
+    summary->lmr_success_rate = (totals->lmr_tries > 0) ? 1.0 - rate(totals->lmr_researches, totals->lmr_tries) : 0.0;
+
+    summary->branching_factor = 0.0;
+    s32 last = summary->iteration_count - 1;
+    if (last >= 1)  summary->branching_factor = rate(iteration_nodes(summary, last), iteration_nodes(summary, last - 1));
+}
+
+void plot_search_summary(const Search_Summary *summary) {
+    TracyPlot("Search nps", (int64_t)summary->nps);
+    TracyPlot("Search TT hit rate", summary->tt_hit_rate);
+    TracyPlot("Search first move cutoffs", summary->first_move_cutoff_rate);
+    TracyPlot("Search null move cutoffs", summary->null_move_cutoff_rate);
+    TracyPlot("Search LMR success", summary->lmr_success_rate);
+    TracyPlot("Search branching factor", summary->branching_factor);
+}
+
+void write_search_summary(Json_Writer *writer, const char *key, const Search_Summary *summary) {
+    const Search_Stats *totals = &summary->totals;
+    json_begin_object(writer, key);
+    json_write_int(writer, "threads", summary->thread_count);
+    json_write_float(writer, "time_ms", (double)summary->time / 1000.0);
+    json_write_uint(writer, "nodes", totals->nodes);
+    json_write_uint(writer, "qnodes", totals->qnodes);
+    json_write_uint(writer, "nps", summary->nps);
+    json_write_uint(writer, "tt_probes", totals->tt_probes);
+    json_write_uint(writer, "tt_hits", totals->tt_hits);
+    json_write_uint(writer, "tt_cutoffs", totals->tt_cutoffs);
+    json_write_uint(writer, "beta_cutoffs", totals->beta_cutoffs);
+    json_write_uint(writer, "first_move_cutoffs", totals->first_move_cutoffs);
+    json_write_uint(writer, "null_move_tries", totals->null_move_tries);
+    json_write_uint(writer, "null_move_cutoffs", totals->null_move_cutoffs);
+    json_write_uint(writer, "lmr_tries", totals->lmr_tries);
+    json_write_uint(writer, "lmr_researches", totals->lmr_researches);
+    json_write_float(writer, "qnode_rate", summary->qnode_rate);
+    json_write_float(writer, "tt_hit_rate", summary->tt_hit_rate);
+    json_write_float(writer, "first_move_cutoff_rate", summary->first_move_cutoff_rate);
+    json_write_float(writer, "null_move_cutoff_rate", summary->null_move_cutoff_rate);
+    json_write_float(writer, "lmr_success_rate", summary->lmr_success_rate);
+    json_write_float(writer, "branching_factor", summary->branching_factor);
+
+    json_begin_array(writer, "iterations");
+    For (summary->iteration_count) {
+        const Search_Iteration *iteration = &summary->iterations[it];
+        u64 before = (it > 0) ? summary->iterations[it - 1].time : 0;
+        json_begin_object(writer, NULL);
+        json_write_int(writer, "depth", iteration->depth);
+        json_write_uint(writer, "nodes", iteration_nodes(summary, it));
+        json_write_float(writer, "time_ms", (double)(iteration->time - before) / 1000.0);
+        json_end_object(writer);
+    }
+    json_end_array(writer);
+    json_end_object(writer);
+}
+
+bool save_search_summary(const char *filepath, const Search_Summary *summary) {
+    FILE *file = fopen(filepath, "wb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Couldn't create '%s' file!\n", filepath);
+        return false;
+    }
+    Json_Writer writer;
+    json_begin(&writer, file);
+    write_search_summary(&writer, NULL, summary);
+    json_end(&writer);
+    fclose(file);
+    return true;
+}
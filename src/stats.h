@@ -0,0 +1,42 @@
+#ifndef PAWN_STATS_H
+#define PAWN_STATS_H
+
+#include "json.h"
+#include "search.h"
+
+//
+// --- Structs ---
+//
+
+// The counters of all threads of a search added up, with the rates that tuning looks at.
+struct Search_Summary {
+    s32 thread_count;
+    Search_Stats totals;
+    u64 time;                         // Microseconds, of the thread that has been searching longest.
+    u64 nps;
+
+    s32 iteration_count;              // Of the first thread.
+    Search_Iteration iterations[MAX_PLY];
+
+    double qnode_rate;                // Share of the nodes in quiescence.
+    double tt_hit_rate;
+    double first_move_cutoff_rate;    // Beta cutoffs made by the first move searched.
+    double null_move_cutoff_rate;
+    double lmr_success_rate;          // Reduced searches that didn't have to be searched again.
+    double branching_factor;          // Nodes of the last iteration over those of the one before, 0 before two.
+};
+
+//
+// --- Functions ---
+//
+
+// Any thread, while the searchers run. 'searchers[0]' is the one whose iterations are kept.
+void summarize_search(Searcher *const *searchers, s32 searcher_count, Search_Summary *out_summary);
+
+// Tracy plots of the rates and the node rate, one point per call.
+void plot_search_summary(const Search_Summary *summary);
+
+void write_search_summary(Json_Writer *writer, const char *key, const Search_Summary *summary);
+bool save_search_summary(const char *filepath, const Search_Summary *summary);
+
+#endif /* PAWN_STATS_H */
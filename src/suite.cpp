@@ -0,0 +1,455 @@
+// fopen()
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include <stdio.h>
+
+#include <atomic>
+
+#include "suite.h"
+#include "fen.h"
+#include "json.h"
+#include "mate.h"
+#include "notation.h"
+#include "platform.h"
+#include "search.h"
+
+//
+// --- Structs ---
+//
+struct Suite_Result {
+    Move best_move;
+    s32 score;
+    s32 depth;
+    bool solved;
+    s64 solution_time;    // Microseconds until the final best move was first found and kept, -1 if unsolved.
+    u64 time;
+    Search_Stats stats;
+    s32 hashfull;
+};
+
+struct Suite_Job {
+    const Suite_Options *options;
+    const Epd_File *epd;
+    Suite_Result *results;
+    std::atomic<s64> next_position;
+    std::atomic<s64> finished;
+    std::atomic<s64> solved;
+};
+
+struct Suite_Worker {
+    Suite_Job *job;
+    Transposition_Table tt;
+    Searcher *searcher;
+    const Epd_Record *record;     // Position being searched.
+    s64 solution_time;
+};
+
+struct Mate_Suite_Job {
+    const Mate_Suite_Options *options;
+    const Epd_File *epd;
+    Mate_Result *results;
+    bool *solved_flags;
+    std::atomic<s64> next_position;
+    std::atomic<s64> finished;
+    std::atomic<s64> solved;
+};
+
+struct Mate_Suite_Worker {
+    Mate_Suite_Job *job;
+    Mate_Solver *solver;
+};
+
+//
+// --- Helpers ---
+//
+
+// With 'bm' the move has to be one of them, with only 'am' it has to avoid all of them.
+static bool is_solution(const Epd_Record *record, Move move) {
+    if (record->best_move_count > 0) {
+        For (record->best_move_count) {
+            if (record->best_moves[it] == move)  return true;
+        }
+        return false;
+    }
+    if (record->avoid_move_count == 0)  return false;
+    For (record->avoid_move_count) {
+        if (record->avoid_moves[it] == move)  return false;
+    }
+    return true;
+}
+
+static void suite_report_proc(void *data, const Search_Report *report) {
+    Suite_Worker *worker = (Suite_Worker *)data;
+    if (report->bound != BOUND_EXACT || report->pv_length == 0)  return;
+
+    if (!is_solution(worker->record, report->pv[0])) {
+        worker->solution_time = -1;
+    } else if (worker->solution_time < 0) {
+        worker->solution_time = (s64)report->time;
+    }
+}
+
+static bool setup_suite_worker(void *data, s32 index, void *job_data) {
+    (void)index;
+    Suite_Worker *worker = (Suite_Worker *)data;
+    Suite_Job *job = (Suite_Job *)job_data;
+    worker->job = job;
+    if (!tt_init(&worker->tt, job->options->hash_megabytes))  return false;
+    worker->searcher = create_searcher(&worker->tt);
+    worker->searcher->report_proc = suite_report_proc;
+    worker->searcher->report_data = worker;
+    return true;
+}
+
+static void cleanup_suite_worker(void *data) {
+    Suite_Worker *worker = (Suite_Worker *)data;
+    destroy_searcher(worker->searcher);
+    tt_free(&worker->tt);
+}
+
+static void suite_worker_proc(void *data) {
+    ZoneScoped;
+
+    Suite_Worker *worker = (Suite_Worker *)data;
+    Suite_Job *job = worker->job;
+
+    Search_Limits limits = { };
+    limits.depth = job->options->depth;
+    limits.movetime = job->options->movetime;
+
+    for (;;) {
+        s64 index = job->next_position.fetch_add(1);
+        if (index >= job->epd->count)  break;
+
+        const Epd_Record *record = &job->epd->records[index];
+        tt_clear(&worker->tt);
+        clear_searcher(worker->searcher);
+        worker->record = record;
+        worker->solution_time = -1;
+
+        Search_Result search = search_position(worker->searcher, &record->position, &limits);
+
+        Suite_Result *result = &job->results[index];
+        result->best_move = search.best_move;
+        result->score = search.score;
+        result->depth = search.depth;
+        result->time = search.time;
+        result->solved = is_solution(record, search.best_move);
+        result->solution_time = -1;
+        if (result->solved)  result->solution_time = (worker->solution_time >= 0) ? worker->solution_time : (s64)search.time;
+        result->stats = worker->searcher->stats;
+        result->hashfull = tt_hashfull(&worker->tt);
+
+        s64 solved = result->solved ? job->solved.fetch_add(1) + 1 : job->solved.load();
+        s64 finished = job->finished.fetch_add(1) + 1;
+        fprintf(stderr, "\r%lld/%lld positions, %lld solved", (long long)finished, (long long)job->epd->count, (long long)solved);
+    }
+}
+
+static void write_moves(Json_Writer *writer, const char *key, const Position *pos, const Move *moves, s32 count) {
+    json_begin_array(writer, key);
+    For (count) {
+        char san[MOVE_TEXT_SIZE];
+        move_to_san(pos, moves[it], san);
+        json_write_string(writer, NULL, san);
+    }
+    json_end_array(writer);
+}
+
+static void write_report(FILE *file, const Suite_Options *options, const Epd_File *epd, const Suite_Result *results, s32 thread_count, u64 wall_time) {
+    u64 nodes = 0;
+    u64 search_time = 0;
+    u64 solution_time = 0;
+    s64 solved = 0;
+    s64 hashfull = 0;
+    Search_Stats totals = { };
+    For (epd->count) {
+        const Suite_Result *result = &results[it];
+        nodes += result->stats.nodes;
+        search_time += result->time;
+        hashfull += result->hashfull;
+        totals.tt_probes += result->stats.tt_probes;
+        totals.tt_hits += result->stats.tt_hits;
+        totals.tt_cutoffs += result->stats.tt_cutoffs;
+        if (result->solved) {
+            solved++;
+            solution_time += (u64)result->solution_time;
+        }
+    }
+
+    Json_Writer writer;
+    json_begin(&writer, file);
+    json_begin_object(&writer, NULL);
+
+    json_write_string(&writer, "suite", options->epd_filepath);
+    json_write_int(&writer, "depth", options->depth);
+    json_write_int(&writer, "movetime_ms", options->movetime);
+    json_write_int(&writer, "threads", thread_count);
+    json_write_int(&writer, "hash_mb", options->hash_megabytes);
+    json_write_int(&writer, "positions", epd->count);
+    json_write_int(&writer, "solved", solved);
+    json_write_float(&writer, "solved_percent", (epd->count > 0) ? 100.0 * (double)solved / (double)epd->count : 0.0);
+    json_write_uint(&writer, "nodes", nodes);
+    json_write_float(&writer, "wall_time_ms", (double)wall_time / 1000.0);
+    json_write_float(&writer, "search_time_ms", (double)search_time / 1000.0);
+    json_write_uint(&writer, "nps", (wall_time > 0) ? nodes * 1000000 / wall_time : 0);
+    json_write_uint(&writer, "nps_per_thread", (search_time > 0) ? nodes * 1000000 / search_time : 0);
+    json_write_float(&writer, "average_time_to_solution_ms", (solved > 0) ? (double)solution_time / 1000.0 / (double)solved : 0.0);
+
+    json_begin_object(&writer, "tt");
+    json_write_uint(&writer, "probes", totals.tt_probes);
+    json_write_uint(&writer, "hits", totals.tt_hits);
+    json_write_uint(&writer, "cutoffs", totals.tt_cutoffs);
+    json_write_float(&writer, "hit_rate", (totals.tt_probes > 0) ? (double)totals.tt_hits / (double)totals.tt_probes : 0.0);
+    json_write_float(&writer, "average_hashfull", (epd->count > 0) ? (double)hashfull / (double)epd->count : 0.0);
+    json_end_object(&writer);
+
+    json_begin_array(&writer, "results");
+    For (epd->count) {
+        const Epd_Record *record = &epd->records[it];
+        const Suite_Result *result = &results[it];
+
+        char fen[FEN_MAX_SIZE];
+        position_to_fen(&record->position, fen);
+
+        json_begin_object(&writer, NULL);
+        json_write_string(&writer, "id", record->id, record->id_size);
+        json_write_string(&writer, "fen", fen);
+        write_moves(&writer, "best_moves", &record->position, record->best_moves, record->best_move_count);
+        write_moves(&writer, "avoid_moves", &record->position, record->avoid_moves, record->avoid_move_count);
+        if (result->best_move != MOVE_NONE) {
+            char san[MOVE_TEXT_SIZE];
+            move_to_san(&record->position, result->best_move, san);
+            json_write_string(&writer, "move", san);
+        } else {
+            json_write_null(&writer, "move");
+        }
+        json_write_bool(&writer, "solved", result->solved);
+        if (result->solved)  json_write_float(&writer, "time_to_solution_ms", (double)result->solution_time / 1000.0);
+        else                 json_write_null(&writer, "time_to_solution_ms");
+        json_write_int(&writer, "score", result->score);
+        json_write_int(&writer, "depth", result->depth);
+        json_write_uint(&writer, "nodes", result->stats.nodes);
+        json_write_float(&writer, "time_ms", (double)result->time / 1000.0);
+        json_write_uint(&writer, "nps", (result->time > 0) ? result->stats.nodes * 1000000 / result->time : 0);
+        json_write_float(&writer, "tt_hit_rate", (result->stats.tt_probes > 0) ? (double)result->stats.tt_hits / (double)result->stats.tt_probes : 0.0);
+        json_write_int(&writer, "hashfull", result->hashfull);
+        json_end_object(&writer);
+    }
+    json_end_array(&writer);
+
+    json_end_object(&writer);
+    json_end(&writer);
+}
+
+static bool setup_mate_suite_worker(void *data, s32 index, void *job_data) {
+    (void)index;
+    Mate_Suite_Worker *worker = (Mate_Suite_Worker *)data;
+    Mate_Suite_Job *job = (Mate_Suite_Job *)job_data;
+    worker->job = job;
+    worker->solver = create_mate_solver(job->options->hash_megabytes);
+    return worker->solver != NULL;
+}
+
+static void cleanup_mate_suite_worker(void *data) {
+    Mate_Suite_Worker *worker = (Mate_Suite_Worker *)data;
+    if (worker->solver)  destroy_mate_solver(worker->solver);
+}
+
+static void mate_suite_worker_proc(void *data) {
+    ZoneScoped;
+
+    Mate_Suite_Worker *worker = (Mate_Suite_Worker *)data;
+    Mate_Suite_Job *job = worker->job;
+
+    for (;;) {
+        s64 index = job->next_position.fetch_add(1);
+        if (index >= job->epd->count)  break;
+
+        const Epd_Record *record = &job->epd->records[index];
+        Mate_Limits limits = { };
+        limits.moves = (record->direct_mate > 0) ? record->direct_mate : job->options->moves;
+        limits.nodes = job->options->nodes;
+        limits.movetime = job->options->movetime;
+
+        clear_mate_solver(worker->solver);
+        Mate_Result *result = &job->results[index];
+        solve_mate(worker->solver, &record->position, &limits, result);
+
+        bool solved = result->proven && result->pv_length > 0;
+        if (solved && (record->best_move_count > 0 || record->avoid_move_count > 0))  solved = is_solution(record, result->pv[0]);
+        job->solved_flags[index] = solved;
+
+        s64 solved_count = solved ? job->solved.fetch_add(1) + 1 : job->solved.load();
+        s64 finished = job->finished.fetch_add(1) + 1;
+        fprintf(stderr, "\r%lld/%lld positions, %lld solved", (long long)finished, (long long)job->epd->count, (long long)solved_count);
+    }
+}
+
+static void write_mate_report(FILE *file, const Mate_Suite_Options *options, const Epd_File *epd, const Mate_Result *results,
+                              const bool *solved_flags, s32 thread_count, u64 wall_time) {
+    u64 nodes = 0;
+    u64 solve_time = 0;
+    s64 solved = 0;
+    s64 proven = 0;
+    s64 disproven = 0;
+    For (epd->count) {
+        nodes += results[it].nodes;
+        solve_time += results[it].time;
+        if (solved_flags[it])        solved++;
+        if (results[it].proven)      proven++;
+        if (results[it].disproven)   disproven++;
+    }
+
+    Json_Writer writer;
+    json_begin(&writer, file);
+    json_begin_object(&writer, NULL);
+
+    json_write_string(&writer, "suite", options->epd_filepath);
+    json_write_int(&writer, "moves", options->moves);
+    json_write_uint(&writer, "node_limit", options->nodes);
+    json_write_int(&writer, "movetime_ms", options->movetime);
+    json_write_int(&writer, "threads", thread_count);
+    json_write_int(&writer, "hash_mb", options->hash_megabytes);
+    json_write_int(&writer, "positions", epd->count);
+    json_write_int(&writer, "solved", solved);
+    json_write_int(&writer, "proven", proven);
+    json_write_int(&writer, "disproven", disproven);
+    json_write_uint(&writer, "nodes", nodes);
+    json_write_float(&writer, "wall_time_ms", (double)wall_time / 1000.0);
+    json_write_float(&writer, "solve_time_ms", (double)solve_time / 1000.0);
+    json_write_uint(&writer, "nps", (wall_time > 0) ? nodes * 1000000 / wall_time : 0);
+
+    json_begin_array(&writer, "results");
+    For (epd->count) {
+        const Epd_Record *record = &epd->records[it];
+        const Mate_Result *result = &results[it];
+
+        char fen[FEN_MAX_SIZE];
+        position_to_fen(&record->position, fen);
+        char line[MATE_MAX_PLY * MOVE_TEXT_SIZE];
+        moves_to_san(&record->position, result->pv, result->pv_length, line);
+
+        json_begin_object(&writer, NULL);
+        json_write_string(&writer, "id", record->id, record->id_size);
+        json_write_string(&writer, "fen", fen);
+        if (record->direct_mate > 0)  json_write_int(&writer, "dm", record->direct_mate);
+        else                          json_write_null(&writer, "dm");
+        json_write_bool(&writer, "solved", solved_flags[it]);
+        json_write_bool(&writer, "proven", result->proven);
+        json_write_bool(&writer, "disproven", result->disproven);
+        json_write_bool(&writer, "shortest", result->shortest);
+        if (result->proven)  json_write_int(&writer, "mate", result->moves);
+        else                 json_write_null(&writer, "mate");
+        json_write_string(&writer, "line", line);
+        json_write_uint(&writer, "nodes", result->nodes);
+        json_write_float(&writer, "time_ms", (double)result->time / 1000.0);
+        json_write_uint(&writer, "nps", (result->time > 0) ? result->nodes * 1000000 / result->time : 0);
+        json_end_object(&writer);
+    }
+    json_end_array(&writer);
+
+    json_end_object(&writer);
+    json_end(&writer);
+}
+
+//
+// --- Interface ---
+//
+bool run_epd_suite(const Suite_Options *options) {
+    ZoneScoped;
+
+    Epd_File epd;
+    if (!load_epd_file(options->epd_filepath, &epd))  return false;
+    defer { free_epd_file(&epd); };
+
+    if (epd.count == 0) {
+        fprintf(stderr, "ERROR: No positions in '%s' suite!\n", options->epd_filepath);
+        return false;
+    }
+    if (epd.skipped_lines > 0) {
+        fprintf(stderr, "Skipped %lld blank, comment or invalid lines.\n", (long long)epd.skipped_lines);
+    }
+
+    s32 thread_count = (options->threads > 0) ? options->threads : get_cpu_count();
+    if (thread_count > epd.count)  thread_count = (s32)epd.count;
+
+    Suite_Result *results = ALLOC(sys_allocator, epd.count, Suite_Result);
+    defer { FREE(sys_allocator, results); };
+    mem_zero(results, epd.count * sizeof(Suite_Result));
+
+    Suite_Job job;
+    job.options = options;
+    job.epd = &epd;
+    job.results = results;
+    job.next_position.store(0);
+    job.finished.store(0);
+    job.solved.store(0);
+
+    Worker_Pool pool;
+    if (!create_worker_pool(&pool, thread_count, sizeof(Suite_Worker), setup_suite_worker, cleanup_suite_worker, &job))  return false;
+    defer { destroy_worker_pool(&pool); };
+
+    u64 start_time = get_time_microseconds();
+    run_worker_pool(&pool, suite_worker_proc);
+    fprintf(stderr, "\n");
+    u64 wall_time = get_time_microseconds() - start_time;
+
+    FILE *file = open_output_file(options->report_filepath, "report");
+    if (!file)  return false;
+    write_report(file, options, &epd, results, pool.count, wall_time);
+    close_output_file(file);
+    return true;
+}
+
+bool run_mate_suite(const Mate_Suite_Options *options) {
+    ZoneScoped;
+
+    Epd_File epd;
+    if (!load_epd_file(options->epd_filepath, &epd))  return false;
+    defer { free_epd_file(&epd); };
+
+    if (epd.count == 0) {
+        fprintf(stderr, "ERROR: No positions in '%s' suite!\n", options->epd_filepath);
+        return false;
+    }
+    if (epd.skipped_lines > 0) {
+        fprintf(stderr, "Skipped %lld blank, comment or invalid lines.\n", (long long)epd.skipped_lines);
+    }
+
+    s32 thread_count = (options->threads > 0) ? options->threads : get_cpu_count();
+    if (thread_count > epd.count)  thread_count = (s32)epd.count;
+
+    Mate_Result *results = ALLOC(sys_allocator, epd.count, Mate_Result);
+    bool *solved_flags = ALLOC(sys_allocator, epd.count, bool);
+    defer {
+        FREE(sys_allocator, results);
+        FREE(sys_allocator, solved_flags);
+    };
+    mem_zero(results, epd.count * sizeof(Mate_Result));
+    mem_zero(solved_flags, epd.count * sizeof(bool));
+
+    Mate_Suite_Job job;
+    job.options = options;
+    job.epd = &epd;
+    job.results = results;
+    job.solved_flags = solved_flags;
+    job.next_position.store(0);
+    job.finished.store(0);
+    job.solved.store(0);
+
+    Worker_Pool pool;
+    if (!create_worker_pool(&pool, thread_count, sizeof(Mate_Suite_Worker), setup_mate_suite_worker, cleanup_mate_suite_worker, &job))  return false;
+    defer { destroy_worker_pool(&pool); };
+
+    u64 start_time = get_time_microseconds();
+    run_worker_pool(&pool, mate_suite_worker_proc);
+    fprintf(stderr, "\n");
+    u64 wall_time = get_time_microseconds() - start_time;
+
+    FILE *file = open_output_file(options->report_filepath, "report");
+    if (!file)  return false;
+    write_mate_report(file, options, &epd, results, solved_flags, pool.count, wall_time);
+    close_output_file(file);
+    return true;
+}
@@ -0,0 +1,41 @@
+#ifndef PAWN_SUITE_H
+#define PAWN_SUITE_H
+
+#include "common.h"
+
+//
+// --- Structs ---
+//
+struct Suite_Options {
+    const char *epd_filepath;
+    const char *report_filepath;  // NULL writes the JSON report to stdout.
+    s32 depth;                    // Fixed depth per position, or 0.
+    s64 movetime;                 // Fixed milliseconds per position, or 0.
+    s32 threads;                  // Positions searched at once, each by its own engine. 0 uses every core.
+    s64 hash_megabytes;           // Per engine.
+};
+
+struct Mate_Suite_Options {
+    const char *epd_filepath;
+    const char *report_filepath;  // NULL writes the JSON report to stdout.
+    s32 moves;                    // Longest mate looked for in positions without a "dm" opcode.
+    u64 nodes;                    // Per position, 0 for no limit.
+    s64 movetime;                 // Milliseconds per position, 0 for no limit.
+    s32 threads;                  // Positions solved at once, each by its own solver. 0 uses every core.
+    s64 hash_megabytes;           // Per solver.
+};
+
+//
+// --- Functions ---
+//
+
+// Searches every position of the suite and writes a JSON report with the solved count,
+// time to solution, node rates and transposition table statistics.
+bool run_epd_suite(const Suite_Options *options);
+
+// Proves the mates of every position with the mate solver, looking for a mate in the "dm" count when
+// given, and writes a JSON report with the mate lines, node counts and times. A position is solved when
+// the mate is no longer than "dm" and starts with one of the "bm" moves, if the record has them.
+bool run_mate_suite(const Mate_Suite_Options *options);
+
+#endif /* PAWN_SUITE_H */
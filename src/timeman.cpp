@@ -0,0 +1,85 @@
+#include "timeman.h"
+
+//
+// --- Constants ---
+//
+const s32 SUDDEN_DEATH_MOVES = 40;     // Moves the rest of the clock has to last when nobody says otherwise.
+const s32 MAX_MOVES_TO_GO = 50;
+const s64 HARD_LIMIT_RATIO = 4;        // Hard limit in soft limits, with instability at its worst.
+const s32 SCORE_DROP_MARGIN = 20;      // Centipawns lost since the last iteration before extending.
+
+//
+// --- Interface ---
+//
+void start_time_manager(Time_Manager *tm, s64 time_left, s64 increment, s32 moves_to_go, s64 movetime) {
+    *tm = { };
+    tm->previous_best_move = MOVE_NONE;
+
+    if (movetime > 0) {
+        tm->active = true;
+        tm->fixed = true;
+        tm->soft_limit = (u64)movetime * 1000;
+        tm->hard_limit = tm->soft_limit;
+        return;
+    }
+    if (time_left <= 0 && increment <= 0)  return;
+    if (time_left < 0)  time_left = 0;
+
+    tm->active = true;
+    if (moves_to_go <= 0)               moves_to_go = SUDDEN_DEATH_MOVES;
+    if (moves_to_go > MAX_MOVES_TO_GO)  moves_to_go = MAX_MOVES_TO_GO;
+
+    // Every move also loses the overhead, so it is charged for each move up to the next control.
+    s64 usable = time_left - MOVE_OVERHEAD;
+    if (usable < 1)  usable = 1;
+    s64 horizon = time_left + increment * (moves_to_go - 1) - MOVE_OVERHEAD * moves_to_go;
+    s64 soft = horizon / moves_to_go;
+    if (soft < 1)  soft = 1;
+
+    // One move can take most of the clock only right before the time control.
+    s64 hard_cap = (moves_to_go == 1) ? usable * 9 / 10 : usable * 3 / 4;
+    s64 hard = soft * HARD_LIMIT_RATIO;
+    if (hard > hard_cap)  hard = hard_cap;
+    if (hard < 1)         hard = 1;
+    if (soft > hard)      soft = hard;
+
+    tm->soft_limit = (u64)soft * 1000;
+    tm->hard_limit = (u64)hard * 1000;
+}
+
+bool time_manager_done(Time_Manager *tm, s32 depth, Move best_move, s32 score, u64 elapsed) {
+    if (!tm->active)  return false;
+    if (tm->fixed)    return elapsed >= tm->hard_limit;
+
+    tm->best_move_changes *= 0.5f;
+    if (depth > 1 && best_move != tm->previous_best_move) {
+        tm->best_move_changes += 1.0f;
+        tm->stable_iterations = 0;
+    } else {
+        tm->stable_iterations++;
+    }
+
+    // Best move flipping around: spend up to twice the budget.
+    float scale = 1.0f + tm->best_move_changes;
+    if (scale > 2.0f)  scale = 2.0f;
+
+    // Score falling: keep looking for a way out.
+    if (depth > 1 && score < tm->previous_score - SCORE_DROP_MARGIN) {
+        s32 drop = tm->previous_score - score;
+        scale *= (drop >= 100) ? 1.5f : 1.0f + (float)drop / 200.0f;
+    }
+
+    // Same move for many iterations: it is clear, save the clock for later.
+    if (tm->stable_iterations >= 8)       scale *= 0.5f;
+    else if (tm->stable_iterations >= 4)  scale *= 0.75f;
+
+    tm->previous_best_move = best_move;
+    tm->previous_score = score;
+
+    u64 limit = (u64)((float)tm->soft_limit * scale);
+    if (limit > tm->hard_limit)  limit = tm->hard_limit;
+
+    // The next iteration usually takes longer than all previous ones together, so don't start one
+    // that can't finish in time.
+    return elapsed >= limit / 2;
+}
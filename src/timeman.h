@@ -0,0 +1,43 @@
+#ifndef PAWN_TIMEMAN_H
+#define PAWN_TIMEMAN_H
+
+#include "position.h"
+
+//
+// --- Constants ---
+//
+const s64 MOVE_OVERHEAD = 10;  // Milliseconds lost per move to the GUI, the pipe and the scheduler.
+
+//
+// --- Structs ---
+//
+
+// All times in microseconds, counted from the start of the search (or the ponder hit).
+// The soft limit is checked between iterations and scaled by how settled the search looks,
+// the hard limit is checked inside the search and never exceeded.
+struct Time_Manager {
+    bool active;               // Clock or fixed move time given.
+    bool fixed;                // Fixed move time: no scaling, soft == hard.
+    u64 soft_limit;
+    u64 hard_limit;
+
+    Move previous_best_move;
+    s32 previous_score;
+    s32 stable_iterations;     // Iterations in a row with the same best move.
+    float best_move_changes;   // Decays every iteration, so only recent changes count.
+};
+
+//
+// --- Functions ---
+//
+
+// 'time_left', 'increment' and 'movetime' in milliseconds, 'moves_to_go' 0 for sudden death.
+// 'movetime' wins over the clock; with neither the manager stays inactive.
+void start_time_manager(Time_Manager *tm, s64 time_left, s64 increment, s32 moves_to_go, s64 movetime);
+
+// Called after every completed iteration. True when another iteration is not worth its time.
+bool time_manager_done(Time_Manager *tm, s32 depth, Move best_move, s32 score, u64 elapsed);
+
+inline bool time_manager_out_of_time(const Time_Manager *tm, u64 elapsed) { return tm->active && elapsed >= tm->hard_limit; }
+
+#endif /* PAWN_TIMEMAN_H */
@@ -0,0 +1,436 @@
+// fopen()
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+
+#include "tournament.h"
+#include "book.h"
+#include "fen.h"
+#include "json.h"
+#include "movegen.h"
+#include "pgn.h"
+#include "platform.h"
+#include "search.h"
+
+//
+// --- Constants ---
+//
+const s32 TOURNAMENT_MAX_PLY = 1024;  // Longer games are drawn.
+
+//
+// --- Enums ---
+//
+enum Game_End {
+    END_CHECKMATE = 0,
+    END_STALEMATE = 1,
+    END_REPETITION = 2,
+    END_FIFTY_MOVES = 3,
+    END_MATERIAL = 4,
+    END_RESIGN = 5,
+    END_DRAW_ADJUDICATION = 6,
+    END_TIME = 7,
+    END_MAX_PLY = 8,
+    END_ABORTED = 9,            // The SPRT decided while the game was running; not counted.
+    GAME_END_COUNT = 10
+};
+
+static const char *GAME_END_NAMES[GAME_END_COUNT] = {
+    "checkmate", "stalemate", "repetition", "fifty_moves", "insufficient_material",
+    "resign_adjudication", "draw_adjudication", "time", "max_ply", "aborted"
+};
+
+enum Sprt_Result {
+    SPRT_RUNNING = 0,
+    SPRT_H0 = 1,                // No better than elo0.
+    SPRT_H1 = 2                 // At least elo1.
+};
+
+//
+// --- Structs ---
+//
+struct Tournament_Job {
+    const Tournament_Options *options;
+    const Epd_File *epd;        // NULL without EPD openings.
+    const Book *book;           // NULL without a book.
+    std::atomic<s64> next_game;
+    std::atomic<s64> outcomes[3];              // Wins, draws and losses of player 0.
+    std::atomic<s64> ends[GAME_END_COUNT];
+    std::atomic<u64> nodes;
+    std::atomic<s32> sprt_result;
+};
+
+// Everything a game touches, so games on different cores share nothing but the counters.
+struct Tournament_Worker {
+    Tournament_Job *job;
+    Transposition_Table tts[2];
+    Searcher *searchers[2];
+    u64 keys[TOURNAMENT_MAX_PLY + 1];           // Of every position of the game, for repetitions.
+};
+
+struct Sprt_State {
+    double score;
+    double elo;
+    double elo_error;           // 95% confidence.
+    double llr;
+    double lower_bound;
+    double upper_bound;
+};
+
+//
+// --- Helpers ---
+//
+static u64 splitmix64(u64 *state) {
+    u64 z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static double score_to_elo(double score) {
+    if (score < 0.001)  score = 0.001;
+    if (score > 0.999)  score = 0.999;
+    return -400.0 * log10(1.0 / score - 1.0);
+}
+
+static double elo_to_score(double elo) {
+    return 1.0 / (1.0 + pow(10.0, -elo / 400.0));
+}
+
+// Trinomial log-likelihood ratio in its normal approximation: with the mean score s and its variance
+// var/N, LLR = (s1 - s0) * (2s - s0 - s1) / (2 var/N).
+static void compute_sprt(const Tournament_Options *options, s64 wins, s64 draws, s64 losses, Sprt_State *out) {
+    mem_zero(out, sizeof(Sprt_State));
+    out->lower_bound = log(options->beta / (1.0 - options->alpha));
+    out->upper_bound = log((1.0 - options->beta) / options->alpha);
+
+    s64 games = wins + draws + losses;
+    if (games == 0)  return;
+
+    double n = (double)games;
+    double s = ((double)wins + 0.5 * (double)draws) / n;
+    double variance = ((double)wins * (1.0 - s) * (1.0 - s) + (double)draws * (0.5 - s) * (0.5 - s) + (double)losses * s * s) / n;
+    out->score = s;
+    out->elo = score_to_elo(s);
+    if (variance <= 0.0)  return;
+
+    double deviation = sqrt(variance / n);
+    out->elo_error = (score_to_elo(s + 1.96 * deviation) - score_to_elo(s - 1.96 * deviation)) / 2.0;
+
+    double s0 = elo_to_score(options->elo0);
+    double s1 = elo_to_score(options->elo1);
+    out->llr = (s1 - s0) * (2.0 * s - s0 - s1) / (2.0 * variance / n);
+}
+
+// The same opening for both games of a pair.
+static void get_opening(const Tournament_Job *job, s64 pair, Position *out_pos) {
+    if (job->epd) {
+        *out_pos = job->epd->records[pair % job->epd->count].position;
+        return;
+    }
+
+    set_start_position(out_pos);
+    if (!job->book)  return;
+    u64 random_state = job->options->seed ^ ((u64)pair * 0xD1B54A32D192ED03ULL);
+    For (job->options->book_plies) {
+        Move move = probe_book(job->book, out_pos, splitmix64(&random_state));
+        if (move == MOVE_NONE)  break;
+        Undo_Info undo;
+        make_move(out_pos, move, &undo);
+    }
+}
+
+static Game_Result win_for(s32 color) {
+    return (color == WHITE) ? RESULT_WHITE_WIN : RESULT_BLACK_WIN;
+}
+
+// 'white' is the index of the player with the white pieces.
+static Game_Result play_game(Tournament_Worker *worker, const Position *opening, s32 white, Game_End *out_end) {
+    ZoneScoped;
+
+    Tournament_Job *job = worker->job;
+    const Tournament_Options *options = job->options;
+
+    s64 clocks[2];
+    For (2) {
+        tt_clear(&worker->tts[it]);
+        clear_searcher(worker->searchers[it]);
+        clocks[it] = options->players[it].time;
+    }
+
+    Position pos = *opening;
+    s32 ply = 0;
+    s32 resign_count = 0;       // Plies in a row white (> 0) or black (< 0) was winning by the resign margin.
+    s32 draw_count = 0;
+    worker->keys[0] = pos.key;
+
+    for (;;) {
+        if (job->sprt_result.load(std::memory_order_relaxed) != SPRT_RUNNING) {
+            *out_end = END_ABORTED;
+            return RESULT_UNKNOWN;
+        }
+
+        s32 us = pos.side_to_move;
+        if (!has_legal_moves(&pos)) {
+            *out_end = in_check(&pos) ? END_CHECKMATE : END_STALEMATE;
+            return in_check(&pos) ? win_for(us ^ 1) : RESULT_DRAW;
+        }
+        if (pos.halfmove_clock >= FIFTY_MOVE_PLY)               { *out_end = END_FIFTY_MOVES; return RESULT_DRAW; }
+        if (is_threefold_repetition(&pos, worker->keys, ply))   { *out_end = END_REPETITION;  return RESULT_DRAW; }
+        if (is_insufficient_material(&pos))                     { *out_end = END_MATERIAL;    return RESULT_DRAW; }
+        if (ply >= TOURNAMENT_MAX_PLY)                          { *out_end = END_MAX_PLY;     return RESULT_DRAW; }
+
+        s32 player = (us == WHITE) ? white : white ^ 1;
+        const Tournament_Player *settings = &options->players[player];
+        Search_Limits limits = { };
+        limits.depth = settings->depth;
+        limits.nodes = settings->nodes;
+        limits.movetime = settings->movetime;
+        if (settings->time > 0) {
+            limits.time_left = clocks[player];
+            limits.increment = settings->increment;
+        }
+
+        u64 start_time = get_time_microseconds();
+        Search_Result result = search_position(worker->searchers[player], &pos, &limits, worker->keys, ply);
+        u64 elapsed = get_time_microseconds() - start_time;
+        job->nodes.fetch_add(result.nodes, std::memory_order_relaxed);
+
+        if (settings->time > 0) {
+            clocks[player] -= (s64)(elapsed / 1000);
+            if (clocks[player] < 0) {
+                *out_end = END_TIME;
+                return win_for(us ^ 1);
+            }
+            clocks[player] += settings->increment;
+        }
+
+        // Both engines have to agree, so the margin has to hold over twice as many plies.
+        s32 white_score = (us == WHITE) ? result.score : -result.score;
+        if (options->resign_score > 0) {
+            if (white_score >= options->resign_score)        resign_count = (resign_count > 0) ? resign_count + 1 : 1;
+            else if (white_score <= -options->resign_score)  resign_count = (resign_count < 0) ? resign_count - 1 : -1;
+            else                                             resign_count = 0;
+            if (abs(resign_count) >= 2 * options->resign_moves) {
+                *out_end = END_RESIGN;
+                return (resign_count > 0) ? RESULT_WHITE_WIN : RESULT_BLACK_WIN;
+            }
+        }
+        if (options->draw_score > 0 && ply >= options->draw_min_ply) {
+            draw_count = (abs(white_score) <= options->draw_score) ? draw_count + 1 : 0;
+            if (draw_count >= 2 * options->draw_moves) {
+                *out_end = END_DRAW_ADJUDICATION;
+                return RESULT_DRAW;
+            }
+        }
+
+        Undo_Info undo;
+        make_move(&pos, result.best_move, &undo);
+        ply++;
+        worker->keys[ply] = pos.key;
+    }
+}
+
+static void report_progress(Tournament_Job *job) {
+    s64 wins = job->outcomes[0].load();
+    s64 draws = job->outcomes[1].load();
+    s64 losses = job->outcomes[2].load();
+
+    Sprt_State sprt;
+    compute_sprt(job->options, wins, draws, losses, &sprt);
+    if (sprt.llr >= sprt.upper_bound)       job->sprt_result.store(SPRT_H1);
+    else if (sprt.llr <= sprt.lower_bound)  job->sprt_result.store(SPRT_H0);
+
+    fprintf(stderr, "\r%lld games, +%lld =%lld -%lld, Elo %+.1f +- %.1f, LLR %.2f (%.2f, %.2f)   ",
+            (long long)(wins + draws + losses), (long long)wins, (long long)draws, (long long)losses,
+            sprt.elo, sprt.elo_error, sprt.llr, sprt.lower_bound, sprt.upper_bound);
+}
+
+static bool setup_tournament_worker(void *data, s32 index, void *job_data) {
+    (void)index;
+    Tournament_Worker *worker = (Tournament_Worker *)data;
+    Tournament_Job *job = (Tournament_Job *)job_data;
+    worker->job = job;
+    for (s32 i = 0; i < 2; i++) {
+        const Tournament_Player *player = &job->options->players[i];
+        if (!tt_init(&worker->tts[i], player->hash_megabytes))  return false;
+        worker->searchers[i] = create_searcher(&worker->tts[i]);
+        worker->searchers[i]->features = SEARCH_ALL_FEATURES & ~player->disabled_features;
+    }
+    return true;
+}
+
+static void cleanup_tournament_worker(void *data) {
+    Tournament_Worker *worker = (Tournament_Worker *)data;
+    for (s32 i = 0; i < 2; i++) {
+        destroy_searcher(worker->searchers[i]);
+        tt_free(&worker->tts[i]);
+    }
+}
+
+static void tournament_worker_proc(void *data) {
+    ZoneScoped;
+
+    Tournament_Worker *worker = (Tournament_Worker *)data;
+    Tournament_Job *job = worker->job;
+
+    for (;;) {
+        s64 game = job->next_game.fetch_add(1);
+        if (game >= job->options->games)  break;
+
+        Position opening;
+        get_opening(job, game / 2, &opening);
+
+        // Player 0 has white in the first game of every pair.
+        s32 white = (s32)(game & 1);
+        Game_End end;
+        Game_Result result = play_game(worker, &opening, white, &end);
+        if (end == END_ABORTED)  break;
+
+        s32 outcome = 1;
+        if (result == RESULT_WHITE_WIN)  outcome = (white == 0) ? 0 : 2;
+        if (result == RESULT_BLACK_WIN)  outcome = (white == 0) ? 2 : 0;
+        job->outcomes[outcome].fetch_add(1);
+        job->ends[end].fetch_add(1);
+        report_progress(job);
+    }
+}
+
+static void write_player(Json_Writer *writer, const Tournament_Player *player) {
+    json_begin_object(writer, NULL);
+    json_write_string(writer, "name", player->name);
+    json_write_int(writer, "depth", player->depth);
+    json_write_uint(writer, "nodes", player->nodes);
+    json_write_int(writer, "movetime_ms", player->movetime);
+    json_write_int(writer, "time_ms", player->time);
+    json_write_int(writer, "increment_ms", player->increment);
+    json_write_int(writer, "hash_mb", player->hash_megabytes);
+    json_begin_array(writer, "disabled");
+    For (SEARCH_FEATURE_COUNT) {
+        if (player->disabled_features & (1u << it))  json_write_string(writer, NULL, search_feature_name(1u << it));
+    }
+    json_end_array(writer);
+    json_end_object(writer);
+}
+
+static void write_report(FILE *file, const Tournament_Options *options, Tournament_Job *job, s32 thread_count, u64 wall_time) {
+    s64 wins = job->outcomes[0].load();
+    s64 draws = job->outcomes[1].load();
+    s64 losses = job->outcomes[2].load();
+    s64 games = wins + draws + losses;
+    u64 nodes = job->nodes.load();
+    Sprt_State sprt;
+    compute_sprt(options, wins, draws, losses, &sprt);
+
+    Json_Writer writer;
+    json_begin(&writer, file);
+    json_begin_object(&writer, NULL);
+
+    json_begin_array(&writer, "players");
+    For (2)  write_player(&writer, &options->players[it]);
+    json_end_array(&writer);
+    json_write_string(&writer, "openings", options->epd_filepath ? options->epd_filepath : options->book_filepath);
+    json_write_int(&writer, "threads", thread_count);
+    json_write_int(&writer, "games", games);
+    json_write_int(&writer, "wins", wins);
+    json_write_int(&writer, "draws", draws);
+    json_write_int(&writer, "losses", losses);
+    json_write_float(&writer, "score", sprt.score);
+    json_write_float(&writer, "elo", sprt.elo);
+    json_write_float(&writer, "elo_error_95", sprt.elo_error);
+
+    json_begin_object(&writer, "sprt");
+    json_write_float(&writer, "elo0", options->elo0);
+    json_write_float(&writer, "elo1", options->elo1);
+    json_write_float(&writer, "alpha", options->alpha);
+    json_write_float(&writer, "beta", options->beta);
+    json_write_float(&writer, "llr", sprt.llr);
+    json_write_float(&writer, "lower_bound", sprt.lower_bound);
+    json_write_float(&writer, "upper_bound", sprt.upper_bound);
+    s32 result = job->sprt_result.load();
+    json_write_string(&writer, "result", (result == SPRT_H1) ? "H1" : (result == SPRT_H0) ? "H0" : "inconclusive");
+    json_end_object(&writer);
+
+    json_begin_object(&writer, "endings");
+    For (GAME_END_COUNT) {
+        if (it != END_ABORTED)  json_write_int(&writer, GAME_END_NAMES[it], job->ends[it].load());
+    }
+    json_end_object(&writer);
+
+    json_write_uint(&writer, "nodes", nodes);
+    json_write_float(&writer, "wall_time_ms", (double)wall_time / 1000.0);
+    json_write_uint(&writer, "nps", (wall_time > 0) ? nodes * 1000000 / wall_time : 0);
+    json_write_float(&writer, "games_per_minute", (wall_time > 0) ? (double)games * 60000000.0 / (double)wall_time : 0.0);
+
+    json_end_object(&writer);
+    json_end(&writer);
+}
+
+//
+// --- Interface ---
+//
+bool run_tournament(const Tournament_Options *options) {
+    ZoneScoped;
+
+    if (options->games <= 0) {
+        fprintf(stderr, "ERROR: No games to play!\n");
+        return false;
+    }
+    if (options->elo0 >= options->elo1 || options->alpha <= 0.0 || options->beta <= 0.0 || options->alpha + options->beta >= 1.0) {
+        fprintf(stderr, "ERROR: SPRT needs elo0 < elo1 and alpha, beta > 0!\n");
+        return false;
+    }
+
+    Epd_File epd;
+    bool has_epd = false;
+    if (options->epd_filepath) {
+        if (!load_epd_file(options->epd_filepath, &epd))  return false;
+        has_epd = true;
+        if (epd.count == 0) {
+            fprintf(stderr, "ERROR: No positions in '%s' openings!\n", options->epd_filepath);
+            free_epd_file(&epd);
+            has_epd = false;
+            return false;
+        }
+    }
+    defer { if (has_epd)  free_epd_file(&epd); };
+
+    Book book;
+    bool has_book = false;
+    if (!has_epd && options->book_filepath) {
+        if (!load_book(options->book_filepath, &book))  return false;
+        has_book = true;
+    }
+    defer { if (has_book)  free_book(&book); };
+
+    s32 thread_count = (options->threads > 0) ? options->threads : get_cpu_count();
+    if (thread_count > options->games)  thread_count = (s32)options->games;
+
+    Tournament_Job job;
+    job.options = options;
+    job.epd = has_epd ? &epd : NULL;
+    job.book = has_book ? &book : NULL;
+    job.next_game.store(0);
+    For (3)  job.outcomes[it].store(0);
+    For (GAME_END_COUNT)  job.ends[it].store(0);
+    job.nodes.store(0);
+    job.sprt_result.store(SPRT_RUNNING);
+
+    Worker_Pool pool;
+    if (!create_worker_pool(&pool, thread_count, sizeof(Tournament_Worker), setup_tournament_worker, cleanup_tournament_worker, &job))  return false;
+    defer { destroy_worker_pool(&pool); };
+
+    u64 start_time = get_time_microseconds();
+    run_worker_pool(&pool, tournament_worker_proc);
+    fprintf(stderr, "\n");
+    u64 wall_time = get_time_microseconds() - start_time;
+
+    FILE *file = open_output_file(options->report_filepath, "report");
+    if (!file)  return false;
+    write_report(file, options, &job, pool.count, wall_time);
+    close_output_file(file);
+    return true;
+}
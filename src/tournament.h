@@ -0,0 +1,54 @@
+#ifndef PAWN_TOURNAMENT_H
+#define PAWN_TOURNAMENT_H
+
+#include "common.h"
+
+//
+// --- Structs ---
+//
+
+// How one side plays. Zero fields mean "no limit", like 'Search_Limits'.
+struct Tournament_Player {
+    const char *name;
+    s32 depth;
+    u64 nodes;
+    s64 movetime;                 // Milliseconds per move.
+    s64 time;                     // Milliseconds on the clock for the whole game, or 0.
+    s64 increment;
+    s64 hash_megabytes;
+    u32 disabled_features;        // Search_Feature bits the player searches without.
+};
+
+struct Tournament_Options {
+    Tournament_Player players[2]; // [0] is tested against [1].
+    const char *epd_filepath;     // Openings, each played twice with colors swapped. NULL for none.
+    const char *book_filepath;    // Or random book lines of 'book_plies' from the start position.
+    s32 book_plies;
+    const char *report_filepath;  // NULL writes the JSON report to stdout.
+    s64 games;                    // At most; fewer when the SPRT decides first.
+    s32 threads;                  // Games played at once, each by its own pair of engines. 0 uses every core.
+    u64 seed;
+
+    // Adjudication, on the scores both engines report. 0 turns it off.
+    s32 resign_score;             // Centipawns one side is behind...
+    s32 resign_moves;             // ...for this many moves in a row, by both engines.
+    s32 draw_score;               // Both engines within this of 0...
+    s32 draw_moves;               // ...for this many moves in a row...
+    s32 draw_min_ply;             // ...starting from this ply.
+
+    // Sequential probability ratio test of elo0 against elo1, stops the tournament once one of them is accepted.
+    double elo0;
+    double elo1;
+    double alpha;
+    double beta;
+};
+
+//
+// --- Functions ---
+//
+
+// Plays engine games between the two players in parallel and writes a JSON report with the results,
+// the Elo difference and the state of the SPRT.
+bool run_tournament(const Tournament_Options *options);
+
+#endif /* PAWN_TOURNAMENT_H */
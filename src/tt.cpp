@@ -0,0 +1,236 @@
+// fopen()
+#define _CRT_SECURE_NO_WARNINGS 1
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tt.h"
+
+const char TT_SNAPSHOT_MAGIC[8] = { 'P', 'A', 'W', 'N', 'T', 'T', '0', '1' };
+static_assert(sizeof(Tt_Snapshot_Header) == 64, "Snapshot header must keep the buckets cache-line aligned.");
+
+// Layout of 'Tt_Entry::data':
+//   bits  0-15  move
+//   bits 16-31  score (s16)
+//   bits 32-47  static eval (s16)
+//   bits 48-55  depth + 1 (0 means an empty entry)
+//   bits 56-57  bound
+//   bits 58-63  generation
+static inline u64 pack_data(Move move, s32 score, s32 eval, s32 depth, s32 bound, u8 generation) {
+    return (u64)move
+         | ((u64)(u16)(s16)score << 16)
+         | ((u64)(u16)(s16)eval << 32)
+         | ((u64)(u8)(depth + 1) << 48)
+         | ((u64)(bound & 3) << 56)
+         | ((u64)(generation & 63) << 58);
+}
+
+static inline s32 data_depth(u64 data)      { return (s32)((data >> 48) & 0xFF) - 1; }
+static inline s32 data_bound(u64 data)      { return (s32)((data >> 56) & 3); }
+static inline u8 data_generation(u64 data)  { return (u8)(data >> 58); }
+static inline bool is_empty(u64 data)       { return ((data >> 48) & 0xFF) == 0; }
+
+static u64 fnv1a(u64 hash, const char *data, s64 size) {
+    for (s64 i = 0; i < size; i++)  hash = (hash ^ (u8)data[i]) * 1099511628211ULL;
+    return hash;
+}
+
+// The whole executable, so any rebuild invalidates old snapshots, and the Zobrist keys, which can be
+// loaded from a file at startup.
+static u64 engine_version_hash() {
+    static u64 version_hash = 0;
+    if (version_hash != 0)  return version_hash;
+
+    u64 hash = 14695981039346656037ULL;
+    char path[1024];
+    Mapped_File executable;
+    if (get_executable_path(path, sizeof(path)) && map_file(path, &executable)) {
+        hash = fnv1a(hash, executable.data, executable.size);
+        unmap_file(&executable);
+    } else {
+        const char *build = __DATE__ " " __TIME__;
+        hash = fnv1a(hash, build, (s64)strlen(build));
+    }
+
+    Position start;
+    set_start_position(&start);
+    version_hash = hash ^ start.key;
+    return version_hash;
+}
+
+bool tt_init(Transposition_Table *tt, s64 megabytes) {
+    ZoneScoped;
+
+    if (megabytes < 1)  megabytes = 1;
+    u64 bucket_count = 1;
+    while (bucket_count * 2 * sizeof(Tt_Bucket) <= (u64)megabytes * 1024 * 1024)  bucket_count *= 2;
+
+    Tt_Bucket *buckets = ALLOC(sys_allocator, (s64)bucket_count, Tt_Bucket);
+    if (!buckets) {
+        fprintf(stderr, "ERROR: Couldn't allocate %lld MB for the transposition table!\n", (long long)megabytes);
+        return false;
+    }
+
+    tt->buckets = buckets;
+    tt->bucket_count = bucket_count;
+    tt->snapshot = { };
+    tt_clear(tt);
+    return true;
+}
+
+void tt_free(Transposition_Table *tt) {
+    if (tt->snapshot.data)     unmap_file(&tt->snapshot);
+    else if (tt->buckets)      FREE(sys_allocator, tt->buckets);
+    tt->buckets = NULL;
+    tt->bucket_count = 0;
+}
+
+void tt_clear(Transposition_Table *tt) {
+    ZoneScoped;
+
+    mem_zero(tt->buckets, (s64)(tt->bucket_count * sizeof(Tt_Bucket)));
+    tt->generation = 0;
+}
+
+void tt_new_search(Transposition_Table *tt) {
+    tt->generation = (u8)((tt->generation + 1) & 63);
+}
+
+bool tt_probe(const Transposition_Table *tt, u64 key, Tt_Data *out_data) {
+    const Tt_Bucket *bucket = tt_bucket(tt, key);
+    For (TT_BUCKET_ENTRIES) {
+        u64 data = bucket->entries[it].data;
+        if ((bucket->entries[it].key ^ data) != key || is_empty(data))  continue;
+
+        out_data->move = (Move)(data & 0xFFFF);
+        out_data->score = (s16)(u16)(data >> 16);
+        out_data->eval = (s16)(u16)(data >> 32);
+        out_data->depth = data_depth(data);
+        out_data->bound = data_bound(data);
+        return true;
+    }
+    return false;
+}
+
+void tt_store(Transposition_Table *tt, u64 key, Move move, s32 score, s32 eval, s32 depth, s32 bound) {
+    Tt_Bucket *bucket = tt_bucket(tt, key);
+
+    // Same position first, then the entry that is oldest and shallowest.
+    Tt_Entry *replace = &bucket->entries[0];
+    s32 replace_worth = 1 << 30;
+    For (TT_BUCKET_ENTRIES) {
+        Tt_Entry *entry = &bucket->entries[it];
+        u64 data = entry->data;
+        if ((entry->key ^ data) == key) {
+            replace = entry;
+            // Keep the old move when the new search didn't find one.
+            if (move == MOVE_NONE)  move = (Move)(data & 0xFFFF);
+            // A much shallower bound from this search doesn't replace a deeper result.
+            if (bound != BOUND_EXACT && data_generation(data) == tt->generation && data_depth(data) > depth + 3)  return;
+            break;
+        }
+
+        s32 age = (tt->generation - data_generation(data)) & 63;
+        s32 worth = data_depth(data) - 8 * age;
+        if (worth < replace_worth) {
+            replace_worth = worth;
+            replace = entry;
+        }
+    }
+
+    if (depth < -1)  depth = -1;
+    if (depth > 254)  depth = 254;
+    u64 data = pack_data(move, score, eval, depth, bound, tt->generation);
+    replace->key = key ^ data;
+    replace->data = data;
+}
+
+s32 tt_hashfull(const Transposition_Table *tt) {
+    s32 count = 0;
+    s32 samples = 0;
+    for (u64 i = 0; i < 250 && i < tt->bucket_count; i++) {
+        For (TT_BUCKET_ENTRIES) {
+            u64 data = tt->buckets[i].entries[it].data;
+            if (!is_empty(data) && data_generation(data) == tt->generation)  count++;
+            samples++;
+        }
+    }
+    return (samples > 0) ? count * 1000 / samples : 0;
+}
+
+// Moves the buckets of a table loaded from a snapshot into memory of its own and lets go of the file.
+static void detach_snapshot(Transposition_Table *tt) {
+    Tt_Bucket *buckets = ALLOC(sys_allocator, (s64)tt->bucket_count, Tt_Bucket);
+    memcpy(buckets, tt->buckets, (size_t)(tt->bucket_count * sizeof(Tt_Bucket)));
+    unmap_file(&tt->snapshot);
+    tt->snapshot = { };
+    tt->buckets = buckets;
+}
+
+bool tt_save(Transposition_Table *tt, const char *filepath) {
+    ZoneScoped;
+
+    // Written next to the old snapshot and swapped in at the end, so a failed write doesn't lose it.
+    char temp_filepath[1024];
+    snprintf(temp_filepath, sizeof(temp_filepath), "%s.tmp", filepath);
+    FILE *file = fopen(temp_filepath, "wb");
+    if (!file) {
+        fprintf(stderr, "ERROR: Couldn't create '%s' file!\n", temp_filepath);
+        return false;
+    }
+
+    Tt_Snapshot_Header header;
+    mem_zero(&header, sizeof(header));
+    memcpy(header.magic, TT_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version_hash = engine_version_hash();
+    header.bucket_count = tt->bucket_count;
+    header.generation = tt->generation;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1
+           && fwrite(tt->buckets, sizeof(Tt_Bucket), (size_t)tt->bucket_count, file) == (size_t)tt->bucket_count;
+    if (fclose(file) != 0)  ok = false;
+    if (!ok) {
+        fprintf(stderr, "ERROR: Couldn't write '%s' transposition table snapshot!\n", temp_filepath);
+        delete_file(temp_filepath);
+        return false;
+    }
+
+    // A mapped snapshot keeps its file open, and Windows won't replace an open file.
+    if (tt->snapshot.data)  detach_snapshot(tt);
+    if (!replace_file(temp_filepath, filepath)) {
+        fprintf(stderr, "ERROR: Couldn't replace '%s' transposition table snapshot!\n", filepath);
+        delete_file(temp_filepath);
+        return false;
+    }
+    return true;
+}
+
+bool tt_load(Transposition_Table *tt, const char *filepath) {
+    ZoneScoped;
+
+    Mapped_File file;
+    if (!map_file(filepath, &file, true))  return false;
+
+    const Tt_Snapshot_Header *header = (const Tt_Snapshot_Header *)file.data;
+    bool valid = file.size >= (s64)sizeof(Tt_Snapshot_Header)
+              && memcmp(header->magic, TT_SNAPSHOT_MAGIC, sizeof(header->magic)) == 0
+              && header->bucket_count > 0 && (header->bucket_count & (header->bucket_count - 1)) == 0
+              && (u64)file.size == sizeof(Tt_Snapshot_Header) + header->bucket_count * sizeof(Tt_Bucket);
+    if (!valid) {
+        fprintf(stderr, "ERROR: '%s' is not a transposition table snapshot!\n", filepath);
+        unmap_file(&file);
+        return false;
+    }
+    if (header->version_hash != engine_version_hash()) {
+        fprintf(stderr, "ERROR: '%s' was written by another engine version!\n", filepath);
+        unmap_file(&file);
+        return false;
+    }
+
+    tt_free(tt);
+    tt->buckets = (Tt_Bucket *)(file.data + sizeof(Tt_Snapshot_Header));
+    tt->bucket_count = header->bucket_count;
+    tt->generation = header->generation;
+    tt->snapshot = file;
+    return true;
+}
@@ -0,0 +1,93 @@
+#ifndef PAWN_TT_H
+#define PAWN_TT_H
+
+#include <xmmintrin.h> // _mm_prefetch()
+
+#include "platform.h"
+#include "position.h"
+
+//
+// --- Enums ---
+//
+enum Tt_Bound {
+    BOUND_NONE = 0,
+    BOUND_UPPER = 1,  // Fail low: score is at most this.
+    BOUND_LOWER = 2,  // Fail high: score is at least this.
+    BOUND_EXACT = BOUND_UPPER | BOUND_LOWER
+};
+
+//
+// --- Structs ---
+//
+
+// 'key' is stored XORed with 'data', so an entry torn by two threads writing at once
+// fails verification instead of returning another position's data.
+struct Tt_Entry {
+    u64 key;
+    u64 data;
+};
+
+const int TT_BUCKET_ENTRIES = 4;
+
+struct Tt_Bucket {
+    Tt_Entry entries[TT_BUCKET_ENTRIES]; // 64 bytes, one cache line.
+};
+
+struct Tt_Data {
+    Move move;
+    s32 score;            // Mate scores are relative to the probing node, see 'score_from_tt()'.
+    s32 eval;
+    s32 depth;
+    s32 bound;
+};
+
+struct Transposition_Table {
+    Tt_Bucket *buckets;
+    u64 bucket_count;     // Power of two.
+    u8 generation;        // Bumped every search, older entries are replaced first.
+    Mapped_File snapshot; // Holds 'buckets' after 'tt_load()'.
+};
+
+// Start of a snapshot file, followed by the buckets. 64 bytes so the mapped buckets stay cache-line aligned.
+struct Tt_Snapshot_Header {
+    char magic[8];
+    u64 version_hash;     // Of the engine that wrote it; another search or evaluation can't use its entries.
+    u64 bucket_count;
+    u8 generation;
+    u8 padding[39];
+};
+
+//
+// --- Functions ---
+//
+bool tt_init(Transposition_Table *tt, s64 megabytes);
+void tt_free(Transposition_Table *tt);
+void tt_clear(Transposition_Table *tt);
+void tt_new_search(Transposition_Table *tt);
+
+// Safe to call from several threads sharing one table.
+bool tt_probe(const Transposition_Table *tt, u64 key, Tt_Data *out_data);
+void tt_store(Transposition_Table *tt, u64 key, Move move, s32 score, s32 eval, s32 depth, s32 bound);
+
+// Per mille of sampled entries written during the current search, as reported by UCI 'hashfull'.
+s32 tt_hashfull(const Transposition_Table *tt);
+
+// Writes the table to 'filepath' for a warm restart, replacing the old snapshot only once the new one is
+// complete. A table loaded from a snapshot is copied out of it first. Not while a search uses the table.
+bool tt_save(Transposition_Table *tt, const char *filepath);
+// Replaces the table with a snapshot, mapped copy-on-write, so pages come in from the file as the
+// search touches them. The table takes the snapshot's size. False, table unchanged, if the file is
+// damaged or from another engine version.
+bool tt_load(Transposition_Table *tt, const char *filepath);
+
+inline Tt_Bucket *tt_bucket(const Transposition_Table *tt, u64 key) {
+    return &tt->buckets[key & (tt->bucket_count - 1)];
+}
+
+// Starts loading the bucket of 'key' into the cache without waiting for it. On large tables the probe
+// is mostly a miss to memory, so the search asks for the child's bucket before making the move.
+inline void tt_prefetch(const Transposition_Table *tt, u64 key) {
+    _mm_prefetch((const char *)tt_bucket(tt, key), _MM_HINT_T0);
+}
+
+#endif /* PAWN_TT_H */
@@ -0,0 +1,529 @@
+// Headless UCI front-end, built as its own executable (pawn_uci) without GLFW or OpenGL.
+// The main thread reads and parses commands, a separate thread runs each search, so 'stop'
+// and 'isready' are answered while searching.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mutex>
+
+#include "bench.h"
+#include "fen.h"
+#include "mcts.h"
+#include "movegen.h"
+#include "notation.h"
+#include "platform.h"
+#include "search.h"
+#include "stats.h"
+
+//
+// --- Constants ---
+//
+const char *UCI_ENGINE_NAME = "pawn";
+const char *UCI_ENGINE_AUTHOR = "the pawn authors";
+
+const int UCI_LINE_SIZE = 64 * 1024;   // "position startpos moves ..." of a long game fits easily.
+const int UCI_MAX_THREADS = 256;
+const s64 UCI_DEFAULT_HASH = 16;
+const s64 UCI_MAX_HASH = 64 * 1024;
+const int UCI_PATH_SIZE = 1024;
+
+//
+// --- Structs ---
+//
+struct Uci_Engine {
+    Transposition_Table tt;
+    s64 hash_megabytes;
+    char hash_filepath[UCI_PATH_SIZE];     // Snapshot for 'SaveHash' and 'LoadHash', empty for none.
+    Searcher *searchers[UCI_MAX_THREADS]; // [0] reports and decides, the rest are helpers sharing the table.
+    s32 thread_count;
+    Mcts *mcts;                            // "Algorithm" MCTS, searching instead with a pool of "Hash" size. NULL for alpha-beta.
+    Mcts_Leaf_Policy mcts_leaf_policy;
+    s32 multi_pv;
+    u32 search_features;                   // Search_Feature bits of the check options named after them.
+
+    Position position;
+    s32 game_key_count;                    // Positions since the last capture or pawn move, for repetitions.
+    u64 game_keys[FIFTY_MOVE_PLY];
+    Search_Limits limits;
+    Thread search_thread;
+    bool searching;                        // A search thread exists and hasn't been joined yet.
+};
+
+struct Uci_Helper {
+    Uci_Engine *engine;
+    s32 index;
+};
+
+//
+// --- Helpers ---
+//
+
+// Returns the next whitespace-separated token and advances 'cursor', NULL at the end of the line.
+static const char *next_token(const char **cursor, s32 *out_size) {
+    const char *c = *cursor;
+    while (*c == ' ' || *c == '\t')  c++;
+    if (*c == '\0' || *c == '\n' || *c == '\r') {
+        *cursor = c;
+        return NULL;
+    }
+    const char *token = c;
+    while (*c != '\0' && *c != ' ' && *c != '\t' && *c != '\n' && *c != '\r')  c++;
+    *cursor = c;
+    *out_size = (s32)(c - token);
+    return token;
+}
+
+static bool token_is(const char *token, s32 size, const char *text) {
+    return token && (s32)strlen(text) == size && memcmp(token, text, size) == 0;
+}
+
+// Option names are case-insensitive.
+static bool name_is(const char *token, s32 size, const char *text) {
+    if ((s32)strlen(text) != size)  return false;
+    For (size) {
+        char c = token[it];
+        if (c >= 'A' && c <= 'Z')  c += 'a' - 'A';
+        if (c != text[it])  return false;
+    }
+    return true;
+}
+
+static s64 next_number(const char **cursor) {
+    s32 size;
+    const char *token = next_token(cursor, &size);
+    return token ? atoll(token) : 0;
+}
+
+// Every write to stdout holds it: the search thread prints 'info' and 'bestmove' while the input thread
+// answers 'readyok' and 'stats'.
+static std::mutex stdout_mutex;
+
+// Whole lines only.
+static void send(const char *text) {
+    std::lock_guard<std::mutex> lock(stdout_mutex);
+    fputs(text, stdout);
+    fflush(stdout);
+}
+
+static s32 write_score(char *buffer, s32 score) {
+    if (!is_mate_score(score))  return sprintf(buffer, "cp %d", score);
+    return sprintf(buffer, "mate %d", mate_in_moves(score));
+}
+
+static s32 hashfull(const Uci_Engine *engine) {
+    if (engine->mcts)  return mcts_hashfull(engine->mcts);
+    return tt_hashfull(&engine->tt);
+}
+
+//
+// --- Search thread ---
+//
+static void uci_report_proc(void *data, const Search_Report *report) {
+    Uci_Engine *engine = (Uci_Engine *)data;
+
+    char line[256 + MAX_PLY * MOVE_TEXT_SIZE];
+    s32 size = sprintf(line, "info depth %d seldepth %d multipv %d score ", report->depth, report->seldepth, report->multi_pv);
+    size += write_score(line + size, report->score);
+    if (report->bound == BOUND_LOWER)  size += sprintf(line + size, " lowerbound");
+    if (report->bound == BOUND_UPPER)  size += sprintf(line + size, " upperbound");
+    u64 nps = (report->time > 0) ? report->nodes * 1000000 / report->time : 0;
+    size += sprintf(line + size, " nodes %llu nps %llu time %llu hashfull %d pv",
+                    (unsigned long long)report->nodes, (unsigned long long)nps, (unsigned long long)(report->time / 1000), hashfull(engine));
+    For (report->pv_length) {
+        line[size++] = ' ';
+        size += move_to_uci(report->pv[it], line + size);
+    }
+    line[size++] = '\n';
+    line[size] = '\0';
+    send(line);
+
+    if (!engine->mcts) {
+        Search_Summary summary;
+        summarize_search(engine->searchers, engine->thread_count, &summary);
+        plot_search_summary(&summary);
+    }
+}
+
+static void helper_thread_proc(void *data) {
+    Uci_Helper *helper = (Uci_Helper *)data;
+    Search_Limits limits = { };
+    limits.infinite = true;
+    Uci_Engine *engine = helper->engine;
+    search_position(engine->searchers[helper->index], &engine->position, &limits, engine->game_keys, engine->game_key_count);
+}
+
+// Tree parallelism: every thread walks the one tree, the virtual losses keep them on different lines.
+static Search_Result run_mcts(Uci_Engine *engine) {
+    Mcts *mcts = engine->mcts;
+    mcts->thread_count = engine->thread_count;
+    mcts->leaf_policy = engine->mcts_leaf_policy;
+    Search_Result result = mcts_search(mcts, &engine->position, &engine->limits, engine->game_keys, engine->game_key_count);
+    while ((engine->limits.infinite || is_mcts_pondering(mcts)) && !mcts->stop.load(std::memory_order_relaxed)) {
+        sleep_milliseconds(1);
+    }
+    return result;
+}
+
+static Search_Result run_alpha_beta(Uci_Engine *engine) {
+    Searcher *main_searcher = engine->searchers[0];
+
+    // Lazy SMP: helpers search the same position and only share what they find through the table.
+    Uci_Helper helpers[UCI_MAX_THREADS];
+    Thread threads[UCI_MAX_THREADS];
+    for (s32 i = 1; i < engine->thread_count; i++) {
+        helpers[i].engine = engine;
+        helpers[i].index = i;
+        threads[i] = create_thread(helper_thread_proc, &helpers[i]);
+    }
+
+    Search_Result result = search_position(main_searcher, &engine->position, &engine->limits, engine->game_keys, engine->game_key_count);
+
+    // The protocol wants 'bestmove' only after 'stop' (or 'ponderhit') in these modes, even when the search ended early.
+    while ((engine->limits.infinite || is_pondering(main_searcher)) && !main_searcher->stop.load(std::memory_order_relaxed)) {
+        sleep_milliseconds(1);
+    }
+
+    for (s32 i = 1; i < engine->thread_count; i++) {
+        stop_search(engine->searchers[i]);
+        join_thread(&threads[i]);
+    }
+    return result;
+}
+
+static void search_thread_proc(void *data) {
+    ZoneScoped;
+
+    Uci_Engine *engine = (Uci_Engine *)data;
+    Search_Result result = engine->mcts ? run_mcts(engine) : run_alpha_beta(engine);
+
+    char line[64];
+    char best[MOVE_TEXT_SIZE];
+    char ponder[MOVE_TEXT_SIZE];
+    if (result.best_move == MOVE_NONE) {
+        sprintf(line, "bestmove 0000\n");
+    } else if (result.ponder_move != MOVE_NONE) {
+        move_to_uci(result.best_move, best);
+        move_to_uci(result.ponder_move, ponder);
+        sprintf(line, "bestmove %s ponder %s\n", best, ponder);
+    } else {
+        move_to_uci(result.best_move, best);
+        sprintf(line, "bestmove %s\n", best);
+    }
+    send(line);
+}
+
+//
+// --- Engine state ---
+//
+static void stop_searching(Uci_Engine *engine) {
+    For (engine->thread_count)  stop_search(engine->searchers[it]);
+    if (engine->mcts)  stop_mcts(engine->mcts);
+}
+
+// Commands that change the engine state end a running search first.
+static void wait_for_search(Uci_Engine *engine) {
+    if (!engine->searching)  return;
+    stop_searching(engine);
+    join_thread(&engine->search_thread);
+    engine->searching = false;
+}
+
+static void create_searchers(Uci_Engine *engine, s32 thread_count) {
+    For (engine->thread_count)  destroy_searcher(engine->searchers[it]);
+    engine->thread_count = thread_count;
+    For (engine->thread_count) {
+        engine->searchers[it] = create_searcher(&engine->tt);
+        engine->searchers[it]->thread_index = it;
+        engine->searchers[it]->features = engine->search_features;
+    }
+    engine->searchers[0]->report_proc = uci_report_proc;
+    engine->searchers[0]->report_data = engine;
+}
+
+static Mcts *create_tree(Uci_Engine *engine, s64 megabytes) {
+    Mcts *mcts = create_mcts(megabytes);
+    if (mcts) {
+        mcts->report_proc = uci_report_proc;
+        mcts->report_data = engine;
+    }
+    return mcts;
+}
+
+static bool resize_hash(Uci_Engine *engine, s64 megabytes) {
+    if (engine->mcts) {
+        destroy_mcts(engine->mcts);
+        engine->mcts = create_tree(engine, megabytes);
+        if (engine->mcts) {
+            engine->hash_megabytes = megabytes;
+            return true;
+        }
+        engine->mcts = create_tree(engine, engine->hash_megabytes);
+        return false;
+    }
+
+    tt_free(&engine->tt);
+    if (tt_init(&engine->tt, megabytes)) {
+        engine->hash_megabytes = megabytes;
+        return true;
+    }
+    // Fall back to the previous size rather than running without a table.
+    return tt_init(&engine->tt, engine->hash_megabytes);
+}
+
+// The tree search keeps its pool only while it is selected; the table stays for switching back.
+static void select_algorithm(Uci_Engine *engine, bool mcts) {
+    if (mcts && !engine->mcts) {
+        engine->mcts = create_tree(engine, engine->hash_megabytes);
+    } else if (!mcts && engine->mcts) {
+        destroy_mcts(engine->mcts);
+        engine->mcts = NULL;
+    }
+}
+
+//
+// --- Commands ---
+//
+static void uci_command() {
+    char line[1024];
+    sprintf(line,
+            "id name %s\n"
+            "id author %s\n"
+            "option name Hash type spin default %lld min 1 max %lld\n"
+            "option name Threads type spin default 1 min 1 max %d\n"
+            "option name Ponder type check default false\n"
+            "option name MultiPV type spin default 1 min 1 max %d\n"
+            "option name HashFile type string default <empty>\n"
+            "option name SaveHash type button\n"
+            "option name LoadHash type button\n"
+            "option name Algorithm type combo default AlphaBeta var AlphaBeta var MCTS\n"
+            "option name MCTSLeaf type combo default Eval var Eval var Playout\n",
+            UCI_ENGINE_NAME, UCI_ENGINE_AUTHOR, (long long)UCI_DEFAULT_HASH, (long long)UCI_MAX_HASH, UCI_MAX_THREADS, MAX_MULTI_PV);
+    send(line);
+
+    // One switch per part of the selective search, for testing them against each other.
+    For (SEARCH_FEATURE_COUNT) {
+        sprintf(line, "option name %s type check default true\n", search_feature_name(1u << it));
+        send(line);
+    }
+    send("uciok\n");
+}
+
+// "setoption name <name> [value <value>]", buttons have no value.
+static void setoption_command(Uci_Engine *engine, const char *cursor) {
+    s32 size;
+    const char *token = next_token(&cursor, &size);
+    if (!token_is(token, size, "name"))  return;
+
+    const char *name = next_token(&cursor, &size);
+    if (!name)  return;
+    s32 name_size = size;
+
+    // The rest of the line, for string values with spaces.
+    const char *text = "";
+    s32 text_size = 0;
+    token = next_token(&cursor, &size);
+    if (token_is(token, size, "value")) {
+        while (*cursor == ' ' || *cursor == '\t')  cursor++;
+        text = cursor;
+        while (text[text_size] != '\0' && text[text_size] != '\n' && text[text_size] != '\r')  text_size++;
+        while (text_size > 0 && (text[text_size - 1] == ' ' || text[text_size - 1] == '\t'))  text_size--;
+    }
+    s64 value = atoll(text);
+    u32 feature = search_feature_from_name(name, name_size);
+
+    wait_for_search(engine);
+    if (name_is(name, name_size, "hash")) {
+        if (value < 1)             value = 1;
+        if (value > UCI_MAX_HASH)  value = UCI_MAX_HASH;
+        if (!resize_hash(engine, value))  fprintf(stderr, "ERROR: Couldn't allocate %lld MB hash table!\n", (long long)value);
+    } else if (name_is(name, name_size, "threads")) {
+        if (value < 1)                value = 1;
+        if (value > UCI_MAX_THREADS)  value = UCI_MAX_THREADS;
+        create_searchers(engine, (s32)value);
+    } else if (name_is(name, name_size, "multipv")) {
+        if (value < 1)             value = 1;
+        if (value > MAX_MULTI_PV)  value = MAX_MULTI_PV;
+        engine->multi_pv = (s32)value;
+    } else if (name_is(name, name_size, "hashfile")) {
+        if (token_is(text, text_size, "<empty>"))  text_size = 0;
+        if (text_size >= UCI_PATH_SIZE)  text_size = UCI_PATH_SIZE - 1;
+        memcpy(engine->hash_filepath, text, text_size);
+        engine->hash_filepath[text_size] = '\0';
+    } else if (name_is(name, name_size, "algorithm")) {
+        select_algorithm(engine, name_is(text, text_size, "mcts"));
+    } else if (name_is(name, name_size, "mctsleaf")) {
+        engine->mcts_leaf_policy = name_is(text, text_size, "playout") ? MCTS_LEAF_PLAYOUT : MCTS_LEAF_EVAL;
+    } else if (feature) {
+        if (name_is(text, text_size, "true"))  engine->search_features |= feature;
+        else                                   engine->search_features &= ~feature;
+        For (engine->thread_count)  engine->searchers[it]->features = engine->search_features;
+    } else if (name_is(name, name_size, "savehash")) {
+        if (engine->hash_filepath[0])  tt_save(&engine->tt, engine->hash_filepath);
+    } else if (name_is(name, name_size, "loadhash")) {
+        if (engine->hash_filepath[0] && tt_load(&engine->tt, engine->hash_filepath)) {
+            engine->hash_megabytes = (s64)(engine->tt.bucket_count * sizeof(Tt_Bucket) / (1024 * 1024));
+        }
+    }
+}
+
+// "position [startpos | fen <fen>] [moves <move>...]"
+static void position_command(Uci_Engine *engine, const char *cursor) {
+    wait_for_search(engine);
+
+    s32 size;
+    const char *token = next_token(&cursor, &size);
+    Position pos;
+    if (token_is(token, size, "startpos")) {
+        set_start_position(&pos);
+    } else if (token_is(token, size, "fen")) {
+        const char *end = cursor + strlen(cursor);
+        cursor = parse_fen(&pos, cursor, end);
+        if (!cursor) {
+            fprintf(stderr, "ERROR: Invalid FEN in 'position' command!\n");
+            return;
+        }
+    } else {
+        return;
+    }
+
+    engine->game_key_count = 0;
+    token = next_token(&cursor, &size);
+    if (token_is(token, size, "moves")) {
+        while ((token = next_token(&cursor, &size)) != NULL) {
+            Move move = parse_uci_move(&pos, token, size);
+            if (move == MOVE_NONE) {
+                fprintf(stderr, "ERROR: Illegal move '%.*s' in 'position' command!\n", size, token);
+                break;
+            }
+            Undo_Info undo;
+            make_move(&pos, move, &undo);
+
+            // A capture or pawn move makes every earlier position unreachable.
+            if (pos.halfmove_clock == 0) {
+                engine->game_key_count = 0;
+            } else if (engine->game_key_count == FIFTY_MOVE_PLY) {
+                For (FIFTY_MOVE_PLY - 1)  engine->game_keys[it] = engine->game_keys[it + 1];
+                engine->game_keys[FIFTY_MOVE_PLY - 1] = undo.key;
+            } else {
+                engine->game_keys[engine->game_key_count++] = undo.key;
+            }
+        }
+    }
+    engine->position = pos;
+}
+
+static void go_command(Uci_Engine *engine, const char *cursor) {
+    wait_for_search(engine);
+
+    Search_Limits limits = { };
+    bool ponder = false;
+    s64 time[2] = { };
+    s64 increment[2] = { };
+    s32 moves_to_go = 0;
+
+    s32 size;
+    const char *token;
+    while ((token = next_token(&cursor, &size)) != NULL) {
+        if      (token_is(token, size, "depth"))      limits.depth = (s32)next_number(&cursor);
+        else if (token_is(token, size, "nodes"))      limits.nodes = (u64)next_number(&cursor);
+        else if (token_is(token, size, "movetime"))   limits.movetime = next_number(&cursor);
+        else if (token_is(token, size, "wtime"))      time[WHITE] = next_number(&cursor);
+        else if (token_is(token, size, "btime"))      time[BLACK] = next_number(&cursor);
+        else if (token_is(token, size, "winc"))       increment[WHITE] = next_number(&cursor);
+        else if (token_is(token, size, "binc"))       increment[BLACK] = next_number(&cursor);
+        else if (token_is(token, size, "movestogo"))  moves_to_go = (s32)next_number(&cursor);
+        else if (token_is(token, size, "infinite"))   limits.infinite = true;
+        else if (token_is(token, size, "ponder"))     ponder = true;
+    }
+
+    s32 us = engine->position.side_to_move;
+    limits.time_left = time[us];
+    limits.increment = increment[us];
+    limits.moves_to_go = moves_to_go;
+    limits.multi_pv = engine->multi_pv;
+    engine->limits = limits;
+
+    For (engine->thread_count)  clear_stop_request(engine->searchers[it]);
+    if (engine->mcts)  clear_mcts_stop_request(engine->mcts);
+    if (ponder)  start_pondering(engine->searchers[0]);
+    if (ponder && engine->mcts)  start_mcts_pondering(engine->mcts);
+    engine->search_thread = create_thread(search_thread_proc, engine);
+    engine->searching = true;
+}
+
+//
+// --- Main ---
+//
+int main(int arguments_count, char **arguments) {
+    ZoneScoped;
+
+    init_chess();
+    if (arguments_count >= 3 && strcmp(arguments[1], "--keys") == 0) {
+        if (!load_zobrist_keys(arguments[2]))  return EXIT_FAILURE;
+    }
+    // "pawn_uci bench [depth]": the node signature of the build, for testing frameworks.
+    if (arguments_count >= 2 && strcmp(arguments[1], "bench") == 0) {
+        s32 depth = (arguments_count >= 3) ? atoi(arguments[2]) : BENCH_DEFAULT_DEPTH;
+        if (depth <= 0)  depth = BENCH_DEFAULT_DEPTH;
+        return run_bench(depth, BENCH_DEFAULT_HASH) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    Uci_Engine *engine = ALLOC(sys_allocator, 1, Uci_Engine);
+    mem_zero(engine, sizeof(Uci_Engine));
+    defer { FREE(sys_allocator, engine); };
+
+    if (!tt_init(&engine->tt, UCI_DEFAULT_HASH))  return EXIT_FAILURE;
+    engine->hash_megabytes = UCI_DEFAULT_HASH;
+    engine->search_features = SEARCH_ALL_FEATURES;
+    create_searchers(engine, 1);
+    set_start_position(&engine->position);
+
+    char *line = ALLOC(sys_allocator, UCI_LINE_SIZE, char);
+    defer { FREE(sys_allocator, line); };
+
+    while (fgets(line, UCI_LINE_SIZE, stdin)) {
+        const char *cursor = line;
+        s32 size;
+        const char *command = next_token(&cursor, &size);
+        if (!command)  continue;
+
+        if (token_is(command, size, "uci")) {
+            uci_command();
+        } else if (token_is(command, size, "isready")) {
+            send("readyok\n");
+        } else if (token_is(command, size, "setoption")) {
+            setoption_command(engine, cursor);
+        } else if (token_is(command, size, "ucinewgame")) {
+            wait_for_search(engine);
+            tt_clear(&engine->tt);
+            For (engine->thread_count)  clear_searcher(engine->searchers[it]);
+        } else if (token_is(command, size, "position")) {
+            position_command(engine, cursor);
+        } else if (token_is(command, size, "go")) {
+            go_command(engine, cursor);
+        } else if (token_is(command, size, "stop")) {
+            stop_searching(engine);
+        } else if (token_is(command, size, "ponderhit")) {
+            ponder_hit(engine->searchers[0]);
+            if (engine->mcts)  mcts_ponder_hit(engine->mcts);
+        } else if (token_is(command, size, "stats")) {
+            // Not UCI: the counters of the running or last alpha-beta search, as JSON.
+            Search_Summary summary;
+            summarize_search(engine->searchers, engine->thread_count, &summary);
+            std::lock_guard<std::mutex> lock(stdout_mutex);
+            Json_Writer writer;
+            json_begin(&writer, stdout);
+            write_search_summary(&writer, NULL, &summary);
+            json_end(&writer);
+        } else if (token_is(command, size, "quit")) {
+            break;
+        }
+    }
+
+    wait_for_search(engine);
+    For (engine->thread_count)  destroy_searcher(engine->searchers[it]);
+    if (engine->mcts)  destroy_mcts(engine->mcts);
+    tt_free(&engine->tt);
+    return EXIT_SUCCESS;
+}